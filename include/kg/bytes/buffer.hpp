@@ -253,6 +253,7 @@ public:
         std::size_t count;
         BOOST_FOREACH(const fragmentation_spt& f,_fragmentations)
         {
+            need_skip = 0;
             if(skip)
             {
                 need_skip = skip;
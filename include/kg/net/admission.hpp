@@ -0,0 +1,170 @@
+#ifndef KG_NET_ADMISSION_HEADER_HPP
+#define KG_NET_ADMISSION_HEADER_HPP
+
+#include <chrono>
+
+#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/typeof/typeof.hpp>
+
+#include "types.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 令牌桶
+*
+*	令牌 以 rate 每秒 的 速度 補充 最多 積累 burst 個\n
+*	非線程安全
+*/
+class token_bucket_t
+{
+private:
+	double _rate;
+	double _burst;
+	double _tokens;
+	std::chrono::steady_clock::time_point _last;
+
+	void refill()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		_tokens += std::chrono::duration<double>(now - _last).count() * _rate;
+		if(_tokens > _burst)
+		{
+			_tokens = _burst;
+		}
+		_last = now;
+	}
+public:
+	/**
+	*	\param rate	每秒 補充的 令牌數 必須 大於0
+	*	\param burst	最多 積累的 令牌數 爲0 使用 rate
+	*/
+	token_bucket_t(std::size_t rate,std::size_t burst)
+		:_rate(double(rate)),_burst(double(burst ? burst : rate)),
+		_last(std::chrono::steady_clock::now())
+	{
+		_tokens = _burst;
+	}
+	/**
+	*	\brief 如果 有 n 個 令牌 則 取走 並 返回 true
+	*
+	*/
+	bool take(std::size_t n = 1)
+	{
+		refill();
+		if(_tokens < double(n))
+		{
+			return false;
+		}
+		_tokens -= double(n);
+		return true;
+	}
+	/**
+	*	\brief 取走 n 個 令牌 允許 透支
+	*
+	*	\return 令牌 回到 非負 需要 等待的 時間
+	*/
+	std::chrono::microseconds consume(std::size_t n)
+	{
+		refill();
+		_tokens -= double(n);
+		return wait(0);
+	}
+	/**
+	*	\brief 返回 積累到 n 個 令牌 需要 等待的 時間
+	*
+	*/
+	std::chrono::microseconds wait(std::size_t n)const
+	{
+		double need = double(n) - _tokens;
+		if(need <= 0)
+		{
+			return std::chrono::microseconds(0);
+		}
+		return std::chrono::microseconds(kg::uint64_t(need / _rate * 1000000.0) + 1);
+	}
+};
+
+/**
+*	\brief ip 地址 的 hash
+*
+*/
+class address_hash_t
+{
+public:
+	std::size_t operator()(const boost::asio::ip::address& address)const
+	{
+		if(address.is_v4())
+		{
+			return boost::hash_value(address.to_v4().to_uint());
+		}
+		boost::asio::ip::address_v6::bytes_type bytes = address.to_v6().to_bytes();
+		return boost::hash_range(bytes.begin(),bytes.end());
+	}
+};
+
+/**
+*	\brief 限制 每個 來源 ip 的 連接數
+*
+*	線程安全
+*/
+class peer_limit_t
+	: boost::noncopyable
+{
+private:
+	boost::mutex _mutex;
+	boost::unordered_map<boost::asio::ip::address,std::size_t,address_hash_t> _peers;
+	std::size_t _max;
+public:
+	/**
+	*	\param max	每個 ip 最多 連接數
+	*/
+	explicit peer_limit_t(std::size_t max)
+		:_max(max)
+	{
+	}
+	/**
+	*	\brief 爲 address 增加 一個 連接
+	*
+	*	\exception std::bad_alloc
+	*	\return 已達 上限 時 返回 false 且 不增加
+	*/
+	bool acquire(const boost::asio::ip::address& address)
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		std::size_t& n = _peers[address];
+		if(n >= _max)
+		{
+			return false;
+		}
+		++n;
+		return true;
+	}
+	/**
+	*	\brief 爲 address 減少 一個 連接
+	*
+	*/
+	void release(const boost::asio::ip::address& address)
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		BOOST_AUTO(find,_peers.find(address));
+		if(find == _peers.end())
+		{
+			return;
+		}
+		if(find->second < 2)
+		{
+			_peers.erase(find);
+		}
+		else
+		{
+			--find->second;
+		}
+	}
+};
+};
+};
+#endif	//KG_NET_ADMISSION_HEADER_HPP
@@ -0,0 +1,58 @@
+#ifndef KG_NET_AFFINITY_HEADER_HPP
+#define KG_NET_AFFINITY_HEADER_HPP
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef KG_NET_USE_NUMA
+#include <numa.h>
+#endif
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 將 當前線程 綁定到 指定 cpu
+*
+*	目前 只在 linux 下 有效 其它平臺 直接 返回 false
+*
+*	\param cpu	cpu 編號
+*	\return 是否 綁定 成功
+*/
+inline bool pin_thread(int cpu)
+{
+#if defined(__linux__)
+	if(cpu < 0 || cpu >= CPU_SETSIZE)
+	{
+		return false;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu,&set);
+	return pthread_setaffinity_np(pthread_self(),sizeof(set),&set) == 0;
+#else
+	return false;
+#endif
+}
+
+/**
+*	\brief 使 當前線程 之後 申請的 內存 優先 位於 其所在 numa 節點
+*
+*	定義 KG_NET_USE_NUMA 時 使用 libnuma 設置 本地分配 策略 (需要 鏈接 -lnuma)\n
+*	否則 依賴 os 默認的 first-touch 策略 只要 在 綁定後的 線程中 申請並初始化 內存 即可
+*/
+inline void numa_local()
+{
+#ifdef KG_NET_USE_NUMA
+	if(numa_available() != -1)
+	{
+		numa_set_localalloc();
+	}
+#endif
+}
+};
+};
+#endif	//KG_NET_AFFINITY_HEADER_HPP
@@ -0,0 +1,450 @@
+#ifndef KG_NET_ASYNC_CLIENT_HEADER_HPP
+#define KG_NET_ASYNC_CLIENT_HEADER_HPP
+
+#include <vector>
+#include <climits>
+
+#include <boost/typeof/typeof.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/array.hpp>
+#include <boost/asio/spawn.hpp>
+
+#include "types.hpp"
+#include "socket_options.hpp"
+#include "local.hpp"
+#include "connection.hpp"
+#include "framer.hpp"
+#include "stage.hpp"
+#include "receive_buffer.hpp"
+
+namespace kg
+{
+namespace net
+{
+
+#define KG_NET_ASYNC_CLIENT_CODE_BAD_ALLOC		1
+#define KG_NET_ASYNC_CLIENT_CODE_BAD_ADDR		100
+#define KG_NET_ASYNC_CLIENT_CODE_BAD_MSG_HEADER	200
+#define KG_NET_ASYNC_CLIENT_CODE_BAD_MSG	201
+#define KG_NET_ASYNC_CLIENT_CODE_POOL_STOPPED	300
+/**
+*	\brief async_client_t client_pool_t 異常定義
+*
+*/
+class async_client_category :
+    public boost::system::error_category
+{
+public:
+    virtual const char *name() const BOOST_SYSTEM_NOEXCEPT
+    {
+        return "kg::net::async_client : ";
+    }
+    virtual std::string message(int ev) const
+    {
+    	std::string msg("kg::net::async_client : ");
+        switch(ev)
+        {
+        case 0:
+            return msg + "success";
+		case KG_NET_ASYNC_CLIENT_CODE_BAD_ALLOC:
+            return msg + "bad alloc";
+        case KG_NET_ASYNC_CLIENT_CODE_BAD_ADDR:
+            return msg + "bad address";
+		case KG_NET_ASYNC_CLIENT_CODE_BAD_MSG_HEADER:
+			return msg + "bad msg header";
+		case KG_NET_ASYNC_CLIENT_CODE_BAD_MSG:
+			return msg + "bad msg";
+		case KG_NET_ASYNC_CLIENT_CODE_POOL_STOPPED:
+			return msg + "pool stopped";
+        }
+        return msg + "unknow";
+    }
+    static async_client_category& get()
+    {
+    	static async_client_category instance;
+    	return instance;
+    }
+};
+
+/**
+*	\brief 運行在 共享 io_service 上 的 協程 tcp client
+*
+*	所有 io 函數 需要 在 協程 中 以 yield_context 調用 等待 時 讓出 線程\n
+*	消息 由 framer 分幀 (默認 u32 大端 長度前綴) 收發 的 是 經 stage 解碼/編碼 的 消息體\n
+*	同一時間 只能 有 一個 協程 讀 與 一個 協程 寫 io 出錯 後 連接 不再 可用 (healthy 返回 false)\n
+*	send 可在 任意線程 調用 經 connection_t 發送隊列 合併 寫出 不要 與 write 混用\n
+*	socket 與 發送隊列 的 io 都在 strand 上 完成 與 send 並發的 讀取 wait_writable 與 close 需要 運行在 strand 的 協程 上
+*
+*	\code
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx){
+		kg::net::async_client_t c(service);
+		c.connect("127.0.0.1:1102",ctx);
+		kg::net::async_client_t::bytes_t b = c.request(data,n,ctx);
+	});
+	\endcode
+*/
+class async_client_t
+    : boost::noncopyable
+{
+public:
+	/**
+	*	\brief type_t type_spt
+	*
+	*/
+    KG_TYPEDEF_TT(async_client_t);
+
+	typedef kg::slice_t<kg::byte_t> bytes_t;
+private:
+	strand_t _strand;
+	connection_spt _connection;
+	socket_t& _socket;
+	framer_t _framer;
+	std::vector<stage_spt> _stages;
+	//所有 stage 編碼 最多 增加的 頭部 字節數
+	std::size_t _headroom;
+	socket_options_t _options;
+	receive_buffer_t _buffer;
+	bool _broken;
+public:
+	/**
+	*	\param service	共享的 io_service
+	*	\param framer	分幀 規則 需要 是 長度前綴
+	*/
+	explicit async_client_t(io_service_t& service,const framer_t& framer = framer_t::length(4))
+		:_strand(boost::asio::make_strand(service)),_connection(boost::make_shared<connection_t>(_strand)),_socket(*_connection),
+		_framer(framer),_headroom(0),_broken(false)
+	{
+	}
+	~async_client_t()
+	{
+		boost::system::error_code ec;
+		close(ec);
+	}
+	/**
+	*	\brief 返回原始 socket
+	*
+	*/
+	inline socket_t& get()
+	{
+		return _socket;
+	}
+	/**
+	*	\brief 返回 socket 與 發送隊列 使用的 strand
+	*
+	*/
+	inline const strand_t& strand()const
+	{
+		return _strand;
+	}
+	/**
+	*	\brief 設置 socket 選項 在 之後的 connect 中 生效
+	*
+	*/
+	inline void options(const socket_options_t& options)
+	{
+		_options = options;
+	}
+	/**
+	*	\brief 加入 消息 處理 階段 需要 與 服務器 順序 一致
+	*
+	*	stage 可以 被 多個 client 共享
+	*
+	*	\exception std::bad_alloc
+	*/
+	inline void stage(stage_spt stage)
+	{
+		_stages.push_back(stage);
+		_headroom += stage->headroom();
+	}
+
+	/**
+	*	\brief 連接服務器 unix 域 socket 同步 連接
+	*
+	*	\exception boost::system::system_error
+	*	\param addr	服務器地址 host:port 或 unix:/path
+	*/
+	void connect(const std::string& addr,const boost::asio::yield_context& ctx)
+	{
+		std::string path;
+		if(is_local_address(addr,path))
+		{
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+			connect_local(_socket,path);
+			_socket.non_blocking(true);
+			return;
+#else
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_BAD_ADDR,async_client_category::get()));
+#endif // BOOST_ASIO_HAS_LOCAL_SOCKETS
+		}
+
+		//解析地址
+		BOOST_AUTO(find,addr.find_last_of(':'));
+		if(find == std::string::npos)
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_BAD_ADDR,async_client_category::get()));
+		}
+		unsigned short port = 0;
+		try
+		{
+			port = boost::lexical_cast<unsigned short>(addr.substr(find+1));
+		}
+		catch(const boost::bad_lexical_cast&)
+		{
+		}
+		boost::system::error_code ec;
+		boost::asio::ip::address ip = boost::asio::ip::address::from_string(addr.substr(0,find),ec);
+		if(port == 0 || ec)
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_BAD_ADDR,async_client_category::get()));
+		}
+
+		//connect yield
+		_socket.async_connect(endpoint_t(ip,port),ctx);
+		_options.apply(_socket);
+		//同步 io 只用於 健康 檢查
+		_socket.non_blocking(true);
+	}
+	/**
+	*	\brief 連接服務器
+	*
+	*/
+	void connect(const std::string& addr,const boost::asio::yield_context& ctx,boost::system::error_code& ec)
+	{
+		try
+		{
+			connect(addr,ctx);
+		}
+		catch(const boost::system::system_error& e)
+		{
+			ec = e.code();
+		}
+	}
+	/**
+	*	\brief 關閉 socket
+	*
+	*/
+	void close(boost::system::error_code& ec)
+	{
+		_broken = true;
+		_socket.shutdown(socket_t::shutdown_both,ec);
+		_socket.close(ec);
+	}
+	/**
+	*	\brief 返回 連接 是否 可以 繼續 使用
+	*
+	*	io 未 出錯 沒有 未讀取的 數據 且 對端 未 關閉 也沒有 發來 未請求的 數據
+	*/
+	bool healthy()
+	{
+		if(_broken || !_socket.is_open() || _buffer.size())
+		{
+			return false;
+		}
+		kg::byte_t b;
+		boost::system::error_code ec;
+		_socket.receive(boost::asio::buffer(&b,1),socket_t::message_peek,ec);
+		return ec == boost::asio::error::would_block;
+	}
+
+	/**
+	*	\brief 將 消息體 編碼爲 一幀 並 完整 寫入
+	*
+	*	\exception boost::system::system_error
+	*/
+	void write(const kg::byte_t* b,std::size_t n,const boost::asio::yield_context& ctx)
+	{
+		try
+		{
+			//沒有 owner 的 視圖 不會 被 原地 修改 幀頭 與 消息體 分開 寫入 無需 拷貝
+			view_t view(const_cast<kg::byte_t*>(b),n);
+			encode(view,0);
+			kg::byte_t header[KG_NET_FRAMER_PEEK_MAX];
+			boost::array<boost::asio::const_buffer,2> buffers = {{
+				boost::asio::buffer(header,_framer.encode(header,view.size)),
+				boost::asio::buffer(view.data,view.size)
+			}};
+			boost::asio::async_write(_socket,buffers,ctx);
+		}
+		catch(...)
+		{
+			_broken = true;
+			throw;
+		}
+	}
+	/**
+	*	\brief 將 prefix 與 b 合併爲 消息體 編碼爲 一幀 加入 發送隊列
+	*
+	*	線程安全 只 拷貝 一次 (經 stage 原地 編碼 幀頭 寫在 同一 緩衝區)
+	*
+	*	\exception boost::system::system_error
+	*	\return 連接 已 出錯 或 超過 發送隊列 高水位 時 返回 false 可 wait_writable 後 重試
+	*/
+	bool send(const kg::byte_t* prefix,std::size_t np,const kg::byte_t* b,std::size_t n)
+	{
+		view_t view;
+		const std::size_t headroom = KG_NET_FRAMER_PEEK_MAX + _headroom;
+		try
+		{
+			view.reset(headroom,np + n);
+		}
+		catch(const std::bad_alloc&)
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_BAD_ALLOC,async_client_category::get()));
+		}
+		std::memcpy(view.data,prefix,np);
+		std::memcpy(view.data + np,b,n);
+		encode(view,KG_NET_FRAMER_PEEK_MAX);
+
+		const std::size_t header = _framer.header_size(view.size);
+		if(!view.writable(header))
+		{
+			view_t out;
+			try
+			{
+				out.reset(header,view.size);
+			}
+			catch(const std::bad_alloc&)
+			{
+				BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_BAD_ALLOC,async_client_category::get()));
+			}
+			std::memcpy(out.data,view.data,view.size);
+			view = out;
+		}
+		_framer.encode(view.data - header,view.size);
+		//與 owner 共享 引用計數 從 幀頭 開始 發送
+		return _connection->send(boost::shared_array<kg::byte_t>(view.owner,view.data - header),header + view.size);
+	}
+	/**
+	*	\brief 掛起 協程 直到 發送隊列 回落到 低水位
+	*
+	*	只能在 strand 的 協程中 調用
+	*
+	*	\exception boost::system::system_error 連接 寫出 出錯
+	*/
+	inline void wait_writable(const boost::asio::yield_context& ctx)
+	{
+		_connection->wait_writable(ctx);
+	}
+	/**
+	*	\brief 讀取 一個 消息 返回 經 stage 解碼 的 消息體
+	*
+	*	原地 解碼 的 消息體 引用 接收 緩衝區 不拷貝
+	*
+	*	\exception boost::system::system_error
+	*/
+	bytes_t read(const boost::asio::yield_context& ctx)
+	{
+		try
+		{
+			frame_t frame;
+			while(true)
+			{
+				int rs = _framer.decode(_buffer.data(),_buffer.size(),frame);
+				if(rs == KG_NET_FRAME_ERROR || (rs == KG_NET_FRAME_OK && frame.size > std::size_t(INT_MAX)))
+				{
+					BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_BAD_MSG_HEADER,async_client_category::get()));
+				}
+				if(rs == KG_NET_FRAME_OK && _buffer.size() >= frame.size)
+				{
+					break;
+				}
+				//已知 幀長 時 一次 準備 整幀 的 空間
+				std::size_t need = rs == KG_NET_FRAME_OK ? frame.size - _buffer.size() : 0;
+				std::size_t n = _socket.async_read_some(_buffer.prepare(need),ctx);
+				_buffer.commit(n);
+			}
+			bytes_t msg = _buffer.slice(frame.size);
+			return decode(msg.range(frame.header,frame.header + frame.body));
+		}
+		catch(const std::bad_alloc&)
+		{
+			_broken = true;
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_BAD_ALLOC,async_client_category::get()));
+		}
+		catch(...)
+		{
+			_broken = true;
+			throw;
+		}
+	}
+	/**
+	*	\brief 讀取 一個 消息
+	*
+	*/
+	bytes_t read(const boost::asio::yield_context& ctx,boost::system::error_code& ec)
+	{
+		try
+		{
+			return read(ctx);
+		}
+		catch(const boost::system::system_error& e)
+		{
+			ec = e.code();
+		}
+		return bytes_t();
+	}
+	/**
+	*	\brief 寫入 請求 並 讀取 響應
+	*
+	*	\exception boost::system::system_error
+	*/
+	inline bytes_t request(const kg::byte_t* b,std::size_t n,const boost::asio::yield_context& ctx)
+	{
+		write(b,n,ctx);
+		return read(ctx);
+	}
+private:
+	//依次 反向 調用 stage 編碼 結果 之前 保留 headroom 字節
+	void encode(view_t& view,std::size_t headroom)
+	{
+		try
+		{
+			std::size_t stages = _headroom;
+			for(std::size_t i=_stages.size();i>0;--i)
+			{
+				stages -= _stages[i - 1]->headroom();
+				if(!_stages[i - 1]->encode(view,headroom ? headroom + stages : 0))
+				{
+					BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_BAD_MSG,async_client_category::get()));
+				}
+			}
+		}
+		catch(const std::bad_alloc&)
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_BAD_ALLOC,async_client_category::get()));
+		}
+		if(!_framer.peek() || !_framer.fits(view.size))
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_BAD_MSG_HEADER,async_client_category::get()));
+		}
+	}
+	bytes_t decode(const bytes_t& body)
+	{
+		if(_stages.empty())
+		{
+			return body;
+		}
+		view_t view(body.get(),body.size());
+		for(std::size_t i=0;i<_stages.size();++i)
+		{
+			if(!_stages[i]->decode(view))
+			{
+				BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_BAD_MSG,async_client_category::get()));
+			}
+		}
+		//原地 解碼 時 返回 引用 body 的 切片
+		if(!view.owner)
+		{
+			std::size_t offset = view.data - body.get();
+			return body.range(offset,offset + view.size);
+		}
+		bytes_t out(view.size);
+		std::memcpy(out.get(),view.data,view.size);
+		return out;
+	}
+};
+typedef async_client_t::type_spt async_client_spt;
+
+};
+};
+#endif // KG_NET_ASYNC_CLIENT_HEADER_HPP
@@ -2,13 +2,25 @@
 #define KG_NET_BASIC_SERVER_HEADER_HPP
 
 #include <boost/asio/spawn.hpp>
+#include <boost/coroutine/stack_traits.hpp>
 #include <boost/typeof/typeof.hpp>
 #include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
-#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/atomic.hpp>
 
 
 #include "types.hpp"
+#include "buffer_pool.hpp"
+#include "connection.hpp"
+#include "metrics.hpp"
+#include "affinity.hpp"
+#include "task_pool.hpp"
+#include "socket_options.hpp"
+#include "local.hpp"
+#include "admission.hpp"
+#include "mailbox.hpp"
+#include "session_table.hpp"
 //#include "../debug.hpp"
 
 
@@ -20,6 +32,21 @@ namespace net
 #define KG_NET_BASIC_SERVER_BUFFER_SIZE	1024
 #endif // KG_NET_BASIC_SERVER_BUFFER_SIZE
 
+#ifndef KG_NET_BASIC_SERVER_BUFFER_MAX_SIZE
+#define KG_NET_BASIC_SERVER_BUFFER_MAX_SIZE	(64 * 1024)
+#endif // KG_NET_BASIC_SERVER_BUFFER_MAX_SIZE
+
+#ifndef KG_NET_BASIC_SERVER_BUFFER_CACHE
+#define KG_NET_BASIC_SERVER_BUFFER_CACHE	128
+#endif // KG_NET_BASIC_SERVER_BUFFER_CACHE
+
+/**
+*	\brief 連接 id 中 響應服務器 序號 的 位移
+*
+*	連接 id 高 16 位 爲 響應服務器 序號 低 48 位 爲 響應服務器 內 遞增 序列
+*/
+#define KG_NET_CONNECTION_ID_SHIFT	48
+
 #define KG_NET_BASIC_SERVER_CODE_BAD_ALLOC	1
 #define KG_NET_BASIC_SERVER_CODE_BAD_ADDR	100
 /**
@@ -55,12 +82,238 @@ public:
     }
 };
 
+/**
+*	\brief basic_server_t 可選 設定
+*
+*/
+class basic_server_options_t
+{
+public:
+	/**
+	*	\brief 連接 讀取緩衝區 最小值 (字節)
+	*
+	*	每個連接 以此 大小開始 讀取 讀滿 緩衝區 時 加倍 直到 read_buffer_max
+	*/
+	std::size_t read_buffer_min;
+	/**
+	*	\brief 連接 讀取緩衝區 最大值 (字節)
+	*
+	*/
+	std::size_t read_buffer_max;
+	/**
+	*	\brief 每個 響應服務器 每級 最多 緩存的 空閒緩衝區 數量
+	*
+	*/
+	std::size_t read_buffer_cache;
+	/**
+	*	\brief 等待數據時 是否 將 緩衝區 歸還 內存池
+	*
+	*	爲 true 時 連接 先等待 socket 可讀 再從 內存池 取出 緩衝區 讀取\n
+	*	readed 回調 返回後 立刻 歸還 如此 空閒的 連接 不佔用 任何 緩衝區
+	*/
+	bool read_buffer_release;
+
+	/**
+	*	\brief 連接 協程 棧大小 (字節) 爲0 使用 boost::coroutines 默認值
+	*
+	*	小於 boost::coroutines::stack_traits::minimum_size() 時 使用 最小值
+	*/
+	std::size_t stack_size;
+	/**
+	*	\brief 每個 響應服務器 最多 保留的 空閒協程 數量 爲0 不保留
+	*
+	*	連接 斷開後 其 協程 不退出 而是 掛起等待 分配到 此響應服務器的 下個連接\n
+	*	如此 協程棧 在連接間 重用 避免 連接/斷開 風暴時 反覆 申請釋放 棧內存\n
+	*	\note boost::asio::spawn 不支持 自定義 棧分配器 故 棧 依然由 boost::coroutines 默認分配器 申請
+	*/
+	std::size_t stack_pool;
+
+	/**
+	*	\brief 連接 發送隊列 高水位 (字節)
+	*
+	*	\see connection_t::watermarks
+	*/
+	std::size_t write_high_watermark;
+	/**
+	*	\brief 連接 發送隊列 低水位 (字節)
+	*
+	*	\see connection_t::watermarks
+	*/
+	std::size_t write_low_watermark;
+
+	/**
+	*	\brief 是否 將 每個 響應服務器 線程 綁定到 一個 cpu
+	*
+	*	綁定後 響應服務器的 內存池 緩衝區 協程棧 都在 其線程中 申請 從而 位於 本地 numa 節點\n
+	*	定義 KG_NET_USE_NUMA 時 還會 使用 libnuma 顯式 設置 本地分配 策略
+	*/
+	bool pin_threads;
+	/**
+	*	\brief 響應服務器 線程 綁定的 cpu 列表
+	*
+	*	第 i 個 響應服務器 綁定到 cpus[i % cpus.size()] 爲空時 綁定到 cpu i
+	*/
+	std::vector<int> cpus;
+
+	/**
+	*	\brief 響應服務器 數量 (線程數) 爲0 使用 cpu 數
+	*
+	*/
+	std::size_t threads;
+	/**
+	*	\brief 阻塞任務 線程池 線程數 爲0 不創建 線程池
+	*
+	*	\see basic_server_t::tasks
+	*/
+	std::size_t blocking_threads;
+	/**
+	*	\brief 阻塞任務 線程池 最多 等待/執行中 的 任務數 爲0 不限制
+	*
+	*/
+	std::size_t blocking_max;
+
+	/**
+	*	\brief 監聽 socket 及 每個 accept 的 連接 的 socket 選項
+	*
+	*	監聽 unix 域 socket 時 只有 backlog recv_buffer send_buffer 生效
+	*/
+	socket_options_t socket;
+
+	/**
+	*	\brief 最多 同時 連接數 爲0 不限制
+	*
+	*	超過的 連接 在 accept 後 立刻 關閉 不會 爲其 創建 協程
+	*/
+	std::size_t max_connections;
+	/**
+	*	\brief 每個 來源 ip 最多 同時 連接數 爲0 不限制 (unix 域 socket 不限制)
+	*
+	*/
+	std::size_t max_connections_per_ip;
+	/**
+	*	\brief 每秒 最多 accept 的 連接數 爲0 不限制
+	*
+	*	令牌 用盡時 暫停 accept 新連接 留在 內核 listen 隊列 中
+	*/
+	std::size_t accept_rate;
+	/**
+	*	\brief accept 令牌桶 容量 爲0 使用 accept_rate
+	*
+	*/
+	std::size_t accept_burst;
+	/**
+	*	\brief 每個 連接 每秒 最多 讀取的 字節數 爲0 不限制
+	*
+	*	超過時 連接 協程 暫停 讀取 直到 令牌 補充 由 tcp 流控 反壓 對端
+	*/
+	std::size_t read_rate;
+	/**
+	*	\brief 讀取 令牌桶 容量 (字節) 爲0 使用 read_rate
+	*
+	*/
+	std::size_t read_burst;
+
+	/**
+	*	\brief 連接 查找表 分片數 爲0 使用 64
+	*
+	*	find 只對 分片 做 原子計數 分片 越多 併發 查找 越少 爭用 同一 cache line
+	*/
+	std::size_t session_shards;
+
+	basic_server_options_t()
+		:read_buffer_min(KG_NET_BASIC_SERVER_BUFFER_SIZE),
+		read_buffer_max(KG_NET_BASIC_SERVER_BUFFER_MAX_SIZE),
+		read_buffer_cache(KG_NET_BASIC_SERVER_BUFFER_CACHE),
+		read_buffer_release(false),
+		stack_size(0),
+		stack_pool(0),
+		write_high_watermark(KG_NET_CONNECTION_HIGH_WATERMARK),
+		write_low_watermark(KG_NET_CONNECTION_LOW_WATERMARK),
+		pin_threads(false),
+		threads(0),
+		blocking_threads(0),
+		blocking_max(0),
+		max_connections(0),
+		max_connections_per_ip(0),
+		accept_rate(0),
+		accept_burst(0),
+		read_rate(0),
+		read_burst(0),
+		session_shards(0)
+	{
+	}
+};
+
+/**
+*	\brief basic_server_t 默認的 回調 處理器 以 boost::function 保存 回調
+*
+*	自定義 處理器 只需 提供 相同 簽名的 connected closed readed 成員函數\n
+*	basic_server_t 直接 調用 它們 (靜態 分派 可被 內聯) 而不經過 boost::function 的 間接調用
+*
+*	\code
+class handler_t
+{
+public:
+	bool connected(const kg::net::connection_spt& s,session_t& session,const boost::asio::yield_context& ctx);
+	void closed(const kg::net::connection_spt& s,session_t& session,const boost::asio::yield_context& ctx);
+	bool readed(const kg::net::connection_spt& s,session_t& session,kg::byte_t* b,std::size_t n,const boost::asio::yield_context& ctx);
+};
+kg::net::basic_server_t<session_t,handler_t> s(laddr,poll,timeout);
+*	\endcode
+*
+*	\param T	session 型別
+*/
+template<typename T>
+class basic_function_handler_t
+{
+public:
+	typedef T session_t;
+	/**
+	*	\brief 定義 連接建立後 回調
+	*
+	*	\return 返回 false 將 自動斷開 連接  並調用 closed 回調
+	*/
+	typedef boost::function<bool(const connection_spt&,session_t&,const boost::asio::yield_context&)> connected_bft;
+	/**
+	*	\brief 定義 連接斷開後 回調
+	*
+	*/
+	typedef boost::function<void(const connection_spt&,session_t&,const boost::asio::yield_context&)> closed_bft;
+	/**
+	*	\brief 定義 讀取到數據後 回調
+	*
+	*	\return 返回 false 將 自動斷開 連接  並調用 closed 回調
+	*/
+	typedef boost::function<bool(const connection_spt&,session_t&,kg::byte_t*,std::size_t n,const boost::asio::yield_context&)> readed_bft;
+
+	connected_bft on_connected;
+	closed_bft on_closed;
+	readed_bft on_readed;
+
+	inline bool connected(const connection_spt& s,session_t& session,const boost::asio::yield_context& ctx)
+	{
+		return !on_connected || on_connected(s,session,ctx);
+	}
+	inline void closed(const connection_spt& s,session_t& session,const boost::asio::yield_context& ctx)
+	{
+		if(on_closed)
+		{
+			on_closed(s,session,ctx);
+		}
+	}
+	inline bool readed(const connection_spt& s,session_t& session,kg::byte_t* b,std::size_t n,const boost::asio::yield_context& ctx)
+	{
+		return !on_readed || on_readed(s,session,b,n,ctx);
+	}
+};
+
 /**
 *	\brief 使用 boost::asio 協程 實現的 tcp 服務器
 *
 *	\param T	用於關聯到 連接 的 自定義 session 型別 需要支持 copy 語義
+*	\param Handler	回調 處理器 型別 \see basic_function_handler_t
 */
-template<typename T>
+template<typename T,typename Handler = basic_function_handler_t<T> >
 class basic_server_t
     : boost::noncopyable
 {
@@ -80,36 +333,80 @@ private:
     io_service_spt _service;
     acceptor_spt _acceptor;
 
+    //掛起 等待 新連接的 空閒協程
+    class worker_t: boost::noncopyable
+    {
+	public:
+		//喚醒 定時器
+		deadline_timer_t timer;
+		//分配到的 連接 喚醒時 爲空 表示 退出
+		connection_spt sock;
+
+		explicit worker_t(io_service_t& service)
+			:timer(service)
+		{
+		}
+    };
+
+    //響應服務器 上的 連接
+    class client_t
+    {
+	public:
+		connection_spt sock;
+		//connected 回調 成功 前 爲 NULL
+		session_t* session;
+		//是否 正在 等待 數據 (未在 執行 回調)
+		bool* idle;
+    };
+    typedef boost::unordered_map<kg::uint64_t,client_t> client_map_t;
+    typedef typename client_map_t::value_type client_value_t;
+
     //read
     class service_t: boost::noncopyable
     {
 	private:
-		//連接 客戶端
-		boost::unordered_set<socket_spt> _clients;
-		boost::mutex _mutex;
 		void clear()
 		{
 			boost::system::error_code ec;
-			boost::mutex::scoped_lock(_mutex);
-			BOOST_FOREACH(const socket_spt& sock,_clients)
+			BOOST_FOREACH(client_value_t& client,clients_map)
 			{
-				sock->shutdown(socket_t::shutdown_both,ec);
-        		sock->close(ec);
+				client.second.sock->shutdown(socket_t::shutdown_both,ec);
+        		client.second.sock->close(ec);
 			}
-			_clients.clear();
+			clients_map.clear();
 		}
 	public:
-		//asio 服務
+		//asio 服務 只由 一個 線程 運行
 		io_service_t service;
 		//asio work
 		work_spt work;
 		//已連接客戶數
-		std::size_t clients;
+		boost::atomic<std::size_t> clients;
 
 		//工作線程
 		thread_spt thread;
 
+		//讀取緩衝區 內存池 只在 工作線程中 使用
+		boost::scoped_ptr<buffer_pool_t> pool;
+
+		//空閒協程 只在 工作線程中 使用
+		std::vector<worker_t*> idle;
+
+		//統計 只在 工作線程中 寫入
+		service_metrics_t metrics;
+
+		//響應服務器 序號
+		kg::uint64_t index;
+		//連接 id 序列 只在 工作線程中 使用
+		kg::uint64_t sequence;
+		//其它線程 投遞的 消息
+		mailbox_t mailbox;
+		//連接 id -> 連接 只在 工作線程中 使用
+		client_map_t clients_map;
+
+		//只有 一個 線程 運行 io_service 告知 asio 以 減少 調度器 的 鎖 與 喚醒
 		service_t()
+			:service(BOOST_ASIO_CONCURRENCY_HINT_1),index(0),sequence(0)
 		{
 			clients = 0;
 		}
@@ -123,9 +420,11 @@ private:
 			if(work)
 			{
 				work.reset();
+				//喚醒 空閒協程 使其退出
+				service.post(boost::bind(&service_t::clear_idle,this));
 			}
-			//關閉 socket
-			clear();
+			//在 工作線程中 關閉 socket 避免與 讀寫 併發
+			service.post(boost::bind(&service_t::clear,this));
 
 			//等待 線程退出
 			if(thread)
@@ -134,18 +433,26 @@ private:
 				thread.reset();
 			}
 		}
-		void insert(const socket_spt& sock)
+		void clear_idle()
 		{
-			boost::mutex::scoped_lock(_mutex);
-			_clients.insert(sock);
+			boost::system::error_code ec;
+			BOOST_FOREACH(worker_t* worker,idle)
+			{
+				worker->timer.cancel(ec);
+			}
+			idle.clear();
 		}
-		void erase(const socket_spt& sock)
+		//關閉 所有 空閒連接的 讀端 使 等待中的 讀取 返回 eof 進入 優雅關閉
+		//不能 cancel socket 那樣 會 同時 取消 寫出中的 async_write 丟棄 發送隊列
+		void drain()
 		{
-			boost::mutex::scoped_lock(_mutex);
-			BOOST_AUTO(find,_clients.find(sock));
-			if(find != _clients.end())
+			boost::system::error_code ec;
+			BOOST_FOREACH(client_value_t& client,clients_map)
 			{
-				_clients.erase(find);
+				if(*client.second.idle)
+				{
+					client.second.sock->shutdown(socket_t::shutdown_receive,ec);
+				}
 			}
 		}
     };
@@ -160,28 +467,75 @@ private:
     //客戶端 超時 時間 如果爲0 永不超時
     std::size_t _timeout;
 
+    //可選 設定
+    basic_server_options_t _options;
+
+    //阻塞任務 線程池
+    boost::scoped_ptr<task_pool_t> _tasks;
+
+    //連接 id -> 連接 任意線程 無鎖 查找
+    boost::scoped_ptr<session_table_t<connection_spt> > _sessions;
+
+    //是否 監聽 unix 域 socket
+    bool _local;
+    //已 綁定的 unix 域 socket 路徑
+    std::string _path;
+    //設置到 accept 的 連接 的 socket 選項
+    socket_options_t _accepted;
+
+    //已接納的 連接數
+    boost::atomic<std::size_t> _admitted;
+    //每個 ip 連接數 限制
+    boost::scoped_ptr<peer_limit_t> _peer_limit;
+    //accept 速率 限制 只在 監聽 線程中 使用
+    boost::scoped_ptr<token_bucket_t> _accept_bucket;
+    boost::scoped_ptr<deadline_timer_t> _accept_timer;
+    //被拒絕的 連接數 只在 監聽 線程中 寫入
+    counter_t _rejected;
+
 	void init(const std::string& laddr)
 	{
 		//解析地址
-		BOOST_AUTO(find,laddr.find_last_of(':'));
-		if(find == std::string::npos)
-		{
-			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_BASIC_SERVER_CODE_BAD_ADDR,basic_server_category::get()));
-		}
-		std::string tmp = laddr.substr(find+1);
+		std::string tmp;
 		unsigned short port = 0;
-		try
+		std::string path;
+		_local = is_local_address(laddr,path);
+		if(_local)
 		{
-			port = boost::lexical_cast<unsigned short>(tmp);
+#if !defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_BASIC_SERVER_CODE_BAD_ADDR,basic_server_category::get()));
+#endif // BOOST_ASIO_HAS_LOCAL_SOCKETS
 		}
-		catch(const boost::bad_lexical_cast&)
+		else
 		{
+			BOOST_AUTO(find,laddr.find_last_of(':'));
+			if(find == std::string::npos)
+			{
+				BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_BASIC_SERVER_CODE_BAD_ADDR,basic_server_category::get()));
+			}
+			tmp = laddr.substr(find+1);
+			try
+			{
+				port = boost::lexical_cast<unsigned short>(tmp);
+			}
+			catch(const boost::bad_lexical_cast&)
+			{
+			}
+			if(port == 0)
+			{
+				BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_BASIC_SERVER_CODE_BAD_ADDR,basic_server_category::get()));
+			}
+			tmp = laddr.substr(0,find);
 		}
-		if(port == 0)
+
+		//unix 域 socket 不支持 tcp 選項
+		_accepted = _options.socket;
+		if(_local)
 		{
-			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_BASIC_SERVER_CODE_BAD_ADDR,basic_server_category::get()));
+			_accepted.no_delay = false;
+			_accepted.quick_ack = false;
+			_accepted.keep_alive = false;
 		}
-		tmp = laddr.substr(0,find);
 
 		//創建 asio 服務
 		try
@@ -189,16 +543,63 @@ private:
 			//創建 asio
 			_service = boost::make_shared<io_service_t>();
 
+			//創建 連接 限制
+			_admitted = 0;
+			if(_options.max_connections_per_ip && !_local)
+			{
+				_peer_limit.reset(new peer_limit_t(_options.max_connections_per_ip));
+			}
+			if(_options.accept_rate)
+			{
+				_accept_bucket.reset(new token_bucket_t(_options.accept_rate,_options.accept_burst));
+				_accept_timer.reset(new deadline_timer_t(*_service));
+			}
+
 			//創建 監聽器
-			_acceptor = boost::make_shared<acceptor_t>(*_service,boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string(tmp),port));
+			_acceptor = boost::make_shared<acceptor_t>(*_service);
+			if(_local)
+			{
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+				listen_local(*_acceptor,path,_options.socket.listen_backlog());
+				_path = path;
+#endif // BOOST_ASIO_HAS_LOCAL_SOCKETS
+			}
+			else
+			{
+				boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address::from_string(tmp),port);
+				_acceptor->open(endpoint.protocol());
+				_acceptor->set_option(acceptor_t::reuse_address(true));
+				_options.socket.apply(*_acceptor);
+				_acceptor->bind(endpoint);
+				_acceptor->listen(_options.socket.listen_backlog());
+			}
 			
+			//創建 阻塞任務 線程池
+			if(_options.blocking_threads)
+			{
+				_tasks.reset(new task_pool_t(_options.blocking_threads,_options.blocking_max));
+			}
+
+			_sessions.reset(new session_table_t<connection_spt>(_options.session_shards));
+
 			//創建 響應 服務器
-			std::size_t n = boost::thread::hardware_concurrency();
+			std::size_t n = _options.threads;
+			if(!n)
+			{
+				n = boost::thread::hardware_concurrency();
+			}
 			for(std::size_t i=0; i<n; ++i)
 			{
 				service_spt service = boost::make_shared<service_t>();
+				service->index = i;
 				service->work = boost::make_shared<work_t>(service->service);
-				service->thread = boost::make_shared<thread_t>(boost::bind(type_t::works_thread,&(service->service)));
+
+				int cpu = -1;
+				if(_options.pin_threads)
+				{
+					cpu = _options.cpus.empty() ? int(i) : _options.cpus[i % _options.cpus.size()];
+				}
+				service->thread = boost::make_shared<thread_t>(boost::bind(&type_t::works_thread,this,service.get(),cpu));
 
 				_services.push_back(service);
 			}
@@ -208,10 +609,19 @@ private:
 			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_BASIC_SERVER_CODE_BAD_ALLOC,basic_server_category::get()));
 		}
 	}
-	static void works_thread(io_service_t* service)
+	void works_thread(service_t* service,int cpu)
 	{
+		if(cpu != -1 && pin_thread(cpu))
+		{
+			numa_local();
+		}
+
+		//在 工作線程中 創建 內存池 使其 位於 本地 numa 節點
+		//io_service 尚未 運行 不會有 連接 在此之前 使用 內存池
+		service->pool.reset(new buffer_pool_t(_options.read_buffer_min,_options.read_buffer_max,_options.read_buffer_cache));
+
 		//KG_TRACE("start read service "<<service)
-		service->run();
+		service->service.run();
 		//KG_TRACE("exit read service "<<service)
 	}
 public:
@@ -219,13 +629,13 @@ public:
 	*	\brief 初始化 服務器
 	*
 	*	\exception boost::system::system_error
-	*	\param laddr	服務器監聽地址
+	*	\param laddr	服務器監聽地址 host:port 或 unix:/path
 	*	\param poll		連接分配cpu 輪詢計算 (每個cpu 會被分配 poll個 連接之後 才會將 連接分配到下個 cpu)
 	*	\param timeout	客戶端 未活動 斷開 超時時間(單位 秒)
 	*
 	*/
     basic_server_t(const std::string& laddr,std::size_t poll,std::size_t timeout)
-    	:_pos(0),_timeout(timeout),_run(false)
+    	:_pos(0),_timeout(timeout),_run(false),_draining(false)
     {
     	//設置輪詢 響應服務器 差值
     	if(poll < 1)
@@ -239,13 +649,63 @@ public:
     /**
 	*	\brief 初始化 服務器
 	*
-	*	\param laddr	服務器監聽地址
+	*	\param laddr	服務器監聽地址 host:port 或 unix:/path
 	*	\param poll		連接分配cpu 輪詢計算 (每個cpu 會被分配 poll個 連接之後 才會將 連接分配到下個 cpu)
 	*	\param timeout	客戶端 未活動 斷開 超時時間(單位 秒)
 	*
 	*/
     basic_server_t(const std::string& laddr,std::size_t poll,std::size_t timeout,boost::system::error_code& ec)
-    	:_pos(0),_timeout(timeout),_run(false)
+    	:_pos(0),_timeout(timeout),_run(false),_draining(false)
+    {
+    	try
+    	{
+    		//設置輪詢 響應服務器 差值
+    		if(poll < 1)
+			{
+				poll = 10;
+			}
+			_poll = _flag = poll;
+
+    		init(laddr);
+    	}
+    	catch(const boost::system::system_error& e)
+    	{
+    		ec = e.code();
+    	}
+    }
+    /**
+	*	\brief 初始化 服務器
+	*
+	*	\exception boost::system::system_error
+	*	\param laddr	服務器監聽地址 host:port 或 unix:/path
+	*	\param poll		連接分配cpu 輪詢計算 (每個cpu 會被分配 poll個 連接之後 才會將 連接分配到下個 cpu)
+	*	\param timeout	客戶端 未活動 斷開 超時時間(單位 秒)
+	*	\param options	可選 設定
+	*
+	*/
+    basic_server_t(const std::string& laddr,std::size_t poll,std::size_t timeout,const basic_server_options_t& options)
+    	:_pos(0),_timeout(timeout),_options(options),_run(false),_draining(false)
+    {
+    	//設置輪詢 響應服務器 差值
+    	if(poll < 1)
+		{
+			poll = 10;
+		}
+		_poll = _flag = poll;
+
+    	init(laddr);
+    }
+    /**
+	*	\brief 初始化 服務器
+	*
+	*	\param laddr	服務器監聽地址 host:port 或 unix:/path
+	*	\param poll		連接分配cpu 輪詢計算 (每個cpu 會被分配 poll個 連接之後 才會將 連接分配到下個 cpu)
+	*	\param timeout	客戶端 未活動 斷開 超時時間(單位 秒)
+	*	\param options	可選 設定
+	*
+	*/
+    basic_server_t(const std::string& laddr,std::size_t poll,std::size_t timeout,const basic_server_options_t& options,boost::system::error_code& ec)
+    	:_pos(0),_timeout(timeout),_options(options),_run(false),_draining(false)
     {
     	try
     	{
@@ -266,20 +726,29 @@ public:
     ~basic_server_t()
     {
     	stop();
+
+		//刪除 unix 域 socket 文件
+    	if(!_path.empty())
+		{
+			std::remove(_path.c_str());
+		}
     }
 public:
     /**
 	*	\brief 停止 服務器 釋放所有資源
 	*
+	*	會 等待 所有 響應服務器 線程 退出 不能 在 回調 中 調用\n
+	*	返回前 會 釋放 響應服務器 與 連接 查找表 不能 與 其它線程 中的 post_to broadcast find metrics connections 併發 調用
 	*/
     void stop()
     {
-		boost::mutex::scoped_lock(_mutex);
+		boost::mutex::scoped_lock lock(_mutex);
 		if(!_run)
 		{
 			return;
 		}
 		_run = false;
+		_draining = false;
 		//停止 監聽 服務器    	
     	if(_acceptor)
 		{
@@ -291,7 +760,20 @@ public:
 		if(_service)
 		{
 			_service->stop();
-			_service.reset();
+		}
+		//監聽 線程 會 讀取 _services 必須 在 清空 之前 退出
+		if(_thread)
+		{
+			_thread->join();
+			_thread.reset();
+		}
+		_accept_timer.reset();
+		_service.reset();
+
+		//等待 阻塞任務 完成 使 等待中的 協程 得以 恢復
+		if(_tasks)
+		{
+			_tasks->stop();
 		}
 
     	//停止 響應服務器
@@ -299,13 +781,203 @@ public:
 		{
 			service->stop();
 		}
+		//查找表 中的 連接 必須 在 其 io_service 之前 釋放
+		_sessions.reset();
 		_services.clear();
+    }
+    /**
+	*	\brief 優雅 停止 服務器
+	*
+	*	停止 接受 新連接 等待 正在執行的 回調 返回 並寫出 發送隊列 之後 半關閉 連接\n
+	*	空閒的 連接 立刻 半關閉 當 對端 關閉 或 deadline 到達 時 返回 並調用 stop 強制 關閉 剩餘連接
+	*
+	*	\param deadline	最長 等待 時間
+	*/
+    void shutdown(const boost::posix_time::time_duration& deadline)
+    {
+		boost::system_time abs = boost::get_system_time() + deadline;
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			if(!_run || _draining)
+			{
+				return;
+			}
+			_draining = true;
 
-		if(_thread)
+			//停止 接受 新連接
+			if(_service)
+			{
+				_service->post(boost::bind(&type_t::close_acceptor,this));
+			}
+			//通知 響應服務器 開始 排空
+			BOOST_FOREACH(service_spt& service,_services)
+			{
+				service->service.post(boost::bind(&service_t::drain,service));
+			}
+		}
+
+		//等待 連接 全部 關閉
 		{
-			_thread->join();
-			_thread.reset();
+			boost::mutex::scoped_lock lock(_drain_mutex);
+			while(connections())
+			{
+				if(!_drain_cv.timed_wait(lock,abs))
+				{
+					break;
+				}
+			}
+		}
+
+		stop();
+    }
+    /**
+	*	\brief 向 連接 投遞 消息
+	*
+	*	線程安全 消息 被放入 連接 所屬 響應服務器 的 無鎖 郵箱 在 其 工作線程 中 交給 posted 回調\n
+	*	未設置 posted 回調 時 直接 加入 連接 發送隊列 連接 已 關閉 時 消息 被 丟棄\n
+	*	可在 回調 中 調用 在 其它線程 調用 時 不能 與 stop 併發
+	*
+	*	\param id	connection_t::id
+	*	\param data	消息 在 投遞後 不要 修改
+	*	\param n	消息 長度
+	*	\return id 無效 或 內存 不足 時 返回 false
+	*/
+    bool post_to(kg::uint64_t id,boost::shared_array<kg::byte_t> data,std::size_t n)
+    {
+		std::size_t i = std::size_t(id >> KG_NET_CONNECTION_ID_SHIFT);
+		if(i >= _services.size())
+		{
+			return false;
+		}
+		return post_mail(*_services[i],mail_t(id,data,n));
+    }
+    /**
+	*	\brief 拷貝 消息 並 向 連接 投遞
+	*
+	*	\see post_to
+	*/
+    bool post_to(kg::uint64_t id,const kg::byte_t* b,std::size_t n)
+    {
+		boost::shared_array<kg::byte_t> data;
+		if(!copy_mail(b,n,data))
+		{
+			return false;
+		}
+		return post_to(id,data,n);
+    }
+    /**
+	*	\brief 向 所有 連接 投遞 消息
+	*
+	*	每個 響應服務器 只 投遞 一次 由其 工作線程 交給 其上 所有 連接
+	*
+	*	\see post_to
+	*/
+    bool broadcast(boost::shared_array<kg::byte_t> data,std::size_t n)
+    {
+		bool ok = true;
+		BOOST_FOREACH(service_spt& service,_services)
+		{
+			if(!post_mail(*service,mail_t(KG_NET_BROADCAST_ID,data,n)))
+			{
+				ok = false;
+			}
 		}
+		return ok;
+    }
+    /**
+	*	\brief 拷貝 消息 並 向 所有 連接 投遞
+	*
+	*	\see broadcast
+	*/
+    bool broadcast(const kg::byte_t* b,std::size_t n)
+    {
+		boost::shared_array<kg::byte_t> data;
+		if(!copy_mail(b,n,data))
+		{
+			return false;
+		}
+		return broadcast(data,n);
+    }
+    /**
+	*	\brief 以 id 查找 連接
+	*
+	*	線程安全 不加鎖 平均 O(1)\n
+	*	只能 找到 connected 回調 成功 且 尚未 結束 讀取 的 連接 返回的 連接 可能 隨即 被 關閉\n
+	*	可在 回調 中 調用 在 其它線程 調用 時 不能 與 stop 併發
+	*
+	*	\param id	connection_t::id
+	*	\return 未找到 時 返回 空
+	*/
+    connection_spt find(kg::uint64_t id)const
+    {
+		connection_spt sp;
+		if(_sessions)
+		{
+			_sessions->find(id,sp);
+		}
+		return sp;
+    }
+    /**
+	*	\brief 返回 阻塞任務 線程池
+	*
+	*	在 回調中 使用 tasks().call(func,ctx) 執行 阻塞操作 而不 凍結 響應服務器\n
+	*	\attention 只有 options.blocking_threads 不爲0 時 才可 調用
+	*/
+    inline task_pool_t& tasks()
+    {
+		BOOST_ASSERT(_tasks);
+		return *_tasks;
+    }
+    /**
+	*	\brief 返回 統計 快照
+	*
+	*	只讀取 各響應服務器 的 計數器 不會 阻塞 工作線程\n
+	*	可在 回調 中 調用 在 其它線程 調用 時 不能 與 stop 併發
+	*/
+    server_metrics_t metrics()
+    {
+		server_metrics_t rs;
+		rs.services.resize(_services.size());
+		for(std::size_t i=0; i<_services.size(); ++i)
+		{
+			service_t& service = *_services[i];
+			service.metrics.snapshot(rs.services[i],service.clients);
+			rs.total += rs.services[i];
+		}
+		rs.total.rejected = _rejected.get();
+		return rs;
+    }
+    /**
+	*	\brief 返回 連接 協程 使用的 棧 屬性
+	*
+	*	在 連接 協程中 再 spawn 的 協程 應 使用 相同 屬性 使 stack_size 對其 同樣 生效
+	*/
+    boost::coroutines::attributes get_attributes()const
+    {
+		std::size_t size = _options.stack_size;
+		if(!size)
+		{
+			return boost::coroutines::attributes();
+		}
+		if(size < boost::coroutines::stack_traits::minimum_size())
+		{
+			size = boost::coroutines::stack_traits::minimum_size();
+		}
+		return boost::coroutines::attributes(size);
+    }
+    /**
+	*	\brief 返回 當前 連接數
+	*
+	*	可在 回調 中 調用 在 其它線程 調用 時 不能 與 stop 併發
+	*/
+    std::size_t connections()
+    {
+		std::size_t sum = 0;
+		BOOST_FOREACH(service_spt& service,_services)
+		{
+			sum += service->clients;
+		}
+		return sum;
     }
     /**
 	*	\brief 運行 服務器
@@ -316,7 +988,7 @@ public:
     {
 		try
 		{
-			boost::mutex::scoped_lock(_mutex);
+			boost::mutex::scoped_lock lock(_mutex);
 			if(_run)
 			{
 				return;
@@ -360,9 +1032,23 @@ public:
 		}
 	}
 private:
-	bool _run;
+	//監聽 線程 與 響應服務器 線程 會 讀取
+	boost::atomic<bool> _run;
 	boost::mutex _mutex;
 	thread_spt _thread;
+
+	//是否 正在 優雅關閉
+	boost::atomic<bool> _draining;
+	boost::mutex _drain_mutex;
+	boost::condition_variable _drain_cv;
+	void close_acceptor()
+	{
+		if(_acceptor)
+		{
+			boost::system::error_code ec;
+			_acceptor->close(ec);
+		}
+	}
 	void run_thread(io_service_spt service)
 	{
         service->run();
@@ -370,11 +1056,21 @@ private:
 private:
     void post_accept()
     {
+		//限制 accept 速率 令牌 用盡時 等待 補充
+		if(_accept_bucket && !_accept_bucket->take())
+		{
+			boost::system::error_code ec;
+			_accept_timer->expires_from_now(boost::posix_time::microseconds(_accept_bucket->wait(1).count()),ec);
+			_accept_timer->async_wait(boost::bind(&type_t::handler_accept_timer,this,_1));
+			return;
+		}
     	try
     	{
     		service_spt service = get_service();
 
-			socket_spt sock = boost::make_shared<socket_t>(service->service);
+			connection_spt sock = boost::make_shared<connection_t>(service->service);
+			sock->watermarks(_options.write_high_watermark,_options.write_low_watermark);
+			sock->metrics(&service->metrics.bytes_out);
 			_acceptor->async_accept(*sock,
 								   boost::bind(&type_t::post_accept_handler,
 											   this,
@@ -414,9 +1110,9 @@ private:
         return _services[_pos];
     }
 
-    void post_accept_handler(const boost::system::error_code& ec,socket_spt sock,service_spt service)
+    void post_accept_handler(const boost::system::error_code& ec,connection_spt sock,service_spt service)
     {
-		if(!_run)
+		if(!_run || _draining)
 		{
 			return;
 		}
@@ -426,133 +1122,445 @@ private:
         {
             return;
         }
+        if(!admit(sock))
+		{
+			boost::system::error_code err;
+			sock->close(err);
+			_rejected.add();
+			return;
+		}
+
+        if(_options.stack_pool)
+		{
+			//在 響應服務器 線程中 交給 空閒協程
+			service->service.post(boost::bind(&type_t::dispatch_socket,this,sock,service));
+			return;
+		}
 
         //爲 socket 啓動 通信 coroutine
-        boost::asio::spawn(service->service,boost::bind(&type_t::coroutine_read,this,sock,service,_timeout,_1));
+        boost::asio::spawn(service->service,boost::bind(&type_t::coroutine_connection,this,sock,service,_1),get_attributes());
+    }
+    static bool copy_mail(const kg::byte_t* b,std::size_t n,boost::shared_array<kg::byte_t>& data)
+    {
+		try
+		{
+			data.reset(new kg::byte_t[n]);
+		}
+		catch(const std::bad_alloc&)
+		{
+			return false;
+		}
+		memcpy(data.get(),b,n);
+		return true;
     }
+    bool post_mail(service_t& service,const mail_t& mail)
+    {
+		try
+		{
+			//郵箱 由 空 變爲 非空 時 通知 工作線程
+			if(service.mailbox.send(mail))
+			{
+				service.service.post(boost::bind(&type_t::handler_mailbox,this,&service));
+			}
+		}
+		catch(const std::bad_alloc&)
+		{
+			return false;
+		}
+		return true;
+    }
+    void handler_mailbox(service_t* service)
+    {
+		service->mailbox.begin();
+		mail_t mail;
+		while(service->mailbox.receive(mail))
+		{
+			if(mail.id == KG_NET_BROADCAST_ID)
+			{
+				BOOST_AUTO(end,service->clients_map.end());
+				for(BOOST_AUTO(it,service->clients_map.begin()); it != end; ++it)
+				{
+					deliver(it->second,mail);
+				}
+				continue;
+			}
+			BOOST_AUTO(find,service->clients_map.find(mail.id));
+			if(find != service->clients_map.end())
+			{
+				deliver(find->second,mail);
+			}
+		}
+    }
+    static inline void set_session(service_t& service,kg::uint64_t id,session_t* session)
+    {
+		BOOST_AUTO(find,service.clients_map.find(id));
+		if(find != service.clients_map.end())
+		{
+			find->second.session = session;
+		}
+    }
+    inline void deliver(client_t& client,const mail_t& mail)
+    {
+		if(!client.session)
+		{
+			return;
+		}
+		if(_posted)
+		{
+			_posted(client.sock,*client.session,mail.data,mail.size);
+		}
+		else
+		{
+			client.sock->send(mail.data,mail.size);
+		}
+    }
+    void handler_accept_timer(const boost::system::error_code& e)
+    {
+		if(e || !_run || _draining)
+		{
+			return;
+		}
+		post_accept();
+    }
+    //檢查 連接數 限制 通過 則 計入
+    bool admit(const connection_spt& sock)
+    {
+		if(_options.max_connections && _admitted >= _options.max_connections)
+		{
+			return false;
+		}
+		if(!_local)
+		{
+			boost::system::error_code ec;
+			endpoint_t remote = sock->remote_endpoint(ec);
+			if(ec)
+			{
+				return false;
+			}
+			sock->peer(remote.address());
+			try
+			{
+				if(_peer_limit && !_peer_limit->acquire(remote.address()))
+				{
+					return false;
+				}
+			}
+			catch(const std::bad_alloc&)
+			{
+				return false;
+			}
+		}
+		++_admitted;
+		return true;
+    }
+    void release_admission(const connection_spt& sock)
+    {
+		if(_peer_limit)
+		{
+			_peer_limit->release(sock->peer());
+		}
+		--_admitted;
+    }
+    void dispatch_socket(connection_spt sock,service_spt service)
+    {
+		if(service->idle.empty())
+		{
+			boost::asio::spawn(service->service,boost::bind(&type_t::coroutine_worker,this,sock,service,_1),get_attributes());
+			return;
+		}
+
+		//喚醒 空閒協程
+		worker_t* worker = service->idle.back();
+		service->idle.pop_back();
+		worker->sock = sock;
+
+		boost::system::error_code ec;
+		worker->timer.cancel(ec);
+    }
+    void coroutine_connection(connection_spt sock,service_spt service,boost::asio::yield_context ctx)
+    {
+		service->metrics.coroutines.add();
+		coroutine_read(sock,service,_timeout,ctx);
+    }
+    void coroutine_worker(connection_spt sock,service_spt service,boost::asio::yield_context ctx)
+    {
+		service->metrics.coroutines.add();
+		worker_t worker(service->service);
+		worker.sock = sock;
+		boost::system::error_code ec;
+		while(worker.sock)
+		{
+			sock = worker.sock;
+			worker.sock.reset();
+			coroutine_read(sock,service,_timeout,ctx);
+			sock.reset();
+
+			if(!_run || service->idle.size() >= _options.stack_pool)
+			{
+				break;
+			}
 
-	void coroutine_read(socket_spt sp,service_spt service,std::size_t timeout,boost::asio::yield_context ctx)
+			//掛起 等待 下個連接 yield
+			service->idle.push_back(&worker);
+			worker.timer.expires_at(boost::posix_time::pos_infin);
+			worker.timer.async_wait(ctx[ec]);
+		}
+    }
+
+	void coroutine_read(connection_spt sp,service_spt service,std::size_t timeout,boost::asio::yield_context ctx)
     {
-    	service->insert(sp);
+    	//是否 正在 等待 數據
+    	bool idle = false;
+    	const kg::uint64_t id = (service->index << KG_NET_CONNECTION_ID_SHIFT) | ++service->sequence;
+    	sp->id(id);
+    	//停止時 clear 會 清空 表 故 不 持有 其 元素 的 引用
+    	{
+			client_t& client = service->clients_map[id];
+			client.sock = sp;
+			client.session = NULL;
+			client.idle = &idle;
+    	}
 
-    	std::size_t& clients = service->clients;
+    	boost::atomic<std::size_t>& clients = service->clients;
     	++clients;
+    	service_metrics_t& metrics = service->metrics;
+    	metrics.accepts.add();
 
     	boost::system::error_code ec;
     	socket_t& s = *sp;
     	//KG_TRACE("one in");
     	session_t session = session_t();
-    	if(!_connected || _connected(sp,session,ctx))
+    	const socket_options_t& options = _accepted;
+    	options.apply(s,ec);
+    	if(_handler.connected(sp,session,ctx))
 		{
 			deadline_timer_t timer(service->service);
 			try
 			{
+				//接收 post_to 投遞的 消息 並可 被 find 找到
+				_sessions->insert(id,sp);
+				set_session(*service,id,&session);
+
 				//讀取消息
-				byte_t buffer[KG_NET_BASIC_SERVER_BUFFER_SIZE];
-				while(true)
+				adaptive_buffer_t buffer(*service->pool,_options.read_buffer_min);
+				const bool release = _options.read_buffer_release;
+
+				//讀取 速率 限制
+				boost::scoped_ptr<token_bucket_t> limiter;
+				boost::scoped_ptr<deadline_timer_t> pause;
+				if(_options.read_rate)
+				{
+					limiter.reset(new token_bucket_t(_options.read_rate,_options.read_burst));
+					pause.reset(new deadline_timer_t(service->service));
+				}
+				while(!_draining)
 				{
 					//超時 斷開
 					if(timeout)
 					{
 						timer.expires_from_now(boost::posix_time::seconds(timeout));
-						timer.async_wait(boost::bind(handler_timer,sp,_1));
+						timer.async_wait(boost::bind(handler_timer,sp,&metrics,_1));
+					}
+
+					//等待 可讀 期間 不持有 緩衝區 yield
+					idle = true;
+					if(release)
+					{
+						s.async_wait(socket_t::wait_read,ctx);
 					}
 
 					//接收消息 yield
-					std::size_t n = s.async_read_some(boost::asio::buffer(buffer,KG_NET_BASIC_SERVER_BUFFER_SIZE),ctx);
+					kg::byte_t* b = buffer.get();
+					std::size_t n = s.async_read_some(boost::asio::buffer(b,buffer.size()),ctx);
+					idle = false;
 					//取消 超時 斷開
 					if(timeout)
 					{
 						timer.cancel(ec);
 					}
+					options.rearm(s,ec);
+
+					metrics.reads.add();
+					metrics.bytes_in.add(n);
 
 					//通知 響應
-					if(_readed &&
-						!_readed(sp,session,buffer,n,ctx)
-						)
 					{
-						break;
+						std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+						bool ok = _handler.readed(sp,session,b,n,ctx);
+						metrics.latency.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+						if(!ok)
+						{
+							break;
+						}
+					}
+
+					//調整 下次 讀取量
+					buffer.adapt(n);
+					if(release)
+					{
+						buffer.release();
+					}
+
+					//超過 讀取 速率 暫停 讀取 yield
+					if(limiter)
+					{
+						std::chrono::microseconds wait = limiter->consume(n);
+						if(wait.count())
+						{
+							pause->expires_from_now(boost::posix_time::microseconds(wait.count()));
+							pause->async_wait(ctx[ec]);
+						}
 					}
 				}
 			}
 			catch(const boost::system::system_error&)
 			{
 			}
+			catch(const std::bad_alloc&)
+			{
+			}
+			set_session(*service,id,NULL);
+			_sessions->erase(id);
+			idle = false;
 			if(timeout)
 			{
 				timer.cancel(ec);
 			}
+
+			if(_draining)
+			{
+				coroutine_drain(sp,ctx);
+			}
 		}
 
         s.shutdown(socket_t::shutdown_both,ec);
         s.close(ec);
 
-		service->erase(sp);
-        --clients;
+		service->clients_map.erase(id);
+		release_admission(sp);
+        if(!--clients && _draining)
+		{
+			boost::mutex::scoped_lock lock(_drain_mutex);
+			_drain_cv.notify_all();
+		}
 
         //KG_TRACE("one out");
-		if(_closed)
+		_handler.closed(sp,session,ctx);
+    }
+    void coroutine_drain(connection_spt sp,boost::asio::yield_context ctx)
+    {
+		boost::system::error_code ec;
+		try
+		{
+			//寫出 發送隊列
+			sp->flush(ctx);
+		}
+		catch(const boost::system::system_error&)
 		{
-			_closed(sp,session,ctx);
+			return;
+		}
+
+		//半關閉 等待 對端 關閉 (讀端 已被 drain 關閉 時 立刻 返回)
+		sp->shutdown(socket_t::shutdown_send,ec);
+		if(ec)
+		{
+			return;
+		}
+		kg::byte_t buffer[128];
+		while(!ec)
+		{
+			sp->async_read_some(boost::asio::buffer(buffer,sizeof(buffer)),ctx[ec]);
 		}
     }
-    static void handler_timer(socket_spt sock,const boost::system::error_code& e)
+    static void handler_timer(connection_spt sock,service_metrics_t* metrics,const boost::system::error_code& e)
     {
 		if(e)
 		{
 			return;
 		}
+		metrics->timeouts.add();
 		boost::system::error_code ec;
 		sock->shutdown(socket_t::shutdown_both,ec);
         sock->close(ec);
     }
 public:
+	/**
+	*	\brief 回調 處理器 型別
+	*
+	*/
+	typedef Handler handler_t;
 	/**
 	*	\brief 定義 連接建立後 回調
 	*
 	*	\return 返回 false 將 自動斷開 連接  並調用 closed 回調
 	*/
-	typedef boost::function<bool(socket_spt,session_t&,boost::asio::yield_context)> connected_bft;
+	typedef typename basic_function_handler_t<T>::connected_bft connected_bft;
 	/**
 	*	\brief 定義 連接斷開後 回調
 	*
-	*	\return 返回 false 將 自動斷開 連接  並調用 closed 回調
 	*/
-	typedef boost::function<void(socket_spt,session_t&,boost::asio::yield_context)> closed_bft;
+	typedef typename basic_function_handler_t<T>::closed_bft closed_bft;
 	/**
 	*	\brief 定義 讀取到數據後 回調
 	*
+	*	\return 返回 false 將 自動斷開 連接  並調用 closed 回調
 	*/
-	typedef boost::function<bool(socket_spt,session_t&,kg::byte_t*,std::size_t n,boost::asio::yield_context)> readed_bft;
+	typedef typename basic_function_handler_t<T>::readed_bft readed_bft;
 
+	/**
+	*	\brief 定義 收到 post_to/broadcast 投遞的 消息 時 回調
+	*
+	*	在 連接 所屬 響應服務器 線程 調用 不能 掛起
+	*/
+	typedef boost::function<void(const connection_spt&,session_t&,const boost::shared_array<kg::byte_t>&,std::size_t)> posted_bft;
 private:
-	connected_bft _connected;
-	closed_bft _closed;
-	readed_bft _readed;
+	handler_t _handler;
+	posted_bft _posted;
 public:
+	/**
+	*	\brief 設置 收到 投遞 消息 時 回調
+	*
+	*	應在 run 之前 設置
+	*/
+	inline void posted(posted_bft func)
+	{
+		_posted = func;
+	}
+	/**
+	*	\brief 返回 回調 處理器
+	*
+	*	應在 run 之前 設置 處理器 狀態
+	*/
+	inline handler_t& handler()
+	{
+		return _handler;
+	}
 	/**
 	*	\brief 設置 連接建立後 回調
 	*
+	*	只在 使用 默認的 basic_function_handler_t 時 可用
 	*/
 	inline void connected(connected_bft func)
 	{
-		_connected = func;
+		_handler.on_connected = func;
 	}
 	/**
 	*	\brief 設置 連接斷開後 回調
 	*
+	*	只在 使用 默認的 basic_function_handler_t 時 可用
 	*/
 	inline void closed(closed_bft func)
 	{
-		_closed = func;
+		_handler.on_closed = func;
 	}
 	/**
 	*	\brief 設置 讀取到數據後 回調
 	*
+	*	只在 使用 默認的 basic_function_handler_t 時 可用
 	*/
 	inline void readed(readed_bft func)
 	{
-		_readed = func;
+		_handler.on_readed = func;
 	}
 };
 };
@@ -0,0 +1,950 @@
+#ifndef KG_NET_BASIC_UDP_SERVER_HEADER_HPP
+#define KG_NET_BASIC_UDP_SERVER_HEADER_HPP
+
+#include <vector>
+#include <cstring>
+
+#include <boost/asio/spawn.hpp>
+#include <boost/bind.hpp>
+#include <boost/typeof/typeof.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/atomic.hpp>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <errno.h>
+#endif // __linux__
+
+#include "types.hpp"
+#include "metrics.hpp"
+#include "affinity.hpp"
+
+namespace kg
+{
+namespace net
+{
+#ifndef KG_NET_UDP_SERVER_BATCH
+#define KG_NET_UDP_SERVER_BATCH	64
+#endif // KG_NET_UDP_SERVER_BATCH
+
+#ifndef KG_NET_UDP_SERVER_DATAGRAM_SIZE
+#define KG_NET_UDP_SERVER_DATAGRAM_SIZE	2048
+#endif // KG_NET_UDP_SERVER_DATAGRAM_SIZE
+
+#define KG_NET_BASIC_UDP_SERVER_CODE_BAD_ALLOC	1
+#define KG_NET_BASIC_UDP_SERVER_CODE_BAD_ADDR	100
+/**
+*	\brief basic_udp_server_t 異常定義
+*
+*/
+class basic_udp_server_category :
+    public boost::system::error_category
+{
+public:
+    virtual const char *name() const BOOST_SYSTEM_NOEXCEPT
+    {
+        return "kg::net::basic_udp_server : ";
+    }
+    virtual std::string message(int ev) const
+    {
+    	std::string msg("kg::net::basic_udp_server : ");
+        switch(ev)
+        {
+        case 0:
+            return msg + "success";
+		case KG_NET_BASIC_UDP_SERVER_CODE_BAD_ALLOC:
+            return msg + "bad alloc";
+        case KG_NET_BASIC_UDP_SERVER_CODE_BAD_ADDR:
+            return msg + "bad listen address";
+        }
+        return msg + "unknow";
+    }
+    static basic_udp_server_category& get()
+    {
+    	static basic_udp_server_category instance;
+    	return instance;
+    }
+};
+
+/**
+*	\brief basic_udp_server_t 可選 設定
+*
+*/
+class basic_udp_server_options_t
+{
+public:
+	/**
+	*	\brief 響應服務器 數量 (socket 數 線程數) 爲0 使用 cpu 數
+	*
+	*	每個 響應服務器 使用 SO_REUSEPORT 綁定 同一地址 由 內核 按 來源地址 分配 數據報\n
+	*	不支持 SO_REUSEPORT 的 平臺 只 創建 一個
+	*/
+	std::size_t threads;
+	/**
+	*	\brief 一次 recvmmsg/sendmmsg 最多 收發的 數據報 數量
+	*
+	*/
+	std::size_t batch;
+	/**
+	*	\brief 數據報 最大長度 (字節) 超過的 數據報 被丟棄
+	*
+	*/
+	std::size_t datagram_size;
+	/**
+	*	\brief SO_RCVBUF (字節) 爲0 使用 系統 默認值
+	*
+	*/
+	int recv_buffer;
+	/**
+	*	\brief SO_SNDBUF (字節) 爲0 使用 系統 默認值
+	*
+	*/
+	int send_buffer;
+	/**
+	*	\brief 是否 將 每個 響應服務器 線程 綁定到 一個 cpu
+	*
+	*	\see basic_server_options_t::pin_threads
+	*/
+	bool pin_threads;
+	/**
+	*	\brief 響應服務器 線程 綁定的 cpu 列表
+	*
+	*	第 i 個 響應服務器 綁定到 cpus[i % cpus.size()] 爲空時 綁定到 cpu i
+	*/
+	std::vector<int> cpus;
+
+	basic_udp_server_options_t()
+		:threads(0),
+		batch(KG_NET_UDP_SERVER_BATCH),
+		datagram_size(KG_NET_UDP_SERVER_DATAGRAM_SIZE),
+		recv_buffer(0),
+		send_buffer(0),
+		pin_threads(false)
+	{
+	}
+};
+
+/**
+*	\brief udp_endpoint_t 的 hash
+*
+*/
+class udp_endpoint_hash_t
+{
+public:
+	std::size_t operator()(const udp_endpoint_t& endpoint)const
+	{
+		std::size_t seed = 0;
+		boost::hash_combine(seed,endpoint.port());
+		const boost::asio::ip::address& address = endpoint.address();
+		if(address.is_v4())
+		{
+			boost::hash_combine(seed,address.to_v4().to_uint());
+		}
+		else
+		{
+			boost::asio::ip::address_v6::bytes_type bytes = address.to_v6().to_bytes();
+			boost::hash_range(seed,bytes.begin(),bytes.end());
+		}
+		return seed;
+	}
+};
+
+template<typename T>
+class basic_udp_server_t;
+
+/**
+*	\brief 批量 發送 udp 數據報
+*
+*	send 將 數據報 拷貝到 預先申請的 緩衝區 緩衝區 滿 或 一批 數據報 處理完 後 以一次 sendmmsg 發出\n
+*	send 與 flush 不會 掛起 socket 不可寫 時 未發出的 數據報 留在 緩衝區 由 響應服務器 在 本批 數據報 處理完 後 等待 可寫 再 發出\n
+*	只能在 所屬 響應服務器 線程 中 使用
+*/
+class udp_sender_t
+	: boost::noncopyable
+{
+private:
+	template<typename T>
+	friend class basic_udp_server_t;
+
+	udp_socket_t& _socket;
+	std::size_t _batch;
+	std::size_t _size;
+
+	std::vector<kg::byte_t> _data;
+	std::vector<udp_endpoint_t> _peers;
+	std::vector<std::size_t> _lengths;
+	std::size_t _count;
+#ifdef __linux__
+	std::vector<mmsghdr> _msgs;
+	std::vector<iovec> _iovs;
+#endif // __linux__
+
+	counter_t* _bytes_out;
+public:
+	/**
+	*	\exception std::bad_alloc
+	*	\param socket	發送 數據報 的 socket
+	*	\param batch	一次 最多 發送的 數據報 數量
+	*	\param size	數據報 最大長度
+	*	\param bytes_out	發送 字節數 統計 可以爲 NULL
+	*/
+	udp_sender_t(udp_socket_t& socket,std::size_t batch,std::size_t size,counter_t* bytes_out)
+		:_socket(socket),_batch(batch < 1 ? 1 : batch),_size(size),_count(0),_bytes_out(bytes_out)
+	{
+		_data.resize(_batch * _size);
+		_peers.resize(_batch);
+		_lengths.resize(_batch);
+#ifdef __linux__
+		_msgs.resize(_batch);
+		_iovs.resize(_batch);
+		memset(&_msgs[0],0,sizeof(mmsghdr) * _batch);
+		for(std::size_t i=0; i<_batch; ++i)
+		{
+			_iovs[i].iov_base = &_data[i * _size];
+			_msgs[i].msg_hdr.msg_iov = &_iovs[i];
+			_msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+#endif // __linux__
+	}
+	~udp_sender_t()
+	{
+		flush();
+	}
+	/**
+	*	\brief 返回 可發送的 數據報 最大長度
+	*
+	*/
+	inline std::size_t max_size()const
+	{
+		return _size;
+	}
+	/**
+	*	\brief 返回 緩衝區 中 等待 發出的 數據報 數量
+	*
+	*/
+	inline std::size_t pending()const
+	{
+		return _count;
+	}
+	/**
+	*	\brief 將 數據報 加入 發送緩衝區
+	*
+	*	緩衝區 已滿 時 先 嘗試 發出 不會 掛起
+	*
+	*	\return n 超過 max_size 或 socket 不可寫 且 緩衝區 已滿 時 返回 false 數據報 被丟棄
+	*/
+	bool send(const udp_endpoint_t& peer,const kg::byte_t* b,std::size_t n)
+	{
+		if(n > _size)
+		{
+			return false;
+		}
+		if(_count == _batch)
+		{
+			flush();
+			if(_count == _batch)
+			{
+				return false;
+			}
+		}
+		memcpy(&_data[_count * _size],b,n);
+		_peers[_count] = peer;
+		_lengths[_count] = n;
+		++_count;
+		return true;
+	}
+	/**
+	*	\brief 發出 發送緩衝區 中的 數據報 不會 掛起
+	*
+	*	socket 不可寫 時 未發出的 數據報 留在 緩衝區 出錯的 數據報 被丟棄
+	*/
+	void flush()
+	{
+		send_all(NULL);
+	}
+private:
+	//發出 所有 數據報 socket 不可寫 時 掛起 協程 等待
+	void flush(boost::asio::yield_context& ctx)
+	{
+		send_all(&ctx);
+	}
+	void send_all(boost::asio::yield_context* ctx)
+	{
+#ifdef __linux__
+		for(std::size_t i=0; i<_count; ++i)
+		{
+			_iovs[i].iov_len = _lengths[i];
+			_msgs[i].msg_hdr.msg_name = _peers[i].data();
+			_msgs[i].msg_hdr.msg_namelen = _peers[i].size();
+		}
+		std::size_t sent = 0;
+		while(sent < _count)
+		{
+			int n = ::sendmmsg(_socket.native_handle(),&_msgs[sent],_count - sent,MSG_DONTWAIT);
+			if(n < 0)
+			{
+				if(errno == EINTR)
+				{
+					continue;
+				}
+				if(errno == EAGAIN || errno == EWOULDBLOCK)
+				{
+					if(!ctx)
+					{
+						//保留 未發出的 數據報
+						keep(sent);
+						return;
+					}
+					//等待 可寫 yield
+					boost::system::error_code ec;
+					_socket.async_wait(udp_socket_t::wait_write,(*ctx)[ec]);
+					if(!ec)
+					{
+						continue;
+					}
+					break;
+				}
+				//丟棄 無法 發送的 數據報
+				++sent;
+				continue;
+			}
+			if(_bytes_out)
+			{
+				for(std::size_t i=sent; i<sent + n; ++i)
+				{
+					_bytes_out->add(_msgs[i].msg_len);
+				}
+			}
+			sent += n;
+		}
+#else
+		boost::system::error_code ec;
+		for(std::size_t i=0; i<_count; ++i)
+		{
+			std::size_t n = _socket.send_to(boost::asio::buffer(&_data[i * _size],_lengths[i]),_peers[i],0,ec);
+			if(!ec && _bytes_out)
+			{
+				_bytes_out->add(n);
+			}
+		}
+#endif // __linux__
+		_count = 0;
+	}
+	//移除 已 發出的 sent 個 數據報 將 其餘的 移到 緩衝區 開頭
+	void keep(std::size_t sent)
+	{
+		if(!sent)
+		{
+			return;
+		}
+		for(std::size_t i=sent; i<_count; ++i)
+		{
+			memcpy(&_data[(i - sent) * _size],&_data[i * _size],_lengths[i]);
+			_peers[i - sent] = _peers[i];
+			_lengths[i - sent] = _lengths[i];
+		}
+		_count -= sent;
+	}
+};
+
+/**
+*	\brief 使用 boost::asio 協程 實現的 udp 服務器
+*
+*	每個 響應服務器 擁有 一個 綁定到 相同地址的 socket (SO_REUSEPORT) 及 一個 線程\n
+*	使用 recvmmsg 一次 讀取 一批 數據報 到 預先申請的 緩衝區 處理後 以 sendmmsg 一次 發出 所有 回覆\n
+*	每個 來源地址 被視爲 一個 連接 首次 收到其 數據報 時 調用 connected 超過 timeout 未活動 後 調用 closed
+*
+*	\attention 回調 在 一批 數據報 的 處理中 被調用 不能 掛起 應 儘快 返回
+*	\param T	用於關聯到 來源地址 的 自定義 session 型別 需要支持 copy 語義
+*/
+template<typename T>
+class basic_udp_server_t
+    : boost::noncopyable
+{
+public:
+	/**
+	*	\brief type_t type_spt
+	*
+	*/
+    KG_TYPEDEF_TT(basic_udp_server_t);
+    /**
+	*	\brief type_t type_spt
+	*
+	*/
+	typedef T session_t;
+private:
+	class peer_t
+	{
+	public:
+		session_t session;
+		//上次 清理後 是否 收到過 數據報
+		bool active;
+		peer_t():session(session_t()),active(true)
+		{
+		}
+	};
+	typedef boost::unordered_map<udp_endpoint_t,peer_t,udp_endpoint_hash_t> peers_t;
+
+    class service_t: boost::noncopyable
+    {
+	private:
+		void close()
+		{
+			boost::system::error_code ec;
+			timer.cancel(ec);
+			socket.close(ec);
+		}
+	public:
+		//asio 服務
+		io_service_t service;
+		//asio work
+		work_spt work;
+		//工作線程
+		thread_spt thread;
+
+		udp_socket_t socket;
+		//清理 未活動 來源地址
+		deadline_timer_t timer;
+
+		//來源地址 只在 工作線程中 使用
+		peers_t peers;
+		//來源地址 數量
+		boost::atomic<std::size_t> clients;
+
+		//統計 只在 工作線程中 寫入
+		service_metrics_t metrics;
+
+		//只有 一個 線程 運行 io_service 告知 asio 以 減少 調度器 的 鎖 與 喚醒
+		service_t()
+			:service(BOOST_ASIO_CONCURRENCY_HINT_1),socket(service),timer(service)
+		{
+			clients = 0;
+		}
+		~service_t()
+		{
+			stop();
+		}
+		void stop()
+		{
+			//在 工作線程中 關閉 socket 使 讀取協程 退出
+			service.post(boost::bind(&service_t::close,this));
+			work.reset();
+
+			//等待 線程退出
+			if(thread)
+			{
+				thread->join();
+				thread.reset();
+			}
+		}
+    };
+    typedef boost::shared_ptr<service_t> service_spt;
+    std::vector<service_spt> _services;
+
+    //來源地址 未活動 超時 時間 如果爲0 永不超時
+    std::size_t _timeout;
+
+    //可選 設定
+    basic_udp_server_options_t _options;
+
+	void init(const std::string& laddr)
+	{
+		//解析地址
+		BOOST_AUTO(find,laddr.find_last_of(':'));
+		if(find == std::string::npos)
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_BASIC_UDP_SERVER_CODE_BAD_ADDR,basic_udp_server_category::get()));
+		}
+		std::string tmp = laddr.substr(find+1);
+		unsigned short port = 0;
+		try
+		{
+			port = boost::lexical_cast<unsigned short>(tmp);
+		}
+		catch(const boost::bad_lexical_cast&)
+		{
+		}
+		if(port == 0)
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_BASIC_UDP_SERVER_CODE_BAD_ADDR,basic_udp_server_category::get()));
+		}
+		tmp = laddr.substr(0,find);
+
+		if(_options.batch < 1)
+		{
+			_options.batch = 1;
+		}
+		if(_options.datagram_size < 1)
+		{
+			_options.datagram_size = KG_NET_UDP_SERVER_DATAGRAM_SIZE;
+		}
+
+		try
+		{
+			udp_endpoint_t endpoint(boost::asio::ip::address::from_string(tmp),port);
+
+			//創建 響應 服務器
+			std::size_t n = _options.threads;
+			if(!n)
+			{
+				n = boost::thread::hardware_concurrency();
+			}
+#ifndef SO_REUSEPORT
+			n = 1;
+#endif // SO_REUSEPORT
+			for(std::size_t i=0; i<n; ++i)
+			{
+				service_spt service = boost::make_shared<service_t>();
+
+				udp_socket_t& s = service->socket;
+				s.open(endpoint.protocol());
+				s.set_option(udp_socket_t::reuse_address(true));
+#ifdef SO_REUSEPORT
+				s.set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET,SO_REUSEPORT>(true));
+#endif // SO_REUSEPORT
+				if(_options.recv_buffer > 0)
+				{
+					s.set_option(boost::asio::socket_base::receive_buffer_size(_options.recv_buffer));
+				}
+				if(_options.send_buffer > 0)
+				{
+					s.set_option(boost::asio::socket_base::send_buffer_size(_options.send_buffer));
+				}
+				s.bind(endpoint);
+				s.non_blocking(true);
+
+				service->work = boost::make_shared<work_t>(service->service);
+
+				int cpu = -1;
+				if(_options.pin_threads)
+				{
+					cpu = _options.cpus.empty() ? int(i) : _options.cpus[i % _options.cpus.size()];
+				}
+				service->thread = boost::make_shared<thread_t>(boost::bind(&type_t::works_thread,this,service.get(),cpu));
+
+				_services.push_back(service);
+			}
+		}
+		catch(const std::bad_alloc&)
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_BASIC_UDP_SERVER_CODE_BAD_ALLOC,basic_udp_server_category::get()));
+		}
+	}
+	void works_thread(service_t* service,int cpu)
+	{
+		if(cpu != -1 && pin_thread(cpu))
+		{
+			numa_local();
+		}
+		service->service.run();
+	}
+public:
+	/**
+	*	\brief 初始化 服務器
+	*
+	*	\exception boost::system::system_error
+	*	\param laddr	服務器監聽地址
+	*	\param timeout	來源地址 未活動 多久後 調用 closed (單位 秒) 爲0 永不超時
+	*
+	*/
+    basic_udp_server_t(const std::string& laddr,std::size_t timeout)
+    	:_timeout(timeout),_run(false)
+    {
+    	init(laddr);
+    }
+    /**
+	*	\brief 初始化 服務器
+	*
+	*	\param laddr	服務器監聽地址
+	*	\param timeout	來源地址 未活動 多久後 調用 closed (單位 秒) 爲0 永不超時
+	*
+	*/
+    basic_udp_server_t(const std::string& laddr,std::size_t timeout,boost::system::error_code& ec)
+    	:_timeout(timeout),_run(false)
+    {
+    	try
+    	{
+    		init(laddr);
+    	}
+    	catch(const boost::system::system_error& e)
+    	{
+    		ec = e.code();
+    	}
+    }
+    /**
+	*	\brief 初始化 服務器
+	*
+	*	\exception boost::system::system_error
+	*	\param laddr	服務器監聽地址
+	*	\param timeout	來源地址 未活動 多久後 調用 closed (單位 秒) 爲0 永不超時
+	*	\param options	可選 設定
+	*
+	*/
+    basic_udp_server_t(const std::string& laddr,std::size_t timeout,const basic_udp_server_options_t& options)
+    	:_timeout(timeout),_options(options),_run(false)
+    {
+    	init(laddr);
+    }
+    /**
+	*	\brief 初始化 服務器
+	*
+	*	\param laddr	服務器監聽地址
+	*	\param timeout	來源地址 未活動 多久後 調用 closed (單位 秒) 爲0 永不超時
+	*	\param options	可選 設定
+	*
+	*/
+    basic_udp_server_t(const std::string& laddr,std::size_t timeout,const basic_udp_server_options_t& options,boost::system::error_code& ec)
+    	:_timeout(timeout),_options(options),_run(false)
+    {
+    	try
+    	{
+    		init(laddr);
+    	}
+    	catch(const boost::system::system_error& e)
+    	{
+    		ec = e.code();
+    	}
+    }
+    ~basic_udp_server_t()
+    {
+    	stop();
+    	_services.clear();
+    }
+public:
+    /**
+	*	\brief 停止 服務器 釋放所有資源
+	*
+	*	所有 來源地址 的 closed 回調 會在 返回前 被調用
+	*/
+    void stop()
+    {
+		boost::mutex::scoped_lock lock(_mutex);
+		if(!_run)
+		{
+			return;
+		}
+		_run = false;
+
+    	//停止 響應服務器
+    	BOOST_FOREACH(service_spt& service,_services)
+		{
+			service->stop();
+		}
+    }
+    /**
+	*	\brief 運行 服務器
+	*	\exception boost::system::system_error
+	*
+	*/
+    void run()
+    {
+		try
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			if(_run)
+			{
+				return;
+			}
+			BOOST_FOREACH(service_spt& service,_services)
+			{
+				boost::asio::spawn(service->service,boost::bind(&type_t::coroutine_read,this,service,_1));
+				if(_timeout)
+				{
+					service->service.post(boost::bind(&type_t::post_sweep,this,service.get()));
+				}
+			}
+			_run = true;
+		}
+		catch(const std::bad_alloc&)
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_BASIC_UDP_SERVER_CODE_BAD_ALLOC,basic_udp_server_category::get()));
+		}
+    }
+	/**
+	*	\brief 運行 服務器
+	*
+	*/
+    void run(boost::system::error_code& ec)
+	{
+		try
+		{
+			run();
+		}
+		catch(const boost::system::system_error& e)
+		{
+			ec = e.code();
+		}
+	}
+	/**
+	*	\brief 等待服務器停止
+	*
+	*/
+	void join()
+	{
+		std::vector<thread_spt> threads;
+		_mutex.lock();
+		BOOST_FOREACH(service_spt& service,_services)
+		{
+			if(service->thread)
+			{
+				threads.push_back(service->thread);
+			}
+		}
+		_mutex.unlock();
+		BOOST_FOREACH(thread_spt& thread,threads)
+		{
+			thread->join();
+		}
+	}
+    /**
+	*	\brief 返回 統計 快照
+	*
+	*	accepts 爲 新的 來源地址 數 active 爲 當前 來源地址 數 reads 爲 收到的 數據報 數\n
+	*	timeouts 爲 因 未活動 被清理的 來源地址 數 不記錄 latency
+	*/
+    server_metrics_t metrics()
+    {
+		server_metrics_t rs;
+		rs.services.resize(_services.size());
+		for(std::size_t i=0; i<_services.size(); ++i)
+		{
+			service_t& service = *_services[i];
+			service.metrics.snapshot(rs.services[i],service.clients);
+			rs.total += rs.services[i];
+		}
+		return rs;
+    }
+    /**
+	*	\brief 返回 當前 來源地址 數
+	*
+	*/
+    std::size_t connections()
+    {
+		std::size_t sum = 0;
+		BOOST_FOREACH(service_spt& service,_services)
+		{
+			sum += service->clients;
+		}
+		return sum;
+    }
+private:
+	bool _run;
+	boost::mutex _mutex;
+
+	void coroutine_read(service_spt sp,boost::asio::yield_context ctx)
+	{
+		service_t& service = *sp;
+		udp_socket_t& s = service.socket;
+		const std::size_t batch = _options.batch;
+		const std::size_t size = _options.datagram_size;
+		try
+		{
+			//在 工作線程中 申請 緩衝區 使其 位於 本地 numa 節點
+			udp_sender_t sender(s,batch,size,&service.metrics.bytes_out);
+			std::vector<kg::byte_t> data(batch * size);
+			std::vector<udp_endpoint_t> peers(batch);
+#ifdef __linux__
+			std::vector<mmsghdr> msgs(batch);
+			std::vector<iovec> iovs(batch);
+			memset(&msgs[0],0,sizeof(mmsghdr) * batch);
+			for(std::size_t i=0; i<batch; ++i)
+			{
+				iovs[i].iov_base = &data[i * size];
+				iovs[i].iov_len = size;
+				msgs[i].msg_hdr.msg_iov = &iovs[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+				msgs[i].msg_hdr.msg_name = peers[i].data();
+			}
+#endif // __linux__
+
+			boost::system::error_code ec;
+			while(true)
+			{
+				//等待 可讀 yield
+				s.async_wait(udp_socket_t::wait_read,ctx[ec]);
+				if(ec)
+				{
+					break;
+				}
+#ifdef __linux__
+				for(std::size_t i=0; i<batch; ++i)
+				{
+					msgs[i].msg_hdr.msg_namelen = peers[i].capacity();
+					msgs[i].msg_hdr.msg_flags = 0;
+				}
+				int n = ::recvmmsg(s.native_handle(),&msgs[0],batch,MSG_DONTWAIT,NULL);
+				if(n < 1)
+				{
+					continue;
+				}
+				for(int i=0; i<n; ++i)
+				{
+					//丟棄 被截斷的 數據報
+					if(msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+					{
+						continue;
+					}
+					peers[i].resize(msgs[i].msg_hdr.msg_namelen);
+					dispatch(service,sender,peers[i],&data[i * size],msgs[i].msg_len);
+				}
+#else
+				std::size_t n = s.receive_from(boost::asio::buffer(&data[0],size),peers[0],0,ec);
+				if(ec)
+				{
+					continue;
+				}
+				dispatch(service,sender,peers[0],&data[0],n);
+#endif // __linux__
+
+				//發出 回覆 socket 不可寫 時 等待 yield
+				sender.flush(ctx);
+			}
+			sender.flush();
+		}
+		catch(const std::bad_alloc&)
+		{
+		}
+
+		//關閉 所有 來源地址
+		BOOST_FOREACH(typename peers_t::value_type& node,service.peers)
+		{
+			if(_closed)
+			{
+				_closed(node.first,node.second.session);
+			}
+		}
+		service.peers.clear();
+		service.clients = 0;
+	}
+	void dispatch(service_t& service,udp_sender_t& sender,const udp_endpoint_t& peer,kg::byte_t* b,std::size_t n)
+	{
+		service.metrics.reads.add();
+		service.metrics.bytes_in.add(n);
+
+		BOOST_AUTO(find,service.peers.find(peer));
+		if(find == service.peers.end())
+		{
+			//新的 來源地址
+			peer_t node;
+			if(_connected && !_connected(sender,peer,node.session))
+			{
+				return;
+			}
+			try
+			{
+				find = service.peers.insert(std::make_pair(peer,node)).first;
+			}
+			catch(const std::bad_alloc&)
+			{
+				if(_closed)
+				{
+					_closed(peer,node.session);
+				}
+				return;
+			}
+			++service.clients;
+			service.metrics.accepts.add();
+		}
+		find->second.active = true;
+
+		if(_readed && !_readed(sender,peer,find->second.session,b,n))
+		{
+			session_t session = find->second.session;
+			service.peers.erase(find);
+			--service.clients;
+			if(_closed)
+			{
+				_closed(peer,session);
+			}
+		}
+	}
+	void post_sweep(service_t* service)
+	{
+		boost::system::error_code ec;
+		service->timer.expires_from_now(boost::posix_time::seconds(_timeout),ec);
+		service->timer.async_wait(boost::bind(&type_t::handler_sweep,this,service,_1));
+	}
+	//清理 一個 週期內 未活動的 來源地址
+	void handler_sweep(service_t* service,const boost::system::error_code& e)
+	{
+		if(e || !service->socket.is_open())
+		{
+			return;
+		}
+		peers_t& peers = service->peers;
+		for(BOOST_AUTO(it,peers.begin()); it != peers.end();)
+		{
+			if(it->second.active)
+			{
+				it->second.active = false;
+				++it;
+				continue;
+			}
+			udp_endpoint_t peer = it->first;
+			session_t session = it->second.session;
+			it = peers.erase(it);
+			--service->clients;
+			service->metrics.timeouts.add();
+			if(_closed)
+			{
+				_closed(peer,session);
+			}
+		}
+		post_sweep(service);
+	}
+public:
+	/**
+	*	\brief 定義 收到 新來源地址 的 數據報 時 回調
+	*
+	*	\return 返回 false 將 丟棄 此數據報 且 不記錄 來源地址
+	*/
+	typedef boost::function<bool(udp_sender_t&,const udp_endpoint_t&,session_t&)> connected_bft;
+	/**
+	*	\brief 定義 來源地址 被移除 時 回調
+	*
+	*/
+	typedef boost::function<void(const udp_endpoint_t&,session_t&)> closed_bft;
+	/**
+	*	\brief 定義 收到 數據報 時 回調
+	*
+	*	使用 udp_sender_t::send 回覆 數據報
+	*
+	*	\return 返回 false 將 移除 來源地址 並調用 closed 回調
+	*/
+	typedef boost::function<bool(udp_sender_t&,const udp_endpoint_t&,session_t&,kg::byte_t*,std::size_t)> readed_bft;
+private:
+	connected_bft _connected;
+	closed_bft _closed;
+	readed_bft _readed;
+public:
+	/**
+	*	\brief 設置 收到 新來源地址 的 數據報 時 回調
+	*
+	*/
+	inline void connected(connected_bft func)
+	{
+		_connected = func;
+	}
+	/**
+	*	\brief 設置 來源地址 被移除 時 回調
+	*
+	*/
+	inline void closed(closed_bft func)
+	{
+		_closed = func;
+	}
+	/**
+	*	\brief 設置 收到 數據報 時 回調
+	*
+	*/
+	inline void readed(readed_bft func)
+	{
+		_readed = func;
+	}
+};
+};
+};
+#endif	//KG_NET_BASIC_UDP_SERVER_HEADER_HPP
@@ -0,0 +1,276 @@
+#ifndef KG_NET_BUFFER_POOL_HEADER_HPP
+#define KG_NET_BUFFER_POOL_HEADER_HPP
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "../types.hpp"
+#include "../allocator.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 讀取緩衝區 內存池
+*
+*	緩衝區 按 2的冪 分級 [min,max] 被歸還的 緩衝區 會被 緩存 以便 其它連接 重用\n
+*	非線程安全 每個 響應服務器 持有一個 只在其 工作線程 中使用
+*
+*	\param Alloc	定義了如何 向os 申請釋放內存
+*/
+template<typename Alloc = kg::allocator_t<kg::byte_t>>
+class basic_buffer_pool_t
+	: boost::noncopyable
+{
+private:
+	Alloc _alloc;
+
+	//最小 緩衝區
+	std::size_t _min;
+	//最大 緩衝區
+	std::size_t _max;
+	//每級 最多 緩存 緩衝區 數量
+	std::size_t _cache;
+
+	//每級 空閒的 緩衝區
+	std::vector<std::vector<kg::byte_t*> > _free;
+public:
+	/**
+	*	\brief 構造 內存池
+	*
+	*	\param min	最小 緩衝區 大小
+	*	\param max	最大 緩衝區 大小
+	*	\param cache	每級 最多 緩存 的 緩衝區 數量
+	*/
+	basic_buffer_pool_t(std::size_t min,std::size_t max,std::size_t cache)
+		:_cache(cache)
+	{
+		_min = round_up(min < 1 ? 1 : min);
+		_max = round_up(max < _min ? _min : max);
+
+		std::size_t n = 1;
+		for(std::size_t size = _min; size < _max; size <<= 1)
+		{
+			++n;
+		}
+		_free.resize(n);
+	}
+	~basic_buffer_pool_t()
+	{
+		clear();
+	}
+	/**
+	*	\brief 釋放 所有 緩存的 緩衝區
+	*
+	*/
+	void clear()
+	{
+		for(std::size_t i=0; i<_free.size(); ++i)
+		{
+			std::vector<kg::byte_t*>& free = _free[i];
+			for(std::size_t j=0; j<free.size(); ++j)
+			{
+				_alloc.destroy_array(free[j]);
+			}
+			free.clear();
+		}
+	}
+	/**
+	*	\brief 返回 最小 緩衝區 大小
+	*
+	*/
+	inline std::size_t min_size()const
+	{
+		return _min;
+	}
+	/**
+	*	\brief 返回 最大 緩衝區 大小
+	*
+	*/
+	inline std::size_t max_size()const
+	{
+		return _max;
+	}
+	/**
+	*	\brief 返回 不小於 size 的 緩衝區 分級大小 (限制在 [min,max])
+	*
+	*/
+	inline std::size_t fit(std::size_t size)const
+	{
+		if(size <= _min)
+		{
+			return _min;
+		}
+		if(size >= _max)
+		{
+			return _max;
+		}
+		return round_up(size);
+	}
+	/**
+	*	\brief 申請 一個 緩衝區
+	*
+	*	\exception std::bad_alloc
+	*	\param size	緩衝區 大小 必須是 fit 返回的值
+	*/
+	kg::byte_t* get(std::size_t size)
+	{
+		std::vector<kg::byte_t*>& free = _free[level(size)];
+		if(free.empty())
+		{
+			return _alloc.create_array(size);
+		}
+		kg::byte_t* b = free.back();
+		free.pop_back();
+		return b;
+	}
+	/**
+	*	\brief 歸還 一個 緩衝區
+	*
+	*	\param b	get 返回的 緩衝區
+	*	\param size	申請時 傳入的 大小
+	*/
+	void put(kg::byte_t* b,std::size_t size)
+	{
+		std::vector<kg::byte_t*>& free = _free[level(size)];
+		if(free.size() >= _cache)
+		{
+			_alloc.destroy_array(b);
+			return;
+		}
+		try
+		{
+			free.push_back(b);
+		}
+		catch(const std::bad_alloc&)
+		{
+			_alloc.destroy_array(b);
+		}
+	}
+private:
+	static std::size_t round_up(std::size_t size)
+	{
+		std::size_t n = 1;
+		while(n < size)
+		{
+			n <<= 1;
+		}
+		return n;
+	}
+	inline std::size_t level(std::size_t size)const
+	{
+		std::size_t i = 0;
+		for(std::size_t n = _min; n < size; n <<= 1)
+		{
+			++i;
+		}
+		return i;
+	}
+};
+/**
+*	\brief 默認的 讀取緩衝區 內存池
+*
+*/
+typedef basic_buffer_pool_t<> buffer_pool_t;
+
+/**
+*	\brief 自適應 大小的 讀取緩衝區
+*
+*	從 內存池 申請 緩衝區 讀取填滿 緩衝區 時 增大 讀取量 遠小於 緩衝區 時 減小\n
+*	析構時 自動 將 緩衝區 歸還 內存池
+*
+*	\param Pool	內存池 型別
+*/
+template<typename Pool = buffer_pool_t>
+class basic_adaptive_buffer_t
+	: boost::noncopyable
+{
+private:
+	Pool& _pool;
+	kg::byte_t* _data;
+	std::size_t _size;
+public:
+	/**
+	*	\brief 構造 緩衝區 此時不會 申請內存
+	*
+	*	\param pool	內存池
+	*	\param size	初始 緩衝區 大小
+	*/
+	basic_adaptive_buffer_t(Pool& pool,std::size_t size)
+		:_pool(pool),_data(NULL)
+	{
+		_size = _pool.fit(size);
+	}
+	~basic_adaptive_buffer_t()
+	{
+		release();
+	}
+	/**
+	*	\brief 返回 緩衝區 如果 沒有 則從 內存池 申請
+	*
+	*	\exception std::bad_alloc
+	*/
+	inline kg::byte_t* get()
+	{
+		if(!_data)
+		{
+			_data = _pool.get(_size);
+		}
+		return _data;
+	}
+	/**
+	*	\brief 返回 緩衝區 大小
+	*
+	*/
+	inline std::size_t size()const
+	{
+		return _size;
+	}
+	/**
+	*	\brief 將 緩衝區 歸還 內存池
+	*
+	*/
+	inline void release()
+	{
+		if(_data)
+		{
+			_pool.put(_data,_size);
+			_data = NULL;
+		}
+	}
+	/**
+	*	\brief 依據 上次 讀取量 調整 緩衝區 大小
+	*
+	*	填滿 緩衝區 時 加倍 不足 四分之一 時 減半\n
+	*	大小 改變時 舊緩衝區 被歸還 內存池 下次 get 時 重新申請
+	*
+	*	\param n	上次 讀取到的 字節數
+	*/
+	void adapt(std::size_t n)
+	{
+		std::size_t size = _size;
+		if(n >= _size)
+		{
+			size = _pool.fit(_size << 1);
+		}
+		else if(n < (_size >> 2))
+		{
+			size = _pool.fit(_size >> 1);
+		}
+		if(size != _size)
+		{
+			release();
+			_size = size;
+		}
+	}
+};
+/**
+*	\brief 默認的 自適應 讀取緩衝區
+*
+*/
+typedef basic_adaptive_buffer_t<> adaptive_buffer_t;
+};
+};
+#endif	//KG_NET_BUFFER_POOL_HEADER_HPP
@@ -0,0 +1,473 @@
+#ifndef KG_NET_CLIENT_POOL_HEADER_HPP
+#define KG_NET_CLIENT_POOL_HEADER_HPP
+
+#include <map>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/enable_shared_from_this.hpp>
+
+#include "async_client.hpp"
+#include "notifier.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 每個 地址 默認 最多 同時 使用的 連接數
+*
+*/
+#define KG_NET_CLIENT_POOL_MAX_INFLIGHT	64
+/**
+*	\brief 每個 地址 默認 最多 保留的 空閒 連接數
+*
+*/
+#define KG_NET_CLIENT_POOL_MAX_IDLE	16
+/**
+*	\brief 默認 空閒 連接 超過 多少秒 不再 使用
+*
+*/
+#define KG_NET_CLIENT_POOL_IDLE_TIMEOUT	60
+
+/**
+*	\brief 按 地址 保存 async_client_t 的 連接池
+*
+*	acquire 優先 使用 空閒 連接 (最近 歸還的 優先) 否則 建立 新 連接\n
+*	每個 地址 同時 被 租用的 連接 不超過 max_inflight 超過 時 協程 按 先後 順序 等待\n
+*	空閒 連接 在 被 取出 與 歸還 時 檢查 健康 (io 未出錯 對端 未關閉 沒有 殘留 數據)\n
+*	空閒 過久 的 連接 由 io_service 上的 定時器 關閉 (所有 地址) 不必 等待 下次 acquire 有 空閒 連接 時 定時器 使 run 不會 返回\n
+*	線程安全 可被 運行在 同一 io_service 多個 線程 上的 協程 共享\n
+*	lease_t 與 定時器 共享 連接池 狀態 lease_t 可以 在 連接池 銷毀 後 釋放 (連接 被 關閉)
+*
+*	\code
+	kg::net::client_pool_t pool(service);
+	//在 協程 中
+	kg::net::client_pool_t::lease_t c = pool.acquire("127.0.0.1:1102",ctx);
+	kg::net::async_client_t::bytes_t b = c->request(data,n,ctx);
+	//c 析構 時 歸還 連接
+	\endcode
+*/
+class client_pool_t
+	: boost::noncopyable
+{
+public:
+	/**
+	*	\brief type_t type_spt
+	*
+	*/
+	KG_TYPEDEF_TT(client_pool_t);
+private:
+	//只在 持有 mutex 時 使用
+	class waiter_t
+	{
+	public:
+		notifier_t notifier;
+		//是否 已 獲得 名額
+		bool granted;
+		waiter_t()
+			:granted(false)
+		{
+		}
+	};
+	typedef boost::shared_ptr<waiter_t> waiter_spt;
+	class idle_t
+	{
+	public:
+		async_client_spt client;
+		boost::posix_time::ptime time;
+		idle_t(async_client_spt client,boost::posix_time::ptime time)
+			:client(client),time(time)
+		{
+		}
+	};
+	class host_t
+	{
+	public:
+		std::size_t inflight;
+		std::vector<idle_t> idle;
+		std::deque<waiter_spt> waiters;
+		host_t():inflight(0)
+		{
+		}
+	};
+	//被 連接池 lease_t 與 清理 定時器 共享 的 狀態
+	class state_t
+		: public boost::enable_shared_from_this<state_t>,
+		boost::noncopyable
+	{
+	public:
+		std::size_t max_inflight;
+		std::size_t max_idle;
+		boost::posix_time::time_duration idle_timeout;
+
+		//以下 只在 持有 mutex 時 使用
+		boost::mutex mutex;
+		std::map<std::string,host_t> hosts;
+		bool stopped;
+		//到期 時 關閉 過期的 空閒 連接
+		deadline_timer_t timer;
+		bool sweeping;
+
+		state_t(io_service_t& service,std::size_t max_inflight,std::size_t max_idle,std::size_t idle_timeout)
+			:max_inflight(max_inflight ? max_inflight : 1),max_idle(max_idle),idle_timeout(boost::posix_time::seconds(idle_timeout)),
+			stopped(false),timer(service),sweeping(false)
+		{
+		}
+		void release(const std::string& addr,async_client_spt client)
+		{
+			async_client_spt closed;
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				host_t& host = hosts[addr];
+				if(client)
+				{
+					if(!stopped && host.idle.size() < max_idle && client->healthy())
+					{
+						host.idle.push_back(idle_t(client,boost::posix_time::microsec_clock::universal_time()));
+						if(!sweeping)
+						{
+							schedule();
+						}
+					}
+					else
+					{
+						closed = client;
+					}
+				}
+				if(host.waiters.empty())
+				{
+					--host.inflight;
+				}
+				else
+				{
+					//直接 轉交 名額 避免 被 新來者 搶佔
+					host.waiters.front()->granted = true;
+					host.waiters.front()->notifier.notify();
+					host.waiters.pop_front();
+				}
+			}
+		}
+		//取消 定時器 需要 持有 mutex
+		void cancel()
+		{
+			boost::system::error_code ec;
+			timer.cancel(ec);
+		}
+	private:
+		//將 定時器 設置到 最早 過期的 空閒 連接 沒有 空閒 連接 時 停止 需要 持有 mutex
+		void schedule()
+		{
+			boost::posix_time::ptime next(boost::posix_time::pos_infin);
+			if(!stopped)
+			{
+				for(BOOST_AUTO(it,hosts.begin());it != hosts.end();++it)
+				{
+					const std::vector<idle_t>& idle = it->second.idle;
+					for(std::size_t i=0;i<idle.size();++i)
+					{
+						next = std::min(next,idle[i].time + idle_timeout);
+					}
+				}
+			}
+			sweeping = !next.is_pos_infinity();
+			if(sweeping)
+			{
+				timer.expires_at(next);
+				timer.async_wait(boost::bind(&state_t::sweep,shared_from_this(),_1));
+			}
+		}
+		void sweep(const boost::system::error_code& /*ec*/)
+		{
+			std::vector<async_client_spt> expired;
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+				for(BOOST_AUTO(it,hosts.begin());it != hosts.end();++it)
+				{
+					std::vector<idle_t>& idle = it->second.idle;
+					std::size_t n = 0;
+					for(std::size_t i=0;i<idle.size();++i)
+					{
+						if(now - idle[i].time < idle_timeout)
+						{
+							idle[n++] = idle[i];
+						}
+						else
+						{
+							expired.push_back(idle[i].client);
+						}
+					}
+					idle.erase(idle.begin() + n,idle.end());
+				}
+				schedule();
+			}
+			//在 鎖外 關閉
+			expired.clear();
+		}
+	};
+	typedef boost::shared_ptr<state_t> state_spt;
+
+	io_service_t& _service;
+	framer_t _framer;
+	std::vector<stage_spt> _stages;
+	socket_options_t _options;
+	state_spt _state;
+public:
+	/**
+	*	\brief 租用的 連接 析構 時 歸還 連接池
+	*
+	*	可 copy 最後 一個 副本 析構 時 歸還 連接池 已經 銷毀 時 關閉 連接
+	*/
+	class lease_t
+	{
+	private:
+		class impl_t
+			: boost::noncopyable
+		{
+		public:
+			state_spt state;
+			std::string addr;
+			async_client_spt client;
+			impl_t(state_spt state,const std::string& addr,async_client_spt client)
+				:state(state),addr(addr),client(client)
+			{
+			}
+			~impl_t()
+			{
+				state->release(addr,client);
+			}
+		};
+		boost::shared_ptr<impl_t> _impl;
+	public:
+		lease_t()
+		{
+		}
+		lease_t(state_spt state,const std::string& addr,async_client_spt client)
+			:_impl(boost::make_shared<impl_t>(state,addr,client))
+		{
+		}
+		inline async_client_t* operator->()const
+		{
+			return _impl->client.get();
+		}
+		inline async_client_t& operator*()const
+		{
+			return *_impl->client;
+		}
+		inline async_client_spt get()const
+		{
+			return _impl ? _impl->client : async_client_spt();
+		}
+	};
+
+	/**
+	*	\param service	連接 與 清理 定時器 使用的 io_service
+	*	\param max_inflight	每個 地址 最多 同時 租用的 連接數
+	*	\param max_idle	每個 地址 最多 保留的 空閒 連接數
+	*	\param idle_timeout	空閒 連接 超過 多少秒 關閉
+	*
+	*	\exception std::bad_alloc
+	*/
+	explicit client_pool_t(io_service_t& service,std::size_t max_inflight = KG_NET_CLIENT_POOL_MAX_INFLIGHT,
+		std::size_t max_idle = KG_NET_CLIENT_POOL_MAX_IDLE,std::size_t idle_timeout = KG_NET_CLIENT_POOL_IDLE_TIMEOUT)
+		:_service(service),_framer(framer_t::length(4)),
+		_state(boost::make_shared<state_t>(boost::ref(service),max_inflight,max_idle,idle_timeout))
+	{
+	}
+	~client_pool_t()
+	{
+		stop();
+	}
+	/**
+	*	\brief 設置 新建 連接 使用的 分幀 規則
+	*
+	*/
+	inline void framer(const framer_t& framer)
+	{
+		_framer = framer;
+	}
+	/**
+	*	\brief 加入 新建 連接 使用的 消息 處理 階段
+	*
+	*	\exception std::bad_alloc
+	*/
+	inline void stage(stage_spt stage)
+	{
+		_stages.push_back(stage);
+	}
+	/**
+	*	\brief 設置 新建 連接 的 socket 選項
+	*
+	*/
+	inline void options(const socket_options_t& options)
+	{
+		_options = options;
+	}
+
+	/**
+	*	\brief 租用 一個 到 addr 的 連接
+	*
+	*	\exception boost::system::system_error
+	*/
+	lease_t acquire(const std::string& addr,const boost::asio::yield_context& ctx)
+	{
+		state_t& state = *_state;
+		async_client_spt client;
+		std::vector<async_client_spt> expired;
+		{
+			boost::mutex::scoped_lock lock(state.mutex);
+			host_t& host = state.hosts[addr];
+			//等待 名額 yield
+			bool granted = false;
+			while(!state.stopped && host.inflight >= state.max_inflight)
+			{
+				waiter_spt waiter = boost::make_shared<waiter_t>();
+				host.waiters.push_back(waiter);
+				try
+				{
+					waiter->notifier.wait(lock,ctx);
+				}
+				catch(...)
+				{
+					host.waiters.erase(std::find(host.waiters.begin(),host.waiters.end(),waiter));
+					throw;
+				}
+				if(waiter->granted)
+				{
+					//名額 由 歸還者 直接 轉交 inflight 未減少
+					granted = true;
+					break;
+				}
+			}
+			if(state.stopped)
+			{
+				if(granted)
+				{
+					--host.inflight;
+				}
+				BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ASYNC_CLIENT_CODE_POOL_STOPPED,async_client_category::get()));
+			}
+			if(!granted)
+			{
+				++host.inflight;
+			}
+
+			//取出 最近 歸還的 健康 連接
+			const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+			while(!host.idle.empty())
+			{
+				idle_t idle = host.idle.back();
+				host.idle.pop_back();
+				if(now - idle.time < state.idle_timeout && idle.client->healthy())
+				{
+					client = idle.client;
+					break;
+				}
+				expired.push_back(idle.client);
+			}
+		}
+		//在 鎖外 關閉
+		expired.clear();
+		if(client)
+		{
+			return lease_t(_state,addr,client);
+		}
+
+		try
+		{
+			//connect yield
+			client = boost::make_shared<async_client_t>(boost::ref(_service),_framer);
+			client->options(_options);
+			for(std::size_t i=0;i<_stages.size();++i)
+			{
+				client->stage(_stages[i]);
+			}
+			client->connect(addr,ctx);
+		}
+		catch(...)
+		{
+			state.release(addr,async_client_spt());
+			throw;
+		}
+		return lease_t(_state,addr,client);
+	}
+	/**
+	*	\brief 租用 一個 到 addr 的 連接
+	*
+	*/
+	lease_t acquire(const std::string& addr,const boost::asio::yield_context& ctx,boost::system::error_code& ec)
+	{
+		try
+		{
+			return acquire(addr,ctx);
+		}
+		catch(const boost::system::system_error& e)
+		{
+			ec = e.code();
+		}
+		catch(const std::bad_alloc&)
+		{
+			ec = boost::system::error_code(KG_NET_ASYNC_CLIENT_CODE_BAD_ALLOC,async_client_category::get());
+		}
+		return lease_t();
+	}
+	/**
+	*	\brief 租用 連接 發送 請求 並 讀取 響應
+	*
+	*	\exception boost::system::system_error
+	*/
+	async_client_t::bytes_t request(const std::string& addr,const kg::byte_t* b,std::size_t n,const boost::asio::yield_context& ctx)
+	{
+		lease_t client = acquire(addr,ctx);
+		return client->request(b,n,ctx);
+	}
+	/**
+	*	\brief 返回 addr 當前 租用中 與 空閒 的 連接數
+	*
+	*/
+	void count(const std::string& addr,std::size_t& inflight,std::size_t& idle)
+	{
+		boost::mutex::scoped_lock lock(_state->mutex);
+		BOOST_AUTO(find,_state->hosts.find(addr));
+		inflight = idle = 0;
+		if(find != _state->hosts.end())
+		{
+			inflight = find->second.inflight;
+			idle = find->second.idle.size();
+		}
+	}
+	/**
+	*	\brief 關閉 所有 空閒 連接 喚醒 所有 等待者 停止 清理 定時器 之後 acquire 拋出 異常
+	*
+	*/
+	void stop()
+	{
+		std::vector<async_client_spt> idle;
+		{
+			boost::mutex::scoped_lock lock(_state->mutex);
+			_state->stopped = true;
+			_state->cancel();
+			for(BOOST_AUTO(it,_state->hosts.begin());it != _state->hosts.end();++it)
+			{
+				host_t& host = it->second;
+				for(std::size_t i=0;i<host.idle.size();++i)
+				{
+					idle.push_back(host.idle[i].client);
+				}
+				host.idle.clear();
+				while(!host.waiters.empty())
+				{
+					host.waiters.front()->notifier.notify();
+					host.waiters.pop_front();
+				}
+			}
+		}
+	}
+};
+
+};
+};
+#endif // KG_NET_CLIENT_POOL_HEADER_HPP
@@ -0,0 +1,272 @@
+#ifndef KG_NET_COMPRESSOR_HEADER_HPP
+#define KG_NET_COMPRESSOR_HEADER_HPP
+
+#include <cstring>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_array.hpp>
+
+#include <zlib.h>
+
+#include "../types.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 默認 超過 多少 字節 的 消息 才 壓縮
+*
+*/
+#define KG_NET_COMPRESS_THRESHOLD	1024
+/**
+*	\brief 默認 解壓後 最大 長度
+*
+*/
+#define KG_NET_COMPRESS_MAX	(64 * 1024 * 1024)
+/**
+*	\brief 消息體 標記 未壓縮
+*
+*/
+#define KG_NET_COMPRESS_FLAG_RAW	0
+/**
+*	\brief 消息體 標記 deflate 壓縮
+*
+*/
+#define KG_NET_COMPRESS_FLAG_DEFLATE	1
+/**
+*	\brief 壓縮 消息體 頭部 長度 (標記 + 原始長度)
+*
+*/
+#define KG_NET_COMPRESS_HEADER	5
+/**
+*	\brief 解壓 輸出 緩衝區 最小 初始 容量
+*
+*/
+#define KG_NET_COMPRESS_INFLATE_MIN	4096
+
+/**
+*	\brief 消息體 壓縮器 (zlib raw deflate)
+*
+*	編碼後的 消息體 爲 1字節 標記 KG_NET_COMPRESS_FLAG_*\n
+*	標記 爲 KG_NET_COMPRESS_FLAG_DEFLATE 時 之後 是 4字節 大端 原始長度 與 deflate 數據 否則 之後 是 原始數據\n
+*	每個 消息 獨立 壓縮 (不共享 字典) 壓縮器 只 重置 不 重新 分配 zlib 狀態 可被 重複使用\n
+*	非線程安全
+*/
+class compressor_t
+	: boost::noncopyable
+{
+private:
+	z_stream _deflate;
+	z_stream _inflate;
+	bool _deflate_init;
+	bool _inflate_init;
+	int _level;
+	std::size_t _threshold;
+	std::size_t _max;
+public:
+	/**
+	*	\param threshold	消息 長度 達到 此值 才 壓縮
+	*	\param level	zlib 壓縮 等級 Z_DEFAULT_COMPRESSION 或 0-9
+	*	\param max	解壓後 最大 長度 超過 視爲 錯誤
+	*/
+	explicit compressor_t(std::size_t threshold = KG_NET_COMPRESS_THRESHOLD,int level = Z_DEFAULT_COMPRESSION,std::size_t max = KG_NET_COMPRESS_MAX)
+		:_deflate_init(false),_inflate_init(false),_level(level),_threshold(threshold),_max(max)
+	{
+	}
+	~compressor_t()
+	{
+		if(_deflate_init)
+		{
+			deflateEnd(&_deflate);
+		}
+		if(_inflate_init)
+		{
+			inflateEnd(&_inflate);
+		}
+	}
+	/**
+	*	\brief 返回 長 n 的 消息體 是否 嘗試 壓縮
+	*
+	*/
+	inline bool compressible(std::size_t n)const
+	{
+		return n && n >= _threshold && n <= 0xffffffff;
+	}
+	/**
+	*	\brief 以 KG_NET_COMPRESS_FLAG_DEFLATE 編碼 消息體
+	*
+	*	壓縮後 沒有 變小 時 不寫入 調用者 應 在 原始數據 前 加上 KG_NET_COMPRESS_FLAG_RAW 發送
+	*
+	*	\param out	至少 KG_NET_COMPRESS_HEADER + n 字節
+	*	\return 寫入 out 的 字節數 未 壓縮 (長度 未 達到 閾值 未變小 或 內存 不足) 返回0
+	*/
+	std::size_t compress(const kg::byte_t* b,std::size_t n,kg::byte_t* out)
+	{
+		if(!compressible(n))
+		{
+			return 0;
+		}
+		//輸出 空間 只 容納 比 原始數據 小 的 結果
+		std::size_t size = deflate(b,n,out + KG_NET_COMPRESS_HEADER,n - 1);
+		if(!size)
+		{
+			return 0;
+		}
+		out[0] = KG_NET_COMPRESS_FLAG_DEFLATE;
+		out[1] = kg::byte_t(n >> 24);
+		out[2] = kg::byte_t(n >> 16);
+		out[3] = kg::byte_t(n >> 8);
+		out[4] = kg::byte_t(n);
+		return KG_NET_COMPRESS_HEADER + size;
+	}
+	/**
+	*	\brief 解析 消息體 標記
+	*
+	*	\param size	返回 解碼後 長度
+	*	\return KG_NET_COMPRESS_FLAG_* 數據 非法 或 超過 最大長度 返回 -1
+	*/
+	int peek(const kg::byte_t* b,std::size_t n,std::size_t& size)const
+	{
+		if(!n)
+		{
+			return -1;
+		}
+		if(b[0] == KG_NET_COMPRESS_FLAG_RAW)
+		{
+			size = n - 1;
+			return KG_NET_COMPRESS_FLAG_RAW;
+		}
+		if(b[0] != KG_NET_COMPRESS_FLAG_DEFLATE || n < KG_NET_COMPRESS_HEADER)
+		{
+			return -1;
+		}
+		size = (std::size_t(b[1]) << 24) | (std::size_t(b[2]) << 16) | (std::size_t(b[3]) << 8) | std::size_t(b[4]);
+		if(size > _max)
+		{
+			return -1;
+		}
+		return KG_NET_COMPRESS_FLAG_DEFLATE;
+	}
+	/**
+	*	\brief 將 標記 爲 KG_NET_COMPRESS_FLAG_DEFLATE 的 消息體 解壓到 新分配的 out
+	*
+	*	輸出 緩衝區 隨 解壓 產生的 數據 倍增 不會 按 對端 聲明的 長度 預先 分配\n
+	*	解壓 出的 數據 超過 size 時 立刻 失敗 如此 內存 只與 實際 解壓 出的 數據量 成正比
+	*
+	*	\param size	peek 返回的 原始長度 調用者 需要 已 檢查 其 不超過 限制
+	*	\return 數據 非法 或 內存 不足 時 返回 false
+	*/
+	bool inflate(const kg::byte_t* b,std::size_t n,std::size_t size,boost::shared_array<kg::byte_t>& out)
+	{
+		if(n < KG_NET_COMPRESS_HEADER)
+		{
+			return false;
+		}
+		b += KG_NET_COMPRESS_HEADER;
+		n -= KG_NET_COMPRESS_HEADER;
+		if(!reset_inflate())
+		{
+			return false;
+		}
+		try
+		{
+			//多 保留 1 字節 用於 發現 超出 聲明 長度 的 輸出
+			const std::size_t max = size + 1;
+			//以 輸入 長度 估計 初始 容量
+			std::size_t capacity = n < KG_NET_COMPRESS_INFLATE_MIN / 4 ? KG_NET_COMPRESS_INFLATE_MIN : n * 4;
+			if(capacity > max)
+			{
+				capacity = max;
+			}
+			boost::shared_array<kg::byte_t> data(new kg::byte_t[capacity]);
+			_inflate.next_in = (Bytef*)b;
+			_inflate.avail_in = uInt(n);
+			_inflate.next_out = data.get();
+			_inflate.avail_out = uInt(capacity);
+			while(true)
+			{
+				int rs = ::inflate(&_inflate,Z_NO_FLUSH);
+				if(rs == Z_STREAM_END)
+				{
+					break;
+				}
+				else if(rs != Z_OK && rs != Z_BUF_ERROR)
+				{
+					return false;
+				}
+				//輸入 已 用盡 仍未 結束
+				if(_inflate.avail_out)
+				{
+					return false;
+				}
+				//輸出 超過 聲明的 原始長度
+				if(capacity == max)
+				{
+					return false;
+				}
+				std::size_t grow = capacity * 2 < max ? capacity * 2 : max;
+				boost::shared_array<kg::byte_t> tmp(new kg::byte_t[grow]);
+				std::memcpy(tmp.get(),data.get(),capacity);
+				data.swap(tmp);
+				_inflate.next_out = data.get() + capacity;
+				_inflate.avail_out = uInt(grow - capacity);
+				capacity = grow;
+			}
+			//輸出 必須 恰好 是 聲明的 原始長度
+			if(_inflate.avail_in || capacity - _inflate.avail_out != size)
+			{
+				return false;
+			}
+			out.swap(data);
+		}
+		catch(const std::bad_alloc&)
+		{
+			return false;
+		}
+		return true;
+	}
+private:
+	std::size_t deflate(const kg::byte_t* b,std::size_t n,kg::byte_t* out,std::size_t capacity)
+	{
+		if(_deflate_init)
+		{
+			deflateReset(&_deflate);
+		}
+		else
+		{
+			std::memset(&_deflate,0,sizeof(_deflate));
+			if(deflateInit2(&_deflate,_level,Z_DEFLATED,-MAX_WBITS,8,Z_DEFAULT_STRATEGY) != Z_OK)
+			{
+				return 0;
+			}
+			_deflate_init = true;
+		}
+		_deflate.next_in = (Bytef*)b;
+		_deflate.avail_in = uInt(n);
+		_deflate.next_out = out;
+		_deflate.avail_out = uInt(capacity);
+		if(::deflate(&_deflate,Z_FINISH) != Z_STREAM_END)
+		{
+			return 0;
+		}
+		return capacity - _deflate.avail_out;
+	}
+	bool reset_inflate()
+	{
+		if(_inflate_init)
+		{
+			return inflateReset(&_inflate) == Z_OK;
+		}
+		std::memset(&_inflate,0,sizeof(_inflate));
+		if(inflateInit2(&_inflate,-MAX_WBITS) != Z_OK)
+		{
+			return false;
+		}
+		_inflate_init = true;
+		return true;
+	}
+};
+};
+};
+#endif	//KG_NET_COMPRESSOR_HEADER_HPP
@@ -0,0 +1,393 @@
+#ifndef KG_NET_CONNECTION_HEADER_HPP
+#define KG_NET_CONNECTION_HEADER_HPP
+
+#include <deque>
+#include <vector>
+#include <cstring>
+
+#include <boost/asio/spawn.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+
+#include "types.hpp"
+#include "metrics.hpp"
+
+namespace kg
+{
+namespace net
+{
+#ifndef KG_NET_CONNECTION_HIGH_WATERMARK
+#define KG_NET_CONNECTION_HIGH_WATERMARK	(1024 * 1024)
+#endif // KG_NET_CONNECTION_HIGH_WATERMARK
+
+#ifndef KG_NET_CONNECTION_LOW_WATERMARK
+#define KG_NET_CONNECTION_LOW_WATERMARK	(256 * 1024)
+#endif // KG_NET_CONNECTION_LOW_WATERMARK
+
+#ifndef KG_NET_CONNECTION_MAX_GATHER
+#define KG_NET_CONNECTION_MAX_GATHER	64
+#endif // KG_NET_CONNECTION_MAX_GATHER
+
+/**
+*	\brief 帶 異步發送隊列的 tcp 連接
+*
+*	send 可在 任意線程 調用 消息 被加入 隊列 由 連接所屬 io_service 線程 寫出\n
+*	寫出時 將 隊列中 所有 待發送消息 合併爲 一次 gather write 並保證 完整寫出\n
+*	待發送 字節數 超過 高水位 時 send 拒絕 新消息 生產者 可使用 wait_writable 等待 回落到 低水位
+*
+*	\attention 使用 send 後 不要 再直接 調用 async_write_some 等 寫函數 否則 數據流 會被 打亂
+*/
+class connection_t
+	: public socket_t,
+	public boost::enable_shared_from_this<connection_t>
+{
+public:
+	/**
+	*	\brief type_t type_spt
+	*
+	*/
+	KG_TYPEDEF_TT(connection_t);
+private:
+	class message_t
+	{
+	public:
+		boost::shared_array<kg::byte_t> data;
+		//消息 在 data 中的 起始位置
+		std::size_t offset;
+		std::size_t size;
+		message_t(boost::shared_array<kg::byte_t> data,std::size_t offset,std::size_t size)
+			:data(data),offset(offset),size(size)
+		{
+		}
+	};
+
+	mutable boost::mutex _mutex;
+	//待發送 消息
+	std::deque<message_t> _queue;
+	//正在 寫出的 消息 只在 寫出時 使用
+	std::vector<message_t> _writing;
+	std::vector<boost::asio::const_buffer> _buffers;
+	//待發送 字節數 (包括 正在寫出的)
+	std::size_t _pending;
+	//是否 正在 寫出
+	bool _busy;
+	//寫出 錯誤
+	boost::system::error_code _error;
+
+	std::size_t _high;
+	std::size_t _low;
+
+	//等待 可寫 的 協程 只在 io_service 線程中 使用
+	deadline_timer_t _writable;
+
+	//寫出 字節數 統計 只在 io_service 線程中 寫入
+	counter_t* _bytes_out;
+
+	//accept 時 記錄的 對端 地址
+	boost::asio::ip::address _peer;
+
+	//連接 id
+	kg::uint64_t _id;
+public:
+	/**
+	*	\brief 構造 連接
+	*
+	*	\param service	連接 所屬的 io_service
+	*/
+	explicit connection_t(io_service_t& service)
+		:socket_t(service),_pending(0),_busy(false),
+		_high(KG_NET_CONNECTION_HIGH_WATERMARK),_low(KG_NET_CONNECTION_LOW_WATERMARK),
+		_writable(service),_bytes_out(NULL),_id(0)
+	{
+		_writable.expires_at(boost::posix_time::pos_infin);
+	}
+	/**
+	*	\brief 構造 io 與 寫出 都在 strand 上 執行的 連接
+	*
+	*	用於 多線程 運行的 io_service 讀取 與 關閉 也需要 在 此 strand 上 執行
+	*
+	*	\param strand	連接 使用的 strand
+	*/
+	explicit connection_t(const strand_t& strand)
+		:socket_t(strand),_pending(0),_busy(false),
+		_high(KG_NET_CONNECTION_HIGH_WATERMARK),_low(KG_NET_CONNECTION_LOW_WATERMARK),
+		_writable(strand),_bytes_out(NULL),_id(0)
+	{
+		_writable.expires_at(boost::posix_time::pos_infin);
+	}
+	/**
+	*	\brief 設置 發送隊列 高低水位 (字節)
+	*
+	*	\param high	待發送 字節數 超過 high 時 send 拒絕 新消息
+	*	\param low	待發送 字節數 回落到 low 時 喚醒 wait_writable
+	*/
+	void watermarks(std::size_t high,std::size_t low)
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		_high = high;
+		_low = low > high ? high : low;
+	}
+	/**
+	*	\brief 設置 寫出 字節數 統計 計數器
+	*
+	*	計數器 只在 連接所屬 io_service 線程中 寫入
+	*/
+	inline void metrics(counter_t* bytes_out)
+	{
+		_bytes_out = bytes_out;
+	}
+	/**
+	*	\brief 設置 連接 id
+	*
+	*/
+	inline void id(kg::uint64_t id)
+	{
+		_id = id;
+	}
+	/**
+	*	\brief 返回 連接 id 在 服務器中 唯一 不會 被 重用
+	*
+	*/
+	inline kg::uint64_t id()const
+	{
+		return _id;
+	}
+	/**
+	*	\brief 記錄 對端 地址
+	*
+	*/
+	inline void peer(const boost::asio::ip::address& address)
+	{
+		_peer = address;
+	}
+	/**
+	*	\brief 返回 accept 時 記錄的 對端 地址 無需 系統調用
+	*
+	*	unix 域 socket 返回 未指定 地址
+	*/
+	inline const boost::asio::ip::address& peer()const
+	{
+		return _peer;
+	}
+	/**
+	*	\brief 返回 待發送 字節數
+	*
+	*/
+	std::size_t pending()const
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		return _pending;
+	}
+	/**
+	*	\brief 返回 是否 可以 繼續 send
+	*
+	*/
+	bool writable()const
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		return !_error && _pending < _high;
+	}
+	/**
+	*	\brief 將 消息 拷貝 到 發送隊列
+	*
+	*	線程安全
+	*
+	*	\return 連接已出錯 或 超過 高水位 時 返回 false 消息 不會被 發送
+	*/
+	bool send(const kg::byte_t* b,std::size_t n)
+	{
+		if(!n)
+		{
+			return true;
+		}
+		if(!writable())
+		{
+			return false;
+		}
+		boost::shared_array<kg::byte_t> data;
+		try
+		{
+			data.reset(new kg::byte_t[n]);
+		}
+		catch(const std::bad_alloc&)
+		{
+			return false;
+		}
+		memcpy(data.get(),b,n);
+		return send(data,n);
+	}
+	/**
+	*	\brief 將 消息 加入 發送隊列 不拷貝 數據
+	*
+	*	線程安全 在 消息 寫出前 不要 修改 data
+	*
+	*	\return 連接已出錯 或 超過 高水位 時 返回 false 消息 不會被 發送
+	*/
+	bool send(boost::shared_array<kg::byte_t> data,std::size_t n)
+	{
+		return send(data,0,n);
+	}
+	/**
+	*	\brief 將 data 中 由 offset 開始的 n 字節 加入 發送隊列 不拷貝 數據
+	*
+	*	線程安全 在 消息 寫出前 不要 修改 data
+	*
+	*	\return 連接已出錯 或 超過 高水位 時 返回 false 消息 不會被 發送
+	*/
+	bool send(boost::shared_array<kg::byte_t> data,std::size_t offset,std::size_t n)
+	{
+		if(!n)
+		{
+			return true;
+		}
+		boost::mutex::scoped_lock lock(_mutex);
+		if(_error || _pending >= _high)
+		{
+			return false;
+		}
+		try
+		{
+			_queue.push_back(message_t(data,offset,n));
+		}
+		catch(const std::bad_alloc&)
+		{
+			return false;
+		}
+		_pending += n;
+
+		if(!_busy)
+		{
+			_busy = true;
+			boost::asio::post(get_executor(),boost::bind(&connection_t::do_write,shared_from_this()));
+		}
+		return true;
+	}
+	/**
+	*	\brief 掛起 協程 直到 待發送 字節數 回落到 低水位
+	*
+	*	只能在 連接所屬 io_service 的 協程中 調用 以 strand 構造 時 只能在 此 strand 的 協程中 調用
+	*
+	*	\exception boost::system::system_error 連接 寫出 出錯
+	*/
+	void wait_writable(boost::asio::yield_context ctx)
+	{
+		wait_pending(_low,ctx);
+	}
+	/**
+	*	\brief 掛起 協程 直到 發送隊列 全部寫出
+	*
+	*	只能在 連接所屬 io_service 的 協程中 調用 以 strand 構造 時 只能在 此 strand 的 協程中 調用
+	*
+	*	\exception boost::system::system_error 連接 寫出 出錯
+	*/
+	void flush(boost::asio::yield_context ctx)
+	{
+		wait_pending(0,ctx);
+	}
+private:
+	void wait_pending(std::size_t limit,boost::asio::yield_context ctx)
+	{
+		boost::system::error_code ec;
+		while(true)
+		{
+			{
+				boost::mutex::scoped_lock lock(_mutex);
+				if(_error)
+				{
+					BOOST_THROW_EXCEPTION(boost::system::system_error(_error));
+				}
+				if(_pending <= limit)
+				{
+					return;
+				}
+			}
+			_writable.async_wait(ctx[ec]);
+		}
+	}
+	void do_write()
+	{
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			//合併 待發送 消息
+			std::size_t n = _queue.size();
+			if(n > KG_NET_CONNECTION_MAX_GATHER)
+			{
+				n = KG_NET_CONNECTION_MAX_GATHER;
+			}
+			for(std::size_t i=0; i<n; ++i)
+			{
+				_writing.push_back(_queue.front());
+				_queue.pop_front();
+			}
+		}
+
+		_buffers.clear();
+		BOOST_FOREACH(const message_t& msg,_writing)
+		{
+			_buffers.push_back(boost::asio::buffer(msg.data.get() + msg.offset,msg.size));
+		}
+		boost::asio::async_write(*this,_buffers,
+			boost::bind(&connection_t::handler_write,shared_from_this(),boost::asio::placeholders::error,boost::asio::placeholders::bytes_transferred)
+		);
+	}
+	void handler_write(const boost::system::error_code& e,std::size_t n)
+	{
+		_writing.clear();
+		bool next = false;
+		bool wake;
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			if(e)
+			{
+				//丟棄 所有 待發送 消息
+				_error = e;
+				_queue.clear();
+				_pending = 0;
+			}
+			else
+			{
+				_pending -= n;
+			}
+			if(_bytes_out)
+			{
+				_bytes_out->add(n);
+			}
+			if(_queue.empty())
+			{
+				_busy = false;
+			}
+			else
+			{
+				next = true;
+			}
+			wake = _error || _pending <= _low;
+		}
+
+		if(wake)
+		{
+			boost::system::error_code ec;
+			_writable.cancel(ec);
+		}
+		if(e)
+		{
+			//關閉 連接 通知 讀取協程
+			boost::system::error_code ec;
+			shutdown(socket_t::shutdown_both,ec);
+			close(ec);
+			return;
+		}
+		if(next)
+		{
+			do_write();
+		}
+	}
+};
+/**
+*	\brief 連接 智能指針
+*
+*/
+typedef connection_t::type_spt connection_spt;
+};
+};
+#endif	//KG_NET_CONNECTION_HEADER_HPP
@@ -1,11 +1,19 @@
 #ifndef KG_NET_ECHO_CLIENT_HEADER_HPP
 #define KG_NET_ECHO_CLIENT_HEADER_HPP
 
+#include <vector>
+#include <climits>
+
 #include <boost/typeof/typeof.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/array.hpp>
 
 #include "types.hpp"
-#include "../bytes/buffer.hpp"
+#include "socket_options.hpp"
+#include "local.hpp"
+#include "framer.hpp"
+#include "stage.hpp"
+#include "receive_buffer.hpp"
 #include "../slice.hpp"
 
 namespace kg
@@ -16,6 +24,7 @@ namespace net
 #define KG_NET_ECHO_CLIENT_CODE_BAD_ALLOC		1
 #define KG_NET_ECHO_CLIENT_CODE_BAD_ADDR		100
 #define KG_NET_ECHO_CLIENT_CODE_BAD_MSG_HEADER	200
+#define KG_NET_ECHO_CLIENT_CODE_BAD_MSG	201
 /**
 *	\brief echo_client_t 異常定義
 *
@@ -41,6 +50,8 @@ public:
             return msg + "bad listen address";
 		case KG_NET_ECHO_CLIENT_CODE_BAD_MSG_HEADER:
 			return msg + "bad msg header";
+		case KG_NET_ECHO_CLIENT_CODE_BAD_MSG:
+			return msg + "bad msg";
         }
         return msg + "unknow";
     }
@@ -71,21 +82,27 @@ private:
 	socket_t _socket;
 
 	int _headerSize;
-	kg::bytes::buffer_t<> _buffer;
+	receive_buffer_t _buffer;
+	//當前 消息 長度 未解析 時 爲 -1
 	int _size;
-	kg::byte_t _data[1024];
 
 	bytes_t _empty_bytes;
+
+	socket_options_t _options;
+
+	framer_t _framer;
+	std::vector<stage_spt> _stages;
 public:
 	/**
 	*	\brief 初始化 服務器
 	*
 	*	\exception std::bad_alloc
 	*	\param headerSize	消息頭 長度
+	*	\param read	每次 讀取 至少 準備的 緩衝區 字節數
 	*
 	*/
-    echo_client_t(int headerSize)
-    	:_socket(_service),_size(-1)
+    echo_client_t(int headerSize,std::size_t read = KG_NET_RECEIVE_BUFFER_SIZE)
+    	:_socket(_service),_buffer(read),_size(-1)
 	{
 		if(headerSize > -1)
 		{
@@ -112,14 +129,73 @@ public:
 	{
 		return _socket;
 	}
+	/**
+	*	\brief 設置 socket 選項 在 之後的 connect 中 生效
+	*
+	*	連接 unix 域 socket 時 不設置
+	*/
+	inline void options(const socket_options_t& options)
+	{
+		_options = options;
+	}
+	/**
+	*	\brief 設置 內置 分幀 規則 設置後 不再 調用 reader 回調
+	*
+	*/
+	inline void framer(const framer_t& framer)
+	{
+		_framer = framer;
+	}
+	/**
+	*	\brief 加入 消息 處理 階段 需要 與 服務器 echo_server_t::stage 順序 一致
+	*
+	*	read 返回 去掉 幀頭 並 按 加入 順序 解碼 後的 消息體 write 按 相反 順序 編碼\n
+	*	read 支持 長度前綴 分幀 與 reader 分幀 write 需要 長度前綴 framer
+	*
+	*	\exception std::bad_alloc
+	*/
+	inline void stage(stage_spt stage)
+	{
+		_stages.push_back(stage);
+	}
+	/**
+	*	\brief 加入 compress_stage_t 壓縮 消息體
+	*
+	*	\exception std::bad_alloc
+	*/
+	inline void compression(std::size_t threshold = KG_NET_COMPRESS_THRESHOLD,int level = Z_DEFAULT_COMPRESSION)
+	{
+		stage(boost::make_shared<compress_stage_t>(threshold,level));
+	}
+	/**
+	*	\brief 加入 crypto_stage_t 使用 k3xsx_salt_t 加密 消息體
+	*
+	*	\exception std::bad_alloc
+	*/
+	inline void encryption(const kg::byte_t salt = 0)
+	{
+		stage(boost::make_shared<crypto_stage_t>(salt));
+	}
 
 	/**
 	*	\brief 連接服務器
 	*
 	*	\exception boost::system::system_error
+	*	\param addr	服務器地址 host:port 或 unix:/path
 	*/
 	void connect(const std::string& addr)
 	{
+		std::string path;
+		if(is_local_address(addr,path))
+		{
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+			connect_local(_socket,path);
+			return;
+#else
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ECHO_CLIENT_CODE_BAD_ADDR,echo_client_category::get()));
+#endif // BOOST_ASIO_HAS_LOCAL_SOCKETS
+		}
+
 		//解析地址
 		BOOST_AUTO(find,addr.find_last_of(':'));
 		if(find == std::string::npos)
@@ -143,10 +219,12 @@ public:
 
 		//connect
 		_socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string(tmp),port));
+		_options.apply(_socket);
 	}
 	/**
 	*	\brief 連接服務器
 	*
+	*	\param addr	服務器地址 host:port 或 unix:/path
 	*/
 	void connect(const std::string& addr,boost::system::error_code& ec)
 	{
@@ -188,6 +266,8 @@ public:
 	/**
 	*	\brief 解析出一個 消息
 	*
+	*	返回的 消息 引用 接收 緩衝區 不拷貝 (stage 解碼 到 新 緩衝區 時 除外)
+	*
 	*	\exception boost::system::system_error
 	*	\param b	在進行解析前 寫入到解析器的 數據
 	*	\param n	在進行解析前 寫入到解析器的 數據 長度
@@ -196,16 +276,29 @@ public:
 	{
 		try
 		{
-			if(b)
+			if(b && n)
 			{
-				if(n != _buffer.write(_data,n))
-				{
-					BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ECHO_CLIENT_CODE_BAD_ALLOC,echo_client_category::get()));
-				}
+				std::memcpy(boost::asio::buffer_cast<kg::byte_t*>(_buffer.prepare(n)),b,n);
+				_buffer.commit(n);
 			}
 
 			/***	解消息	***/
-			if(_size == -1)
+			if(_size == -1 && _framer.kind() != KG_NET_FRAMER_NONE)
+			{
+				//未讀取的 數據 是 連續的 直接 由 分幀 規則 解析 幀長
+				frame_t frame;
+				int rs = _framer.decode(_buffer.data(),_buffer.size(),frame);
+				if(rs == KG_NET_FRAME_MORE)
+				{
+					return _empty_bytes;
+				}
+				else if(rs != KG_NET_FRAME_OK || !frame.size || frame.size > std::size_t(INT_MAX))
+				{
+					BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ECHO_CLIENT_CODE_BAD_MSG_HEADER,echo_client_category::get()));
+				}
+				_size = int(frame.size);
+			}
+			else if(_size == -1)
 			{
 				//讀取包頭
 				if(_headerSize == 0)
@@ -214,15 +307,13 @@ public:
 				}
 				else
 				{
-					if(_buffer.size()<_headerSize)
+					if(_buffer.size() < std::size_t(_headerSize))
 					{
 						//等待 包頭
 						return _empty_bytes;
 					}
 					//解析包頭
-					boost::shared_array<kg::byte_t> header(new kg::byte_t[_headerSize]);
-					_buffer.copy_to(header.get(),_headerSize);
-					_size = _reader(header.get(),_headerSize);
+					_size = _reader(_buffer.data(),_headerSize);
 				}
 
 				//解包錯誤
@@ -232,21 +323,24 @@ public:
 				}
 			}
 
-			if(_buffer.size() < _size)
+			if(_buffer.size() < std::size_t(_size))
 			{
 				//等待 body
 				return _empty_bytes;
 			}
 
-			//返回消息
-			bytes_t msg(_size);
-			_buffer.read(msg.get(),_size);
+			//返回消息 引用 接收 緩衝區
+			bytes_t msg = _buffer.slice(_size);
 			_size = -1;
+			if(!_stages.empty())
+			{
+				return decode(msg);
+			}
 			return msg;
 		}
 		catch(const std::bad_alloc&)
 		{
-
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ECHO_CLIENT_CODE_BAD_ALLOC,echo_client_category::get()));
 		}
 		return _empty_bytes;
 	}
@@ -272,31 +366,50 @@ public:
 	/**
 	*	\brief 讀取一個消息
 	*
+	*	直接 讀取到 接收 緩衝區 已知 消息 長度 時 一次 準備 整個 消息 的 空間
+	*
 	*	\exception boost::system::system_error
 	*/
 	bytes_t read()
 	{
-		bytes_t msg = reader_message();
-		if(msg.size())
+		//沒有 解包 函數 直接返回 數據
+		const bool raw = !_reader && _framer.kind() == KG_NET_FRAMER_NONE;
+		bytes_t msg;
+		if(raw)
 		{
-			return msg;
+			if(_buffer.size())
+			{
+				return _buffer.slice(_buffer.size());
+			}
+		}
+		else
+		{
+			msg = reader_message();
+			if(msg.size())
+			{
+				return msg;
+			}
 		}
 
 		while(true)
 		{
-			std::size_t	n = _socket.read_some(boost::asio::buffer(_data,1024));
-			//沒有 解包 函數 直接返回 數據
-			if(!_reader)
+			std::size_t need = 0;
+			if(_size > 0 && std::size_t(_size) > _buffer.size())
 			{
-				bytes_t bytes(n);
-				return bytes;
+				need = _size - _buffer.size();
 			}
-
-			//write
-			if(n != _buffer.write(_data,n))
+			try
+			{
+				_buffer.commit(_socket.read_some(_buffer.prepare(need)));
+			}
+			catch(const std::bad_alloc&)
 			{
 				BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ECHO_CLIENT_CODE_BAD_ALLOC,echo_client_category::get()));
 			}
+			if(raw)
+			{
+				return _buffer.slice(_buffer.size());
+			}
 
 			msg = reader_message();
 			if(msg.size())
@@ -326,6 +439,61 @@ public:
 		return _empty_bytes;
 	}
 	/**
+	*	\brief 將 消息體 編碼爲 一幀 (啓用 壓縮 時 先 壓縮) 並 完整 寫入
+	*
+	*	需要 設置 長度前綴 framer
+	*
+	*	\exception boost::system::system_error
+	*/
+	void write(const kg::byte_t* b,std::size_t n)
+	{
+		if(!_framer.peek())
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ECHO_CLIENT_CODE_BAD_MSG_HEADER,echo_client_category::get()));
+		}
+		//沒有 owner 的 視圖 不會 被 原地 修改 幀頭 與 消息體 分開 寫入 無需 拷貝
+		view_t view(const_cast<kg::byte_t*>(b),n);
+		try
+		{
+			for(std::size_t i=_stages.size();i>0;--i)
+			{
+				if(!_stages[i - 1]->encode(view,0))
+				{
+					BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ECHO_CLIENT_CODE_BAD_MSG,echo_client_category::get()));
+				}
+			}
+		}
+		catch(const std::bad_alloc&)
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ECHO_CLIENT_CODE_BAD_ALLOC,echo_client_category::get()));
+		}
+		if(!_framer.fits(view.size))
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ECHO_CLIENT_CODE_BAD_MSG_HEADER,echo_client_category::get()));
+		}
+		kg::byte_t header[KG_NET_FRAMER_PEEK_MAX];
+		boost::array<boost::asio::const_buffer,2> buffers = {{
+			boost::asio::buffer(header,_framer.encode(header,view.size)),
+			boost::asio::buffer(view.data,view.size)
+		}};
+		boost::asio::write(_socket,buffers);
+	}
+	/**
+	*	\brief 將 消息體 編碼爲 一幀 並 完整 寫入
+	*
+	*/
+	void write(const kg::byte_t* b,std::size_t n,boost::system::error_code& ec)
+	{
+		try
+		{
+			write(b,n);
+		}
+		catch(const boost::system::system_error& e)
+		{
+			ec = e.code();
+		}
+	}
+	/**
 	*	\brief 解析消息
 	*
 	*	\param byte_t* 消息頭
@@ -344,6 +512,38 @@ public:
 	{
 		_reader = func;
 	}
+private:
+	//去掉 幀頭 並 依次 調用 stage 解碼
+	bytes_t decode(const bytes_t& msg)
+	{
+		std::size_t header = std::size_t(_headerSize);
+		std::size_t body = msg.size() - header;
+		if(_framer.kind() != KG_NET_FRAMER_NONE)
+		{
+			frame_t frame;
+			_framer.decode(msg.get(),msg.size(),frame);
+			header = frame.header;
+			body = frame.body;
+		}
+
+		view_t view(msg.get() + header,body);
+		for(std::size_t i=0;i<_stages.size();++i)
+		{
+			if(!_stages[i]->decode(view))
+			{
+				BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_ECHO_CLIENT_CODE_BAD_MSG,echo_client_category::get()));
+			}
+		}
+		//原地 解碼 時 返回 引用 msg 的 切片
+		if(!view.owner)
+		{
+			std::size_t offset = view.data - msg.get();
+			return msg.range(offset,offset + view.size);
+		}
+		bytes_t out(view.size);
+		std::memcpy(out.get(),view.data,view.size);
+		return out;
+	}
 };
 
 };
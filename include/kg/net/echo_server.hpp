@@ -1,11 +1,41 @@
 #ifndef KG_NET_ECHO_SERVER_HEADER_HPP
 #define KG_NET_ECHO_SERVER_HEADER_HPP
+#include <climits>
+
 #include "basic_server.hpp"
+#include "framer.hpp"
+#include "stage.hpp"
 #include "../bytes/buffer.hpp"
 namespace kg
 {
 namespace net
 {
+/**
+*	\brief 流式 交付 消息的 第一段
+*
+*/
+#define KG_NET_STREAM_BEGIN	0x1
+/**
+*	\brief 流式 交付 消息的 中間段
+*
+*/
+#define KG_NET_STREAM_CONTINUE	0x2
+/**
+*	\brief 流式 交付 消息的 最後一段
+*
+*/
+#define KG_NET_STREAM_END	0x4
+/**
+*	\brief 默認 超過 多少 字節 的 消息 流式 交付
+*
+*/
+#define KG_NET_STREAM_THRESHOLD	(64 * 1024)
+/**
+*	\brief 默認 每個 連接 最多 併發 處理 的 消息數
+*
+*/
+#define KG_NET_PIPELINE_MAX	32
+
 /**
 *	\brief 使用 basic_server_t 實現的 tcp 服務器 可以自動解析 read消息
 *
@@ -26,21 +56,122 @@ public:
 	*
 	*/
 	typedef T session_t;
+	/**
+	*	\brief 一個 完整 消息
+	*
+	*/
+	class message_t
+	{
+	public:
+		kg::byte_t* data;
+		std::size_t size;
+		message_t(kg::byte_t* data,std::size_t size)
+			:data(data),size(size)
+		{
+		}
+	};
+	/**
+	*	\brief 併發 處理 的 響應
+	*
+	*/
+	class response_t
+	{
+	public:
+		boost::shared_array<kg::byte_t> data;
+		std::size_t size;
+		response_t():size(0)
+		{
+		}
+	};
 private:
+	class slot_t
+	{
+	public:
+		bool ready;
+		response_t response;
+		slot_t():ready(false)
+		{
+		}
+	};
+	//一個 連接 上 併發 處理 的 消息 與 等待 按序 寫出 的 響應
+	class pipeline_t
+		: boost::noncopyable
+	{
+	public:
+		//環形 重排 隊列 以 序號 取模 定位
+		std::vector<slot_t> slots;
+		//下一個 消息 的 序號
+		kg::uint64_t sequence;
+		//下一個 要 寫出 的 序號
+		kg::uint64_t written;
+		//已 分發 尚未 寫出 的 消息數
+		std::size_t inflight;
+		bool writing;
+		bool failed;
+		//讀取 等待 空位 或 關閉 等待 完成
+		deadline_timer_t timer;
+
+		pipeline_t(const socket_t::executor_type& executor,std::size_t max)
+			:slots(max ? max : 1),sequence(0),written(0),inflight(0),writing(false),failed(false),timer(executor)
+		{
+		}
+		//停止 處理 並 取消 讀取 使 連接 關閉
+		void fail(socket_t& s)
+		{
+			failed = true;
+			boost::system::error_code ec;
+			s.cancel(ec);
+			timer.cancel(ec);
+		}
+	};
 	class basic_session_t
 	{
 	public:
 		session_t session;
 
 		kg::bytes::buffer_t<> buffer;
-		int size;
-		basic_session_t():size(-1)
+		//正在 解析的 消息 長度 0 表示 尚未 解析 包頭
+		std::size_t size;
+		//正在 解析的 消息 的 幀頭 長度 流式 交付 時 跳過
+		std::size_t header;
+		//正在 流式 交付的 消息 已 交付的 字節數 (包括 跳過的 幀頭)
+		std::size_t streamed;
+		//分隔符 已 查找過的 字節數
+		std::size_t scanned;
+		//本次 讀取 得到的 消息 交給 batch 回調 後 清空
+		std::vector<message_t> batch;
+		std::vector<boost::shared_array<kg::byte_t> > storage;
+		//併發 處理 狀態 第一個 消息 到達時 創建
+		boost::scoped_ptr<pipeline_t> pipeline;
+		basic_session_t():size(0),header(0),streamed(0),scanned(0)
 		{
 
 		}
 	};
 	typedef boost::shared_ptr<basic_session_t> basic_session_spt;
-	basic_server_t<basic_session_spt> _s;
+
+	//將 basic_server 回調 靜態 轉發到 echo_server
+	class forward_handler_t
+	{
+	public:
+		type_t* server;
+		forward_handler_t():server(NULL)
+		{
+		}
+		inline bool connected(const connection_spt& s,basic_session_spt& session,const boost::asio::yield_context& ctx)
+		{
+			return server->forward_connected(s,session,ctx);
+		}
+		inline void closed(const connection_spt& s,basic_session_spt& session,const boost::asio::yield_context& ctx)
+		{
+			server->forward_closed(s,session,ctx);
+		}
+		inline bool readed(const connection_spt& s,basic_session_spt& session,kg::byte_t* b,std::size_t n,const boost::asio::yield_context& ctx)
+		{
+			return server->forward_readed(s,session,b,n,ctx);
+		}
+	};
+	basic_server_t<basic_session_spt,forward_handler_t> _s;
 
 	int _headerSize;
 public:
@@ -55,7 +186,8 @@ public:
 	*
 	*/
     echo_server_t(const std::string& laddr,std::size_t poll,std::size_t timeout,int headerSize)
-    	:_s(laddr,poll,timeout)
+    	:_s(laddr,poll,timeout),_stream_threshold(KG_NET_STREAM_THRESHOLD),_pipeline_max(KG_NET_PIPELINE_MAX),
+		_stages_headroom(0),_max_frame(0)
 	{
 		if(headerSize > -1)
 		{
@@ -66,9 +198,7 @@ public:
 			_headerSize = 0;
 		}
 		//轉發 basic_server 回調
-		_s.connected(boost::bind(&type_t::forward_connected,this,_1,_2,_3));
-		_s.closed(boost::bind(&type_t::forward_closed,this,_1,_2,_3));
-		_s.readed(boost::bind(&type_t::forward_readed,this,_1,_2,_3,_4,_5));
+		_s.handler().server = this;
 	}
 	/**
 	*	\brief 初始化 服務器
@@ -80,7 +210,8 @@ public:
 	*
 	*/
     echo_server_t(const std::string& laddr,std::size_t poll,std::size_t timeout,int headerSize,boost::system::error_code& ec)
-    	:_s(laddr,poll,timeout,ec)
+    	:_s(laddr,poll,timeout,ec),_stream_threshold(KG_NET_STREAM_THRESHOLD),_pipeline_max(KG_NET_PIPELINE_MAX),
+		_stages_headroom(0),_max_frame(0)
 	{
 		if(headerSize > -1)
 		{
@@ -92,9 +223,33 @@ public:
 		}
 
 		//轉發 basic_server 回調
-		_s.connected(boost::bind(&type_t::forward_connected,this,_1,_2,_3));
-		_s.closed(boost::bind(&type_t::forward_closed,this,_1,_2,_3));
-		_s.readed(boost::bind(&type_t::forward_readed,this,_1,_2,_3,_4,_5));
+		_s.handler().server = this;
+	}
+	/**
+	*	\brief 初始化 服務器
+	*
+	*	\exception boost::system::system_error
+	*	\param laddr	服務器監聽地址
+	*	\param poll		連接分配cpu 輪詢計算 (每個cpu 會被分配 poll個 連接之後 才會將 連接分配到下個 cpu)
+	*	\param timeout	客戶端 未活動 斷開 超時時間(單位 秒)
+	*	\param headerSize	消息頭 長度
+	*	\param options	basic_server_t 設定 stack_size 同樣 作用於 pipeline 的 處理 協程
+	*
+	*/
+    echo_server_t(const std::string& laddr,std::size_t poll,std::size_t timeout,int headerSize,const basic_server_options_t& options)
+    	:_s(laddr,poll,timeout,options),_stream_threshold(KG_NET_STREAM_THRESHOLD),_pipeline_max(KG_NET_PIPELINE_MAX),
+		_stages_headroom(0),_max_frame(0)
+	{
+		if(headerSize > -1)
+		{
+			_headerSize = headerSize;
+		}
+		else
+		{
+			_headerSize = 0;
+		}
+		//轉發 basic_server 回調
+		_s.handler().server = this;
 	}
 	~echo_server_t()
 	{
@@ -108,13 +263,67 @@ public:
     {
     	_s.stop();
     }
+	/**
+	*	\brief 優雅 停止 服務器
+	*
+	*	\see basic_server_t::shutdown
+	*/
+    inline void shutdown(const boost::posix_time::time_duration& deadline)
+    {
+    	_s.shutdown(deadline);
+    }
+	/**
+	*	\brief 向 連接 投遞 消息 加入 其 發送隊列
+	*
+	*	\see basic_server_t::post_to
+	*/
+    inline bool post_to(kg::uint64_t id,const kg::byte_t* b,std::size_t n)
+    {
+    	return _s.post_to(id,b,n);
+    }
+	/**
+	*	\brief 向 所有 連接 投遞 消息 加入 其 發送隊列
+	*
+	*	\see basic_server_t::broadcast
+	*/
+    inline bool broadcast(const kg::byte_t* b,std::size_t n)
+    {
+    	return _s.broadcast(b,n);
+    }
+	/**
+	*	\brief 以 id 查找 連接 線程安全
+	*
+	*	\see basic_server_t::find
+	*/
+    inline connection_spt find(kg::uint64_t id)const
+    {
+    	return _s.find(id);
+    }
+	/**
+	*	\brief 經 stage 編碼 並 加上 幀頭 (或 分隔符) 後 加入 連接 發送隊列
+	*
+	*	只能 在 工作線程 調用 需要 設置 framer b 被 拷貝 一次 (由 第一個 需要 輸出的 stage 完成)
+	*
+	*	\return 未設置 framer 長度 無法 編碼爲 一幀 內存 不足 編碼 失敗 或 連接 不可寫 時 返回 false
+	*/
+    inline bool send(const connection_spt& s,const kg::byte_t* b,std::size_t n)
+    {
+		//沒有 owner 的 視圖 不會 被 原地 修改
+		view_t view(const_cast<kg::byte_t*>(b),n);
+		return send(s,view);
+    }
+
 	/**
 	*	\brief 運行 服務器
-	*	\exception boost::system::system_error
+	*	\exception boost::system::system_error 設置了 stage 但 沒有 設置 長度前綴 framer 時 爲 invalid_argument
 	*
 	*/
     inline void run()
     {
+		if(!_stages.empty() && !_framer.peek())
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(boost::system::errc::make_error_code(boost::system::errc::invalid_argument)));
+		}
     	_s.run();
     }
 	/**
@@ -123,7 +332,14 @@ public:
 	*/
     inline void run(boost::system::error_code& ec)
     {
-    	_s.run(ec);
+		try
+		{
+			run();
+		}
+		catch(const boost::system::system_error& e)
+		{
+			ec = e.code();
+		}
     }
 	/**
 	*	\brief 等待服務器停止
@@ -139,18 +355,18 @@ public:
 	*
 	*	\return 返回 false 將 自動斷開 連接  並調用 closed 回調
 	*/
-	typedef boost::function<bool(socket_spt,session_t&,boost::asio::yield_context)> connected_bft;
+	typedef boost::function<bool(const connection_spt&,session_t&,const boost::asio::yield_context&)> connected_bft;
 	/**
 	*	\brief 定義 連接斷開後 回調
 	*
 	*	\return 返回 false 將 自動斷開 連接  並調用 closed 回調
 	*/
-	typedef boost::function<void(socket_spt,session_t&,boost::asio::yield_context)> closed_bft;
+	typedef boost::function<void(const connection_spt&,session_t&,const boost::asio::yield_context&)> closed_bft;
 	/**
 	*	\brief 定義 讀取到數據後 回調
 	*
 	*/
-	typedef boost::function<bool(socket_spt,session_t&,kg::byte_t*,std::size_t n,boost::asio::yield_context)> readed_bft;
+	typedef boost::function<bool(const connection_spt&,session_t&,kg::byte_t*,std::size_t n,const boost::asio::yield_context&)> readed_bft;
 
 	/**
 	*	\brief 解析消息
@@ -159,10 +375,40 @@ public:
 	*	\param size_t	消息頭 長度
 	*	\return 消息長度 如果<0 或 <headerSize 將 斷開 連接
 	*/
-	typedef boost::function<int(session_t&,kg::byte_t*,std::size_t,boost::asio::yield_context)> reader_bft;
+	typedef boost::function<int(session_t&,kg::byte_t*,std::size_t,const boost::asio::yield_context&)> reader_bft;
+
+	/**
+	*	\brief 定義 一次 讀取 得到的 所有 完整 消息 的 回調
+	*
+	*	消息 只在 回調 期間 有效
+	*
+	*	\return 返回 false 將 自動斷開 連接 並調用 closed 回調
+	*/
+	typedef boost::function<bool(const connection_spt&,session_t&,const std::vector<message_t>&,const boost::asio::yield_context&)> batch_bft;
+	/**
+	*	\brief 定義 流式 交付 大消息 的 回調
+	*
+	*	一個 消息 被 分爲 多段 依次 交付 第一段 帶有 KG_NET_STREAM_BEGIN 中間段 帶有 KG_NET_STREAM_CONTINUE\n
+	*	最後一段 帶有 KG_NET_STREAM_END (只有 一段 時 爲 KG_NET_STREAM_BEGIN|KG_NET_STREAM_END)\n
+	*	設置 framer 時 只 交付 消息體 否則 第一段 以 reader 解析的 包頭 開始 每段 只在 回調 期間 有效
+	*
+	*	\param int	KG_NET_STREAM_* 標記
+	*	\return 返回 false 將 自動斷開 連接 並調用 closed 回調
+	*/
+	typedef boost::function<bool(const connection_spt&,session_t&,int,kg::byte_t*,std::size_t,const boost::asio::yield_context&)> stream_bft;
+	/**
+	*	\brief 定義 併發 處理 消息 的 回調
+	*
+	*	每個 消息 在 獨立的 協程中 處理 同一 連接 的 回調 在 同一 線程 交替 執行\n
+	*	response 按 消息 到達 順序 寫出 size 爲0 不寫出 設置 framer 時 response 是 消息體 寫出 時 加上 幀頭
+	*
+	*	\param kg::byte_t*	消息 在 回調 返回 前 有效
+	*	\return 返回 false 將 自動斷開 連接 並調用 closed 回調
+	*/
+	typedef boost::function<bool(const connection_spt&,session_t&,kg::byte_t*,std::size_t,response_t&,const boost::asio::yield_context&)> pipelined_bft;
 private:
 	//轉發 basic_server 回調
-	bool forward_connected(kg::net::socket_spt s,basic_session_spt& basic_session,boost::asio::yield_context ctx)
+	bool forward_connected(const connection_spt& s,basic_session_spt& basic_session,const boost::asio::yield_context& ctx)
 	{
 		try
 		{
@@ -181,92 +427,612 @@ private:
 		basic_session->session = session;
 		return true;
 	}
-	void forward_closed(kg::net::socket_spt s,basic_session_spt& basic_session,boost::asio::yield_context ctx)
+	void forward_closed(const connection_spt& s,basic_session_spt& basic_session,const boost::asio::yield_context& ctx)
 	{
+		//等待 處理中的 消息 結束 保證 closed 之後 不再 使用 session
+		if(basic_session->pipeline)
+		{
+			pipeline_t& pipeline = *basic_session->pipeline;
+			boost::system::error_code ec;
+			while(pipeline.inflight)
+			{
+				pipeline.timer.expires_at(boost::posix_time::pos_infin);
+				pipeline.timer.async_wait(ctx[ec]);
+			}
+		}
 		if(_closed)
 		{
 			_closed(s,basic_session->session,ctx);
 		}
 		basic_session.reset();
 	}
-	bool forward_readed(kg::net::socket_spt s,basic_session_spt& basic_session,kg::byte_t*b,std::size_t n,boost::asio::yield_context ctx)
+	bool forward_readed(const connection_spt& s,basic_session_spt& basic_session,kg::byte_t*b,std::size_t n,const boost::asio::yield_context& ctx)
 	{
 		//不處理 數據包
-		if(!_readed)
+		if(!_readed && !_batch && !_pipelined && !_stream)
 		{
 			return true;
 		}
 
 		//未設置 解包
 		basic_session_t& basic = *basic_session;
-		if(!_reader)
+		const bool framed = _framer.kind() != KG_NET_FRAMER_NONE;
+		if(!_reader && !framed)
 		{
-			return _readed(s,basic.session,b,n,ctx);
+			return deliver(s,basic_session,b,n,ctx) && flush_batch(s,basic,ctx);
 		}
 
 		try
 		{
 			kg::bytes::buffer_t<>& buffer = basic.buffer;
-			if(n != buffer.write(b,n))
+
+			//繼續 流式 交付 大消息
+			if(basic.streamed && !stream(s,basic,b,n,ctx))
 			{
 				return false;
 			}
 
-			//開始 解包
-			if(basic.size == -1)
+			//完成 被 拆分的 消息 只 拷貝 需要的 數據
+			while(buffer.size())
 			{
-				//讀取包頭
-				if(_headerSize == 0)
+				int rs = parse(basic,ctx);
+				if(rs == KG_NET_FRAME_ERROR)
 				{
-					basic.size = _reader(basic.session,NULL,0,ctx);
+					return false;
 				}
-				else
+				else if(rs == KG_NET_FRAME_MORE)
 				{
-					if(buffer.size()<_headerSize)
+					if(!n)
+					{
+						break;
+					}
+					//補充 包頭 分隔符 無法 確定 需要 多少 全部 緩存
+					std::size_t step = n;
+					std::size_t want = header_size();
+					if(want)
+					{
+						want = want > buffer.size() ? want - buffer.size() : 1;
+						if(want < step)
+						{
+							step = want;
+						}
+					}
+					if(step != buffer.write(b,step))
 					{
-						//等待 包頭
-						return true;
+						return false;
 					}
-					//解析包頭
-					boost::shared_array<kg::byte_t> header(new kg::byte_t[_headerSize]);
-					buffer.copy_to(header.get(),_headerSize);
-					basic.size = _reader(basic.session,header.get(),_headerSize,ctx);
+					b += step;
+					n -= step;
+					continue;
 				}
 
-				//解包錯誤
-				if(basic.size < _headerSize || basic.size < 1)
+				const std::size_t size = basic.size;
+				const std::size_t have = buffer.size();
+				if(streamable(size))
+				{
+					//交付 已 緩存的 部分 之後的 部分 直接 由 讀取 緩衝區 交付
+					const std::size_t take = have < size ? have : size;
+					boost::shared_array<kg::byte_t> chunk(new kg::byte_t[take]);
+					buffer.read(chunk.get(),take);
+					kg::byte_t* p = chunk.get();
+					std::size_t m = take;
+					if(!stream(s,basic,p,m,ctx) || !stream(s,basic,b,n,ctx))
+					{
+						return false;
+					}
+					continue;
+				}
+				if(have < size && n < size - have)
+				{
+					//等待 body
+					if(n != buffer.write(b,n))
+					{
+						return false;
+					}
+					n = 0;
+					break;
+				}
+				//緩衝區 與 本次 讀取 拼接 爲 一個 消息
+				boost::shared_array<kg::byte_t> msg(new kg::byte_t[size]);
+				std::size_t count = buffer.read(msg.get(),size);
+				if(count < size)
+				{
+					std::memcpy(msg.get() + count,b,size - count);
+					b += size - count;
+					n -= size - count;
+				}
+				basic.size = 0;
+				if(!deliver(s,basic_session,msg.get(),size,ctx,msg))
 				{
 					return false;
 				}
 			}
 
-			if(buffer.size() < basic.size)
+			//連續的 完整 消息 直接 交給 回調 不拷貝
+			while(n && !buffer.size())
 			{
-				//等待 body
-				return true;
+				int rs = parse(basic,b,n,ctx);
+				if(rs == KG_NET_FRAME_ERROR)
+				{
+					return false;
+				}
+				else if(rs == KG_NET_FRAME_MORE)
+				{
+					break;
+				}
+				const std::size_t size = basic.size;
+				if(streamable(size))
+				{
+					if(!stream(s,basic,b,n,ctx))
+					{
+						return false;
+					}
+					continue;
+				}
+				if(size > n)
+				{
+					break;
+				}
+				basic.size = 0;
+				if(!deliver(s,basic_session,b,size,ctx))
+				{
+					return false;
+				}
+				b += size;
+				n -= size;
 			}
-			boost::shared_array<kg::byte_t> msg(new kg::byte_t[basic.size]);
-			buffer.read(msg.get(),basic.size);
-			//通知 回調
-			if(!_readed(s,basic.session,msg.get(),basic.size,ctx))
+
+			//緩存 不完整的 消息
+			if(n && n != buffer.write(b,n))
 			{
 				return false;
 			}
+		}
+		catch(const std::bad_alloc&)
+		{
+			return false;
+		}
+		return flush_batch(s,basic,ctx);
+	}
+	//返回 長度 爲 size 的 消息 是否 流式 交付
+	inline bool streamable(std::size_t size)const
+	{
+		return _stream && size > _stream_threshold;
+	}
+	//由 b 流式 交付 當前 消息 的 下一段 並 前移 b
+	bool stream(const connection_spt& s,basic_session_t& basic,kg::byte_t*& b,std::size_t& n,const boost::asio::yield_context& ctx)
+	{
+		//跳過 幀頭
+		if(basic.streamed < basic.header)
+		{
+			std::size_t skip = basic.header - basic.streamed;
+			if(skip > n)
+			{
+				skip = n;
+			}
+			b += skip;
+			n -= skip;
+			basic.streamed += skip;
+		}
+		const std::size_t left = basic.size - basic.streamed;
+		const std::size_t take = n < left ? n : left;
+		if(!take)
+		{
+			return true;
+		}
+		const bool begin = basic.streamed == basic.header;
+		int flags = begin ? KG_NET_STREAM_BEGIN : KG_NET_STREAM_CONTINUE;
+		if(take == left)
+		{
+			flags = begin ? (KG_NET_STREAM_BEGIN | KG_NET_STREAM_END) : KG_NET_STREAM_END;
+		}
+		//保持 與 批量 消息 的 順序
+		if(!flush_batch(s,basic,ctx) || !_stream(s,basic.session,flags,b,take,ctx))
+		{
+			return false;
+		}
+		b += take;
+		n -= take;
+		basic.streamed += take;
+		if(basic.streamed == basic.size)
+		{
+			basic.size = 0;
+			basic.streamed = 0;
+		}
+		return true;
+	}
+	//通知 回調 或 加入 批量
+	inline bool deliver(const connection_spt& s,basic_session_spt& basic_session,kg::byte_t* b,std::size_t n,const boost::asio::yield_context& ctx,
+		const boost::shared_array<kg::byte_t>& owner = boost::shared_array<kg::byte_t>())
+	{
+		basic_session_t& basic = *basic_session;
+		boost::shared_array<kg::byte_t> data = owner;
+		if(_framer.kind() != KG_NET_FRAMER_NONE && !decode(b,n,data))
+		{
+			return false;
+		}
+		if(_pipelined)
+		{
+			return dispatch(s,basic_session,b,n,ctx,data);
+		}
+		if(_batch)
+		{
+			//消息 需要 保存到 回調 返回
+			basic.batch.push_back(message_t(b,n));
+			if(data)
+			{
+				basic.storage.push_back(data);
+			}
+			return true;
+		}
+		//只 設置 stream 時 丟棄 不超過 threshold 的 消息
+		return !_readed || _readed(s,basic.session,b,n,ctx);
+	}
+	//去掉 幀頭 與 分隔符 並 依次 調用 stage 解碼 輸出 內存 保存在 data 中
+	bool decode(kg::byte_t*& b,std::size_t& n,boost::shared_array<kg::byte_t>& data)
+	{
+		std::size_t header = 0;
+		std::size_t body = n - _framer.delimiter_size();
+		if(_framer.peek())
+		{
+			frame_t frame;
+			if(_framer.decode(b,n,frame) != KG_NET_FRAME_OK)
+			{
+				return false;
+			}
+			header = frame.header;
+			body = frame.body;
+		}
 
-			//重置 消息解析 狀態
-			basic.size = -1;
+		view_t view(b + header,body,header,data);
+		view.limit = _max_frame;
+		for(std::size_t i=0;i<_stages.size();++i)
+		{
+			if(!_stages[i]->decode(view))
+			{
+				return false;
+			}
+		}
+		data = view.owner;
+		b = view.data;
+		n = view.size;
+		return true;
+	}
+	//依次 反向 調用 stage 編碼 加上 幀頭 與 分隔符 並 發送
+	bool send(const connection_spt& s,view_t& view)
+	{
+		if(_framer.kind() == KG_NET_FRAMER_NONE)
+		{
+			return false;
+		}
+		try
+		{
+			const std::size_t max = KG_NET_FRAMER_PEEK_MAX;
+			std::size_t headroom = _stages_headroom;
+			for(std::size_t i=_stages.size();i>0;--i)
+			{
+				headroom -= _stages[i - 1]->headroom();
+				if(!_stages[i - 1]->encode(view,max + headroom))
+				{
+					return false;
+				}
+			}
+			if(!_framer.fits(view.size))
+			{
+				return false;
+			}
+			//分隔符 需要 追加 在 消息體 之後 無法 原地 寫入
+			const std::size_t header = _framer.header_size(view.size);
+			const std::size_t trailer = _framer.delimiter_size();
+			if(trailer || !view.writable(header))
+			{
+				view_t out;
+				out.reset(header,view.size + trailer);
+				std::memcpy(out.data,view.data,view.size);
+				out.size = view.size;
+				view = out;
+			}
+			_framer.encode(view.data - header,view.size);
+			std::memcpy(view.data + view.size,_framer.delimiter_data(),trailer);
+			//幀 可能 位於 owner 中間 不移動 數據
+			return s->send(view.owner,view.data - header - view.owner.get(),header + view.size + trailer);
 		}
 		catch(const std::bad_alloc&)
+		{
+		}
+		return false;
+	}
+	//在 新協程中 處理 消息 處理中的 消息 達到 上限 時 暫停 讀取
+	bool dispatch(const connection_spt& s,basic_session_spt& basic_session,kg::byte_t* b,std::size_t n,const boost::asio::yield_context& ctx,
+		boost::shared_array<kg::byte_t> data)
+	{
+		basic_session_t& basic = *basic_session;
+		if(!basic.pipeline)
+		{
+			basic.pipeline.reset(new pipeline_t(s->get_executor(),_pipeline_max));
+		}
+		pipeline_t& pipeline = *basic.pipeline;
+
+		boost::system::error_code ec;
+		while(!pipeline.failed && pipeline.inflight >= pipeline.slots.size())
+		{
+			pipeline.timer.expires_at(boost::posix_time::pos_infin);
+			pipeline.timer.async_wait(ctx[ec]);
+		}
+		if(pipeline.failed)
 		{
 			return false;
 		}
+
+		//讀取 緩衝區 在 返回後 會被 重用 需要 拷貝
+		if(!data)
+		{
+			data.reset(new kg::byte_t[n]);
+			std::memcpy(data.get(),b,n);
+			b = data.get();
+		}
+		const kg::uint64_t seq = pipeline.sequence++;
+		++pipeline.inflight;
+		//b 可能 位於 data 中間 (去掉 幀頭 或 stage 原地 解碼)
+		boost::asio::spawn(ctx,boost::bind(&type_t::coroutine_pipelined,this,s,basic_session,seq,data,b,n,_1),_s.get_attributes());
 		return true;
 	}
+	void coroutine_pipelined(connection_spt s,basic_session_spt basic_session,kg::uint64_t seq,boost::shared_array<kg::byte_t> data,kg::byte_t* b,std::size_t n,boost::asio::yield_context ctx)
+	{
+		basic_session_t& basic = *basic_session;
+		pipeline_t& pipeline = *basic.pipeline;
+		response_t response;
+		bool ok = false;
+		try
+		{
+			ok = _pipelined(s,basic.session,b,n,response,ctx);
+		}
+		catch(const boost::system::system_error&)
+		{
+		}
+		catch(const std::bad_alloc&)
+		{
+		}
+		data.reset();
+
+		slot_t& slot = pipeline.slots[seq % pipeline.slots.size()];
+		slot.ready = true;
+		slot.response = response;
+		if(!ok)
+		{
+			pipeline.fail(*s);
+		}
+
+		//按 請求 順序 寫出 已 完成的 響應 同時 只有 一個 協程 寫出
+		if(!pipeline.writing)
+		{
+			pipeline.writing = true;
+			while(true)
+			{
+				slot_t& head = pipeline.slots[pipeline.written % pipeline.slots.size()];
+				if(!head.ready)
+				{
+					break;
+				}
+				if(!pipeline.failed && head.response.size)
+				{
+					try
+					{
+						//超過 高水位 時 等待 寫出 而非 丟棄 響應
+						if(!s->writable())
+						{
+							s->wait_writable(ctx);
+						}
+						//設置了 framer 時 響應 是 消息體 需要 編碼 並 加上 幀頭
+						view_t view(head.response.data.get(),head.response.size,0,head.response.data);
+						bool ok = _framer.kind() == KG_NET_FRAMER_NONE ? s->send(head.response.data,head.response.size)
+							: send(s,view);
+						if(!ok)
+						{
+							pipeline.fail(*s);
+						}
+					}
+					catch(const boost::system::system_error&)
+					{
+						pipeline.fail(*s);
+					}
+				}
+				head = slot_t();
+				++pipeline.written;
+				--pipeline.inflight;
+			}
+			pipeline.writing = false;
+		}
+
+		//喚醒 等待的 讀取 或 關閉
+		boost::system::error_code ec;
+		pipeline.timer.cancel(ec);
+	}
+	//將 本次 讀取 得到的 消息 一次 交給 batch 回調
+	bool flush_batch(const connection_spt& s,basic_session_t& basic,const boost::asio::yield_context& ctx)
+	{
+		if(basic.batch.empty())
+		{
+			return true;
+		}
+		bool ok = _batch(s,basic.session,basic.batch,ctx);
+		basic.batch.clear();
+		basic.storage.clear();
+		return ok;
+	}
+	//解析 包頭 最多 需要的 字節數 爲0 表示 無法 確定
+	inline std::size_t header_size()const
+	{
+		if(_framer.kind() != KG_NET_FRAMER_NONE)
+		{
+			return _framer.peek();
+		}
+		return std::size_t(_headerSize);
+	}
+	//檢查 解析出的 消息 長度
+	inline int check(basic_session_t& basic,int size)
+	{
+		//解包錯誤
+		if(size < _headerSize || size < 1)
+		{
+			return KG_NET_FRAME_ERROR;
+		}
+		return check(basic,std::size_t(size));
+	}
+	inline int check(basic_session_t& basic,int rs,const frame_t& frame)
+	{
+		if(rs != KG_NET_FRAME_OK)
+		{
+			return rs;
+		}
+		if(!frame.size)
+		{
+			return KG_NET_FRAME_ERROR;
+		}
+		basic.header = frame.header;
+		return check(basic,frame.size);
+	}
+	inline int check(basic_session_t& basic,std::size_t size)
+	{
+		//超過 上限 且 不能 流式 交付
+		if(_max_frame && size > _max_frame && !streamable(size))
+		{
+			return KG_NET_FRAME_ERROR;
+		}
+		basic.size = size;
+		return KG_NET_FRAME_OK;
+	}
+	//由 連續 內存 解析 下一個 消息 長度 到 basic.size
+	int parse(basic_session_t& basic,kg::byte_t* b,std::size_t n,const boost::asio::yield_context& ctx)
+	{
+		if(_framer.kind() != KG_NET_FRAMER_NONE)
+		{
+			frame_t frame;
+			int rs = _framer.decode(b,n,frame);
+			//未找到 分隔符 的 數據 將被 緩存 不再 查找
+			const std::size_t d = _framer.delimiter_size();
+			if(rs == KG_NET_FRAME_MORE && d)
+			{
+				//分隔符 消息 無法 流式 交付 長度 不能 超過 上限
+				if(_max_frame && n > _max_frame)
+				{
+					return KG_NET_FRAME_ERROR;
+				}
+				basic.scanned = n < d ? 0 : n - d + 1;
+			}
+			return check(basic,rs,frame);
+		}
+		if(_headerSize == 0)
+		{
+			return check(basic,_reader(basic.session,NULL,0,ctx));
+		}
+		if(n < std::size_t(_headerSize))
+		{
+			return KG_NET_FRAME_MORE;
+		}
+		return check(basic,_reader(basic.session,b,_headerSize,ctx));
+	}
+	//由 緩衝區 解析 下一個 消息 長度 到 basic.size
+	int parse(basic_session_t& basic,const boost::asio::yield_context& ctx)
+	{
+		if(basic.size)
+		{
+			return KG_NET_FRAME_OK;
+		}
+		kg::bytes::buffer_t<>& buffer = basic.buffer;
+		if(_framer.kind() != KG_NET_FRAMER_NONE)
+		{
+			frame_t frame;
+			int rs = decode_buffer(basic,frame);
+			//分隔符 消息 無法 流式 交付 長度 不能 超過 上限
+			if(rs == KG_NET_FRAME_MORE && _max_frame && buffer.size() > _max_frame)
+			{
+				return KG_NET_FRAME_ERROR;
+			}
+			return check(basic,rs,frame);
+		}
+
+		//讀取包頭
+		if(_headerSize == 0)
+		{
+			return check(basic,_reader(basic.session,NULL,0,ctx));
+		}
+		if(buffer.size() < std::size_t(_headerSize))
+		{
+			//等待 包頭
+			return KG_NET_FRAME_MORE;
+		}
+		//解析包頭 (包頭 通常 很短 使用 棧上 內存)
+		kg::byte_t stack[64];
+		boost::scoped_array<kg::byte_t> heap;
+		kg::byte_t* header = stack;
+		if(std::size_t(_headerSize) > sizeof(stack))
+		{
+			heap.reset(new kg::byte_t[_headerSize]);
+			header = heap.get();
+		}
+		buffer.copy_to(header,_headerSize);
+		return check(basic,_reader(basic.session,header,_headerSize,ctx));
+	}
+	//解析 buffer 中 下一幀 的 長度 不 取出 數據
+	int decode_buffer(basic_session_t& basic,frame_t& frame)
+	{
+		kg::bytes::buffer_t<>& buffer = basic.buffer;
+		std::size_t peek = _framer.peek();
+		if(peek)
+		{
+			kg::byte_t header[KG_NET_FRAMER_PEEK_MAX];
+			std::size_t n = buffer.copy_to(header,peek);
+			return _framer.decode(header,n,frame);
+		}
+
+		const std::size_t d = _framer.delimiter_size();
+		if(!d)
+		{
+			return _framer.decode(NULL,0,frame);
+		}
+		//分段 查找 分隔符 已查找過的 數據 不再 查找
+		kg::byte_t tmp[1024];
+		while(true)
+		{
+			const std::size_t skip = basic.scanned;
+			std::size_t n = buffer.copy_to(skip,tmp,sizeof(tmp));
+			if(n < d)
+			{
+				return KG_NET_FRAME_MORE;
+			}
+			std::size_t pos = _framer.find(tmp,n);
+			if(pos != n)
+			{
+				basic.scanned = 0;
+				frame.header = 0;
+				frame.body = skip + pos;
+				frame.size = frame.body + d;
+				return KG_NET_FRAME_OK;
+			}
+			//保留 可能 被 截斷的 分隔符 前綴
+			basic.scanned = skip + n - d + 1;
+			if(n < sizeof(tmp))
+			{
+				return KG_NET_FRAME_MORE;
+			}
+		}
+	}
 
 	connected_bft _connected;
 	closed_bft _closed;
 	readed_bft _readed;
 	reader_bft _reader;
+	framer_t _framer;
+	batch_bft _batch;
+	stream_bft _stream;
+	std::size_t _stream_threshold;
+	pipelined_bft _pipelined;
+	std::size_t _pipeline_max;
+	std::vector<stage_spt> _stages;
+	//所有 stage 編碼 最多 增加的 頭部 字節數
+	std::size_t _stages_headroom;
+	std::size_t _max_frame;
 public:
 	/**
 	*	\brief 設置 連接建立後 回調
@@ -300,6 +1066,99 @@ public:
 	{
 		_reader = func;
 	}
+	/**
+	*	\brief 設置 內置 分幀 規則 代替 reader 回調
+	*
+	*	設置後 不再 調用 reader 與 headerSize readed batch pipeline stream 收到 去掉 幀頭 與 分隔符 的 消息體\n
+	*	send 與 pipeline 的 響應 是 消息體 寫出 時 加上 幀頭 或 分隔符 回調 無需 關心 分幀 規則\n
+	*	framer_t() 恢復 使用 reader (回調 收到 包括 包頭 的 整個 消息 寫出 時 不做 處理)
+	*/
+	inline void framer(const framer_t& framer)
+	{
+		_framer = framer;
+	}
+	/**
+	*	\brief 設置 批量 回調
+	*
+	*	設置後 每次 讀取 解析出的 所有 完整 消息 一次 交給 batch 不再 調用 readed
+	*/
+	inline void batch(batch_bft func)
+	{
+		_batch = func;
+	}
+	/**
+	*	\brief 設置 消息 最大 長度 爲0 不限制
+	*
+	*	包頭 解析出的 長度 或 未找到 分隔符的 數據 超過 max 時 斷開 連接 (流式 交付的 消息 除外)\n
+	*	如此 每個 連接 最多 緩存 max 字節 而非 reader 返回的 任意 長度\n
+	*	stage 解碼後 (如 解壓) 的 長度 同樣 受 max 限制
+	*/
+	inline void max_frame(std::size_t max)
+	{
+		_max_frame = max;
+	}
+	/**
+	*	\brief 設置 流式 交付 回調
+	*
+	*	長度 超過 threshold 的 消息 不再 緩存 而是 隨 讀取 分段 交給 func 不調用 readed 與 batch\n
+	*	分隔符 分幀的 消息 長度 未知 不會 流式 交付 未設置 readed 時 其它 消息 被 丟棄
+	*/
+	inline void stream(stream_bft func,std::size_t threshold = KG_NET_STREAM_THRESHOLD)
+	{
+		_stream = func;
+		_stream_threshold = threshold;
+	}
+	/**
+	*	\brief 設置 併發 處理 回調
+	*
+	*	設置後 每個 完整 消息 在 新協程中 交給 func 不再 調用 readed 與 batch\n
+	*	每個 連接 最多 max 個 消息 尚未 寫出 響應 達到 上限 時 暫停 讀取 由 tcp 流控 反壓 對端\n
+	*	響應 經 重排 隊列 按 請求 順序 寫出 closed 回調 會 等待 所有 處理 結束
+	*/
+	inline void pipeline(pipelined_bft func,std::size_t max = KG_NET_PIPELINE_MAX)
+	{
+		_pipelined = func;
+		_pipeline_max = max;
+	}
+	/**
+	*	\brief 加入 消息 處理 階段
+	*
+	*	收到的 幀 去掉 幀頭 後 按 加入 順序 解碼 readed batch pipeline 收到 解碼後的 消息體\n
+	*	send 與 pipeline 的 響應 按 相反 順序 編碼 後 加上 幀頭 發送\n
+	*	需要 設置 長度前綴 framer (響應 需要 按 編碼後的 長度 生成 幀頭 reader 分幀 無法 生成) 否則 run 失敗\n
+	*	流式 交付的 消息 不經過 stage 需要 在 run 之前 設置
+	*
+	*	\code
+	s.encryption(salt);	//解密 -> 解壓 -> 回調 -> 壓縮 -> 加密
+	s.compression();
+	\endcode
+	*	\exception std::bad_alloc
+	*/
+	inline void stage(stage_spt stage)
+	{
+		_stages.push_back(stage);
+		_stages_headroom += stage->headroom();
+	}
+	/**
+	*	\brief 加入 compress_stage_t 壓縮 消息體
+	*
+	*	長度 達到 threshold 的 消息體 壓縮 (未變小 則 原樣 發送) 解壓後 長度 受 解碼 時的 max_frame 限制
+	*
+	*	\exception std::bad_alloc
+	*/
+	inline void compression(std::size_t threshold = KG_NET_COMPRESS_THRESHOLD,int level = Z_DEFAULT_COMPRESSION)
+	{
+		stage(boost::make_shared<compress_stage_t>(threshold,level));
+	}
+	/**
+	*	\brief 加入 crypto_stage_t 使用 k3xsx_salt_t 加密 消息體
+	*
+	*	\exception std::bad_alloc
+	*/
+	inline void encryption(const kg::byte_t salt = 0)
+	{
+		stage(boost::make_shared<crypto_stage_t>(salt));
+	}
 };
 
 };
@@ -0,0 +1,425 @@
+#ifndef KG_NET_FRAMER_HEADER_HPP
+#define KG_NET_FRAMER_HEADER_HPP
+
+#include <cstring>
+
+#include <boost/assert.hpp>
+
+#include "../types.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 未設置 分幀 由 reader_bft 解析
+*
+*/
+#define KG_NET_FRAMER_NONE	0
+/**
+*	\brief 定長 長度前綴 (1/2/4/8 字節 大端 或 小端)
+*
+*/
+#define KG_NET_FRAMER_LENGTH	1
+/**
+*	\brief varint (LEB128) 長度前綴
+*
+*/
+#define KG_NET_FRAMER_VARINT	2
+/**
+*	\brief 以 分隔符 結尾
+*
+*/
+#define KG_NET_FRAMER_DELIMITER	3
+/**
+*	\brief 定長 記錄
+*
+*/
+#define KG_NET_FRAMER_FIXED	4
+
+/**
+*	\brief 分隔符 最大 長度
+*
+*/
+#define KG_NET_FRAMER_DELIMITER_MAX	8
+/**
+*	\brief 判斷 幀長 最多 需要 查看的 字節數 (varint 最長 10 字節)
+*
+*/
+#define KG_NET_FRAMER_PEEK_MAX	10
+
+/**
+*	\brief decode 返回值 數據 不足
+*
+*/
+#define KG_NET_FRAME_MORE	0
+/**
+*	\brief decode 返回值 得到 完整 幀長
+*
+*/
+#define KG_NET_FRAME_OK	1
+/**
+*	\brief decode 返回值 數據 非法 應 斷開 連接
+*
+*/
+#define KG_NET_FRAME_ERROR	(-1)
+
+/**
+*	\brief 一幀 的 佈局 header + body + trailer
+*
+*/
+class frame_t
+{
+public:
+	/**
+	*	\brief 長度前綴 字節數
+	*
+	*/
+	std::size_t header;
+	/**
+	*	\brief 消息體 字節數
+	*
+	*/
+	std::size_t body;
+	/**
+	*	\brief 整幀 字節數 包括 長度前綴 與 分隔符
+	*
+	*/
+	std::size_t size;
+
+	frame_t():header(0),body(0),size(0)
+	{
+	}
+};
+
+/**
+*	\brief 內置的 分幀 規則
+*
+*	值型別 不分配 內存 可 直接 copy\n
+*	decode 只 讀取 幀頭 得到 幀長 不 要求 整幀 都已 到達 (分隔符 除外)
+*
+*	\code
+kg::net::framer_t framer = kg::net::framer_t::length(4,true);	//u32 大端 不含 頭長
+kg::net::framer_t framer = kg::net::framer_t::varint();
+kg::net::framer_t framer = kg::net::framer_t::delimiter("\r\n");
+kg::net::framer_t framer = kg::net::framer_t::fixed(64);
+	\endcode
+*/
+class framer_t
+{
+private:
+	int _kind;
+	//長度前綴 字節數 / 分隔符 長度 / 記錄 長度
+	std::size_t _size;
+	bool _big_endian;
+	bool _include_header;
+	kg::byte_t _delimiter[KG_NET_FRAMER_DELIMITER_MAX];
+public:
+	framer_t()
+		:_kind(KG_NET_FRAMER_NONE),_size(0),_big_endian(true),_include_header(false)
+	{
+	}
+	/**
+	*	\brief 定長 長度前綴
+	*
+	*	\param bytes	前綴 字節數 1 2 4 8
+	*	\param big_endian	是否 大端 (網絡字節序)
+	*	\param include_header	長度值 是否 包括 前綴 自身
+	*/
+	static framer_t length(std::size_t bytes,bool big_endian = true,bool include_header = false)
+	{
+		BOOST_ASSERT(bytes == 1 || bytes == 2 || bytes == 4 || bytes == 8);
+		framer_t framer;
+		framer._kind = KG_NET_FRAMER_LENGTH;
+		framer._size = bytes;
+		framer._big_endian = big_endian;
+		framer._include_header = include_header;
+		return framer;
+	}
+	/**
+	*	\brief varint (LEB128 每字節 低7位 有效 最高位 表示 後續) 長度前綴 長度值 不包括 前綴
+	*
+	*/
+	static framer_t varint()
+	{
+		framer_t framer;
+		framer._kind = KG_NET_FRAMER_VARINT;
+		return framer;
+	}
+	/**
+	*	\brief 以 delimiter 結尾 的 幀 幀中 包括 分隔符
+	*
+	*	\param n	分隔符 長度 1 到 KG_NET_FRAMER_DELIMITER_MAX
+	*/
+	static framer_t delimiter(const kg::byte_t* delimiter,std::size_t n)
+	{
+		BOOST_ASSERT(n > 0 && n <= KG_NET_FRAMER_DELIMITER_MAX);
+		framer_t framer;
+		framer._kind = KG_NET_FRAMER_DELIMITER;
+		framer._size = n;
+		std::memcpy(framer._delimiter,delimiter,n);
+		return framer;
+	}
+	/**
+	*	\brief 以 delimiter 結尾 的 幀 幀中 包括 分隔符
+	*
+	*/
+	static framer_t delimiter(const char* delimiter)
+	{
+		return framer_t::delimiter((const kg::byte_t*)delimiter,std::strlen(delimiter));
+	}
+	/**
+	*	\brief 每幀 固定 size 字節
+	*
+	*/
+	static framer_t fixed(std::size_t size)
+	{
+		BOOST_ASSERT(size > 0);
+		framer_t framer;
+		framer._kind = KG_NET_FRAMER_FIXED;
+		framer._size = size;
+		return framer;
+	}
+
+	/**
+	*	\brief 返回 KG_NET_FRAMER_*
+	*
+	*/
+	inline int kind()const
+	{
+		return _kind;
+	}
+	/**
+	*	\brief 判斷 幀長 最多 需要 查看的 字節數
+	*
+	*	分隔符 與 定長記錄 返回0 (前者 需要 查找 後者 無需 查看)
+	*/
+	inline std::size_t peek()const
+	{
+		switch(_kind)
+		{
+		case KG_NET_FRAMER_LENGTH:
+			return _size;
+		case KG_NET_FRAMER_VARINT:
+			return KG_NET_FRAMER_PEEK_MAX;
+		}
+		return 0;
+	}
+	/**
+	*	\brief 返回 分隔符 長度 非 KG_NET_FRAMER_DELIMITER 返回0
+	*
+	*/
+	inline std::size_t delimiter_size()const
+	{
+		return _kind == KG_NET_FRAMER_DELIMITER ? _size : 0;
+	}
+	/**
+	*	\brief 返回 分隔符
+	*
+	*/
+	inline const kg::byte_t* delimiter_data()const
+	{
+		return _delimiter;
+	}
+	/**
+	*	\brief 在 b 中 查找 分隔符
+	*
+	*	\return 分隔符 起始位置 未找到 返回 n
+	*/
+	std::size_t find(const kg::byte_t* b,std::size_t n)const
+	{
+		const std::size_t d = _size;
+		if(n < d)
+		{
+			return n;
+		}
+		const kg::byte_t* end = b + n - d + 1;
+		for(const kg::byte_t* p = b; p < end; ++p)
+		{
+			p = (const kg::byte_t*)std::memchr(p,_delimiter[0],end - p);
+			if(!p)
+			{
+				break;
+			}
+			if(d == 1 || !std::memcmp(p + 1,_delimiter + 1,d - 1))
+			{
+				return p - b;
+			}
+		}
+		return n;
+	}
+	/**
+	*	\brief 由 幀 起始 的 n 字節 解析 幀長
+	*
+	*	\return KG_NET_FRAME_OK KG_NET_FRAME_MORE KG_NET_FRAME_ERROR
+	*/
+	int decode(const kg::byte_t* b,std::size_t n,frame_t& frame)const
+	{
+		switch(_kind)
+		{
+		case KG_NET_FRAMER_LENGTH:
+			{
+				if(n < _size)
+				{
+					return KG_NET_FRAME_MORE;
+				}
+				kg::uint64_t v = 0;
+				if(_big_endian)
+				{
+					for(std::size_t i=0;i<_size;++i)
+					{
+						v = (v << 8) | b[i];
+					}
+				}
+				else
+				{
+					for(std::size_t i=_size;i>0;--i)
+					{
+						v = (v << 8) | b[i-1];
+					}
+				}
+				if(_include_header)
+				{
+					if(v < _size)
+					{
+						return KG_NET_FRAME_ERROR;
+					}
+					v -= _size;
+				}
+				return set(frame,_size,v,0);
+			}
+		case KG_NET_FRAMER_VARINT:
+			{
+				kg::uint64_t v = 0;
+				for(std::size_t i=0;i<n && i<KG_NET_FRAMER_PEEK_MAX;++i)
+				{
+					v |= kg::uint64_t(b[i] & 0x7f) << (7 * i);
+					if(!(b[i] & 0x80))
+					{
+						return set(frame,i + 1,v,0);
+					}
+				}
+				return n < KG_NET_FRAMER_PEEK_MAX ? KG_NET_FRAME_MORE : KG_NET_FRAME_ERROR;
+			}
+		case KG_NET_FRAMER_DELIMITER:
+			{
+				std::size_t pos = find(b,n);
+				if(pos == n)
+				{
+					return KG_NET_FRAME_MORE;
+				}
+				return set(frame,0,pos,_size);
+			}
+		case KG_NET_FRAMER_FIXED:
+			return set(frame,0,_size,0);
+		}
+		return KG_NET_FRAME_ERROR;
+	}
+	/**
+	*	\brief 返回 消息體 長 body 的 幀頭 字節數
+	*
+	*/
+	std::size_t header_size(std::size_t body)const
+	{
+		switch(_kind)
+		{
+		case KG_NET_FRAMER_LENGTH:
+			return _size;
+		case KG_NET_FRAMER_VARINT:
+			{
+				std::size_t n = 1;
+				while(body >= 0x80)
+				{
+					body >>= 7;
+					++n;
+				}
+				return n;
+			}
+		}
+		return 0;
+	}
+	/**
+	*	\brief 返回 消息體 長 body 是否 可以 編碼爲 一幀
+	*
+	*	長度前綴 需要 能 表示 body 定長記錄 需要 body 恰好 爲 記錄 長度 分隔符 不限制 (消息體 中 不應 包含 分隔符)
+	*/
+	bool fits(std::size_t body)const
+	{
+		switch(_kind)
+		{
+		case KG_NET_FRAMER_LENGTH:
+			if(_size < 8)
+			{
+				kg::uint64_t v = body;
+				if(_include_header)
+				{
+					v += _size;
+				}
+				return v < (kg::uint64_t(1) << (8 * _size));
+			}
+			return true;
+		case KG_NET_FRAMER_VARINT:
+		case KG_NET_FRAMER_DELIMITER:
+			return true;
+		case KG_NET_FRAMER_FIXED:
+			return body == _size;
+		}
+		return false;
+	}
+	/**
+	*	\brief 將 消息體 長 body 的 幀頭 寫入 b
+	*
+	*	b 至少 需要 header_size(body) 字節 分隔符 需要 調用者 自行 追加
+	*
+	*	\return 寫入的 字節數
+	*/
+	std::size_t encode(kg::byte_t* b,std::size_t body)const
+	{
+		switch(_kind)
+		{
+		case KG_NET_FRAMER_LENGTH:
+			{
+				kg::uint64_t v = body;
+				if(_include_header)
+				{
+					v += _size;
+				}
+				for(std::size_t i=0;i<_size;++i)
+				{
+					b[_big_endian ? _size - 1 - i : i] = kg::byte_t(v);
+					v >>= 8;
+				}
+				return _size;
+			}
+		case KG_NET_FRAMER_VARINT:
+			{
+				std::size_t n = 0;
+				kg::uint64_t v = body;
+				while(v >= 0x80)
+				{
+					b[n++] = kg::byte_t(v | 0x80);
+					v >>= 7;
+				}
+				b[n++] = kg::byte_t(v);
+				return n;
+			}
+		}
+		return 0;
+	}
+private:
+	static inline int set(frame_t& frame,std::size_t header,kg::uint64_t body,std::size_t trailer)
+	{
+		//幀長 溢出
+		if(body > kg::uint64_t(~std::size_t(0)) - header - trailer)
+		{
+			return KG_NET_FRAME_ERROR;
+		}
+		frame.header = header;
+		frame.body = std::size_t(body);
+		frame.size = header + frame.body + trailer;
+		return KG_NET_FRAME_OK;
+	}
+};
+};
+};
+#endif	//KG_NET_FRAMER_HEADER_HPP
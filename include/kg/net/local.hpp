@@ -0,0 +1,103 @@
+#ifndef KG_NET_LOCAL_HEADER_HPP
+#define KG_NET_LOCAL_HEADER_HPP
+
+#include <string>
+#include <cstdio>
+
+#include "types.hpp"
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+#include <sys/stat.h>
+#endif // BOOST_ASIO_HAS_LOCAL_SOCKETS
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief unix 域 socket 地址 前綴
+*
+*/
+#define KG_NET_LOCAL_ADDRESS_PREFIX	"unix:"
+
+/**
+*	\brief 返回 addr 是否是 unix:/path 形式的 unix 域 socket 地址
+*
+*	\param addr	地址
+*	\param path	返回 socket 文件 路徑
+*/
+inline bool is_local_address(const std::string& addr,std::string& path)
+{
+	const std::size_t n = sizeof(KG_NET_LOCAL_ADDRESS_PREFIX) - 1;
+	if(addr.size() <= n || addr.compare(0,n,KG_NET_LOCAL_ADDRESS_PREFIX))
+	{
+		return false;
+	}
+	path = addr.substr(n);
+	return true;
+}
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+/**
+*	\brief 在 path 上 監聽 unix 域 stream socket 並將 其 交給 acceptor
+*
+*	unix 域 socket 與 tcp socket 共用 相同的 讀寫 accept 接口 故 直接 以 tcp 型別 持有 其 描述符\n
+*	如此 basic_server_t 的 協程模型 無需 改變 但 不能 對其 設置 tcp 選項 或 查詢 endpoint\n
+*	path 是 socket 文件 且 無人 監聽 時 視爲 殘留文件 將其 刪除 後 重新 綁定
+*
+*	\exception boost::system::system_error
+*/
+inline void listen_local(acceptor_t& acceptor,const std::string& path,int backlog)
+{
+	typedef boost::asio::local::stream_protocol protocol_t;
+	protocol_t::endpoint endpoint(path);
+	protocol_t::acceptor local(acceptor.get_executor());
+	local.open(endpoint.protocol());
+
+	boost::system::error_code ec;
+	local.bind(endpoint,ec);
+	struct stat st;
+	if(ec == boost::asio::error::address_in_use
+		&& !stat(path.c_str(),&st) && S_ISSOCK(st.st_mode))
+	{
+		//檢查 是否 有 服務器 正在 使用
+		protocol_t::socket s(acceptor.get_executor());
+		boost::system::error_code err;
+		s.connect(endpoint,err);
+		if(err == boost::asio::error::connection_refused)
+		{
+			std::remove(path.c_str());
+			ec.clear();
+			local.bind(endpoint,ec);
+		}
+	}
+	if(ec)
+	{
+		BOOST_THROW_EXCEPTION(boost::system::system_error(ec));
+	}
+	local.listen(backlog);
+
+	acceptor.assign(boost::asio::ip::tcp::v4(),local.release());
+}
+/**
+*	\brief 連接 path 上的 unix 域 stream socket 並將 其 交給 s
+*
+*	\see listen_local
+*	\exception boost::system::system_error
+*/
+inline void connect_local(socket_t& s,const std::string& path)
+{
+	typedef boost::asio::local::stream_protocol protocol_t;
+	protocol_t::socket local(s.get_executor());
+	local.connect(protocol_t::endpoint(path));
+
+	if(s.is_open())
+	{
+		s.close();
+	}
+	s.assign(boost::asio::ip::tcp::v4(),local.release());
+}
+#endif // BOOST_ASIO_HAS_LOCAL_SOCKETS
+};
+};
+#endif	//KG_NET_LOCAL_HEADER_HPP
@@ -0,0 +1,176 @@
+#ifndef KG_NET_MAILBOX_HEADER_HPP
+#define KG_NET_MAILBOX_HEADER_HPP
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "types.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 無鎖 多生產者 單消費者 隊列
+*
+*	push 可在 任意線程 調用 (一次 原子交換) pop 只能在 一個 消費者線程 調用\n
+*	生產者 在 push 中途 被掛起 時 pop 可能 暫時 返回 false 生產者 完成後 即可 取出
+*
+*	\param T	元素 型別 需要 支持 默認構造 與 copy 語義
+*/
+template<typename T>
+class mpsc_queue_t
+	: boost::noncopyable
+{
+private:
+	class node_t
+	{
+	public:
+		boost::atomic<node_t*> next;
+		T value;
+		node_t():next(NULL)
+		{
+		}
+		explicit node_t(const T& value):next(NULL),value(value)
+		{
+		}
+	};
+	//生產者 寫入端
+	boost::atomic<node_t*> _head;
+	//消費者 讀取端 只在 消費者線程 使用
+	node_t* _tail;
+public:
+	mpsc_queue_t()
+	{
+		node_t* stub = new node_t();
+		_head.store(stub,boost::memory_order_relaxed);
+		_tail = stub;
+	}
+	~mpsc_queue_t()
+	{
+		T value;
+		while(pop(value))
+		{
+		}
+		delete _tail;
+	}
+	/**
+	*	\brief 加入 元素 線程安全
+	*
+	*	\exception std::bad_alloc
+	*/
+	void push(const T& value)
+	{
+		node_t* node = new node_t(value);
+		node_t* prev = _head.exchange(node,boost::memory_order_acq_rel);
+		prev->next.store(node,boost::memory_order_release);
+	}
+	/**
+	*	\brief 取出 元素 只能在 消費者線程 調用
+	*
+	*	\return 隊列 爲空 時 返回 false
+	*/
+	bool pop(T& value)
+	{
+		node_t* next = _tail->next.load(boost::memory_order_acquire);
+		if(!next)
+		{
+			return false;
+		}
+		value = next->value;
+		next->value = T();
+		delete _tail;
+		_tail = next;
+		return true;
+	}
+};
+
+/**
+*	\brief 廣播 消息 的 目標 id
+*
+*/
+#define KG_NET_BROADCAST_ID	(~kg::uint64_t(0))
+
+/**
+*	\brief 投遞到 響應服務器 郵箱 的 消息
+*
+*/
+class mail_t
+{
+public:
+	/**
+	*	\brief 目標 連接 id 或 KG_NET_BROADCAST_ID
+	*
+	*/
+	kg::uint64_t id;
+	/**
+	*	\brief 消息 數據
+	*
+	*/
+	boost::shared_array<kg::byte_t> data;
+	/**
+	*	\brief 消息 長度
+	*
+	*/
+	std::size_t size;
+
+	mail_t():id(0),size(0)
+	{
+	}
+	mail_t(kg::uint64_t id,boost::shared_array<kg::byte_t> data,std::size_t size)
+		:id(id),data(data),size(size)
+	{
+	}
+};
+
+/**
+*	\brief 響應服務器 郵箱
+*
+*	任意線程 send 消息 郵箱 由 空 變爲 非空 時 向 所屬 io_service 投遞 一次 處理函數\n
+*	處理函數 在 所屬 線程 取出 所有 消息 如此 大量 消息 只需 少量 post
+*/
+class mailbox_t
+	: boost::noncopyable
+{
+private:
+	mpsc_queue_t<mail_t> _queue;
+	//是否 已投遞 處理函數
+	boost::atomic<bool> _scheduled;
+public:
+	mailbox_t():_scheduled(false)
+	{
+	}
+	/**
+	*	\brief 加入 消息 線程安全
+	*
+	*	\exception std::bad_alloc
+	*	\return 需要 投遞 處理函數 時 返回 true
+	*/
+	bool send(const mail_t& mail)
+	{
+		_queue.push(mail);
+		return !_scheduled.exchange(true,boost::memory_order_seq_cst);
+	}
+	/**
+	*	\brief 開始 處理 消息 在 取出 消息 前 調用
+	*
+	*	之後 加入的 消息 會 再次 要求 投遞 處理函數
+	*/
+	inline void begin()
+	{
+		_scheduled.store(false,boost::memory_order_relaxed);
+		//保證 之後 讀取 隊列 不會 被 重排到 清除標記 之前
+		boost::atomic_thread_fence(boost::memory_order_seq_cst);
+	}
+	/**
+	*	\brief 取出 消息 只能在 所屬 線程 調用
+	*
+	*/
+	inline bool receive(mail_t& mail)
+	{
+		return _queue.pop(mail);
+	}
+};
+};
+};
+#endif	//KG_NET_MAILBOX_HEADER_HPP
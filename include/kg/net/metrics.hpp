@@ -0,0 +1,374 @@
+#ifndef KG_NET_METRICS_HEADER_HPP
+#define KG_NET_METRICS_HEADER_HPP
+
+#include <vector>
+#include <chrono>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "../types.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 單寫者 計數器
+*
+*	只允許 一個線程 寫入 寫入 不使用 原子讀改寫 指令 其它線程 可以 隨時 讀取
+*/
+class counter_t
+	: boost::noncopyable
+{
+private:
+	boost::atomic<kg::uint64_t> _value;
+public:
+	counter_t():_value(0)
+	{
+	}
+	/**
+	*	\brief 增加 計數 只能在 寫者線程 調用
+	*
+	*/
+	inline void add(kg::uint64_t n = 1)
+	{
+		_value.store(_value.load(boost::memory_order_relaxed) + n,boost::memory_order_relaxed);
+	}
+	/**
+	*	\brief 返回 計數
+	*
+	*/
+	inline kg::uint64_t get()const
+	{
+		return _value.load(boost::memory_order_relaxed);
+	}
+};
+
+#define KG_NET_HISTOGRAM_SUB_BITS	3
+#define KG_NET_HISTOGRAM_SUB_COUNT	(1 << KG_NET_HISTOGRAM_SUB_BITS)
+#define KG_NET_HISTOGRAM_BUCKETS	((64 - KG_NET_HISTOGRAM_SUB_BITS + 1) * KG_NET_HISTOGRAM_SUB_COUNT)
+
+/**
+*	\brief 延遲 直方圖 快照
+*
+*	以 對數線性 分桶 (類似 HDR Histogram) 每個 2的冪 區間 分爲 8 個 子桶 相對誤差 不超過 12.5%
+*/
+class histogram_snapshot_t
+{
+public:
+	/**
+	*	\brief 每個 桶的 計數
+	*
+	*/
+	std::vector<kg::uint64_t> buckets;
+	/**
+	*	\brief 記錄 總數
+	*
+	*/
+	kg::uint64_t count;
+	/**
+	*	\brief 記錄 總和
+	*
+	*/
+	kg::uint64_t sum;
+	/**
+	*	\brief 記錄 最大值
+	*
+	*/
+	kg::uint64_t max;
+
+	histogram_snapshot_t()
+		:buckets(KG_NET_HISTOGRAM_BUCKETS),count(0),sum(0),max(0)
+	{
+	}
+	/**
+	*	\brief 合併 另一個 快照
+	*
+	*/
+	histogram_snapshot_t& operator+=(const histogram_snapshot_t& other)
+	{
+		for(std::size_t i=0; i<buckets.size(); ++i)
+		{
+			buckets[i] += other.buckets[i];
+		}
+		count += other.count;
+		sum += other.sum;
+		if(other.max > max)
+		{
+			max = other.max;
+		}
+		return *this;
+	}
+	/**
+	*	\brief 返回 平均值
+	*
+	*/
+	double mean()const
+	{
+		return count ? double(sum) / double(count) : 0;
+	}
+	/**
+	*	\brief 返回 百分位數 (桶 上界)
+	*
+	*	\param p	百分位 [0,100]
+	*/
+	kg::uint64_t percentile(double p)const
+	{
+		if(!count)
+		{
+			return 0;
+		}
+		kg::uint64_t need = kg::uint64_t(double(count) * p / 100.0 + 0.5);
+		if(need < 1)
+		{
+			need = 1;
+		}
+		kg::uint64_t sum = 0;
+		for(std::size_t i=0; i<buckets.size(); ++i)
+		{
+			sum += buckets[i];
+			if(sum >= need)
+			{
+				kg::uint64_t upper = upper_bound(i);
+				return upper < max ? upper : max;
+			}
+		}
+		return max;
+	}
+	/**
+	*	\brief 返回 值 所在 桶
+	*
+	*/
+	static std::size_t index(kg::uint64_t v)
+	{
+		if(v < KG_NET_HISTOGRAM_SUB_COUNT)
+		{
+			return std::size_t(v);
+		}
+		std::size_t bits = 0;
+		for(kg::uint64_t n = v; n; n >>= 1)
+		{
+			++bits;
+		}
+		std::size_t shift = bits - 1 - KG_NET_HISTOGRAM_SUB_BITS;
+		return (shift + 1) * KG_NET_HISTOGRAM_SUB_COUNT + std::size_t((v >> shift) & (KG_NET_HISTOGRAM_SUB_COUNT - 1));
+	}
+	/**
+	*	\brief 返回 桶 能記錄的 最大值
+	*
+	*/
+	static kg::uint64_t upper_bound(std::size_t i)
+	{
+		if(i < KG_NET_HISTOGRAM_SUB_COUNT)
+		{
+			return i;
+		}
+		std::size_t shift = i / KG_NET_HISTOGRAM_SUB_COUNT - 1;
+		kg::uint64_t sub = i % KG_NET_HISTOGRAM_SUB_COUNT + KG_NET_HISTOGRAM_SUB_COUNT;
+		return ((sub + 1) << shift) - 1;
+	}
+};
+
+/**
+*	\brief 延遲 直方圖
+*
+*	單寫者 只能在 一個線程 record 其它線程 可隨時 snapshot
+*/
+class histogram_t
+	: boost::noncopyable
+{
+private:
+	counter_t _buckets[KG_NET_HISTOGRAM_BUCKETS];
+	counter_t _count;
+	counter_t _sum;
+	boost::atomic<kg::uint64_t> _max;
+public:
+	histogram_t():_max(0)
+	{
+	}
+	/**
+	*	\brief 記錄 一個值
+	*
+	*/
+	inline void record(kg::uint64_t v)
+	{
+		_buckets[histogram_snapshot_t::index(v)].add();
+		_count.add();
+		_sum.add(v);
+		if(v > _max.load(boost::memory_order_relaxed))
+		{
+			_max.store(v,boost::memory_order_relaxed);
+		}
+	}
+	/**
+	*	\brief 將 當前值 累加到 快照
+	*
+	*/
+	void snapshot(histogram_snapshot_t& out)const
+	{
+		for(std::size_t i=0; i<KG_NET_HISTOGRAM_BUCKETS; ++i)
+		{
+			out.buckets[i] += _buckets[i].get();
+		}
+		out.count += _count.get();
+		out.sum += _sum.get();
+		kg::uint64_t max = _max.load(boost::memory_order_relaxed);
+		if(max > out.max)
+		{
+			out.max = max;
+		}
+	}
+};
+
+/**
+*	\brief 服務器 統計 快照
+*
+*/
+class metrics_snapshot_t
+{
+public:
+	/**
+	*	\brief 快照 時間
+	*
+	*/
+	std::chrono::steady_clock::time_point time;
+	/**
+	*	\brief 接受的 連接數
+	*
+	*/
+	kg::uint64_t accepts;
+	/**
+	*	\brief 當前 連接數
+	*
+	*/
+	kg::uint64_t active;
+	/**
+	*	\brief 讀取 字節數
+	*
+	*/
+	kg::uint64_t bytes_in;
+	/**
+	*	\brief 經 發送隊列 寫出的 字節數
+	*
+	*/
+	kg::uint64_t bytes_out;
+	/**
+	*	\brief 讀取 次數
+	*
+	*/
+	kg::uint64_t reads;
+	/**
+	*	\brief 因 超時 被關閉的 連接數
+	*
+	*/
+	kg::uint64_t timeouts;
+	/**
+	*	\brief 因 連接數 限制 被拒絕的 連接數
+	*
+	*/
+	kg::uint64_t rejected;
+	/**
+	*	\brief 啓動的 連接 協程 數 (交給 空閒協程 的 連接 不計入)
+	*
+	*/
+	kg::uint64_t coroutines;
+	/**
+	*	\brief readed 回調 耗時 (微秒)
+	*
+	*/
+	histogram_snapshot_t latency;
+
+	metrics_snapshot_t()
+		:time(std::chrono::steady_clock::now()),
+		accepts(0),active(0),bytes_in(0),bytes_out(0),reads(0),timeouts(0),rejected(0),coroutines(0)
+	{
+	}
+	/**
+	*	\brief 合併 另一個 快照
+	*
+	*/
+	metrics_snapshot_t& operator+=(const metrics_snapshot_t& other)
+	{
+		accepts += other.accepts;
+		active += other.active;
+		bytes_in += other.bytes_in;
+		bytes_out += other.bytes_out;
+		reads += other.reads;
+		timeouts += other.timeouts;
+		rejected += other.rejected;
+		coroutines += other.coroutines;
+		latency += other.latency;
+		return *this;
+	}
+	/**
+	*	\brief 返回 自 prev 以來 每秒 讀取 次數
+	*
+	*/
+	double reads_per_second(const metrics_snapshot_t& prev)const
+	{
+		double seconds = std::chrono::duration<double>(time - prev.time).count();
+		if(seconds <= 0)
+		{
+			return 0;
+		}
+		return double(reads - prev.reads) / seconds;
+	}
+};
+
+/**
+*	\brief 一個 響應服務器(cpu) 的 統計
+*
+*	所有 計數器 只由 響應服務器 工作線程 寫入 snapshot 不需要 停止 工作線程
+*/
+class service_metrics_t
+	: boost::noncopyable
+{
+public:
+	counter_t accepts;
+	counter_t bytes_in;
+	counter_t bytes_out;
+	counter_t reads;
+	counter_t timeouts;
+	counter_t coroutines;
+	histogram_t latency;
+
+	/**
+	*	\brief 將 當前值 寫入 快照
+	*
+	*	\param active	當前 連接數
+	*/
+	void snapshot(metrics_snapshot_t& out,kg::uint64_t active)const
+	{
+		out.accepts += accepts.get();
+		out.active += active;
+		out.bytes_in += bytes_in.get();
+		out.bytes_out += bytes_out.get();
+		out.reads += reads.get();
+		out.timeouts += timeouts.get();
+		out.coroutines += coroutines.get();
+		latency.snapshot(out.latency);
+	}
+};
+
+/**
+*	\brief 服務器 統計
+*
+*/
+class server_metrics_t
+{
+public:
+	/**
+	*	\brief 每個 響應服務器(cpu) 的 統計
+	*
+	*/
+	std::vector<metrics_snapshot_t> services;
+	/**
+	*	\brief 所有 響應服務器 合計
+	*
+	*/
+	metrics_snapshot_t total;
+};
+};
+};
+#endif	//KG_NET_METRICS_HEADER_HPP
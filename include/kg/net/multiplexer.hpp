@@ -0,0 +1,335 @@
+#ifndef KG_NET_MULTIPLEXER_HEADER_HPP
+#define KG_NET_MULTIPLEXER_HEADER_HPP
+
+#include <boost/unordered_map.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "async_client.hpp"
+#include "notifier.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 消息體 前 關聯 id 的 字節數 (u32 大端)
+*
+*/
+#define KG_NET_MULTIPLEXER_ID_SIZE	4
+
+/**
+*	\brief 在 一個 連接 上 多路複用 請求/響應
+*
+*	每個 請求 消息體 前 加上 4字節 大端 關聯 id 服務器 需要 在 響應 消息體 前 原樣 返回 此 id\n
+*	任意 協程 (可在 不同 線程) 可 同時 call 請求 經 連接 發送隊列 合併 寫出 響應 可以 亂序 返回\n
+*	讀取 協程 按 id 在 待響應 表 中 找到 請求 並 喚醒 其 協程 連接 出錯 時 所有 待響應 請求 以 錯誤 返回\n
+*	讀取 寫出 關閉 與 超時 定時器 都 運行在 連接 的 strand 上 調用者 協程 只 通過 notifier_t 被 喚醒\n
+*	必須 由 type_spt 持有 (讀取 協程 持有 一個 引用 直到 連接 關閉)
+*
+*	\code
+	kg::net::multiplexer_spt mux = boost::make_shared<kg::net::multiplexer_t>(boost::ref(service));
+	//在 協程 中
+	mux->connect("127.0.0.1:1102",ctx);
+	kg::net::async_client_t::bytes_t b = mux->call(data,n,ctx);
+	\endcode
+*/
+class multiplexer_t
+	: public boost::enable_shared_from_this<multiplexer_t>,
+	boost::noncopyable
+{
+public:
+	/**
+	*	\brief type_t type_spt
+	*
+	*/
+	KG_TYPEDEF_TT(multiplexer_t);
+
+	typedef async_client_t::bytes_t bytes_t;
+private:
+	class request_t
+	{
+	public:
+		//只在 連接 strand 上 使用
+		deadline_timer_t timer;
+		//以下 只在 持有 mutex 時 使用
+		notifier_t notifier;
+		bool done;
+		bytes_t response;
+		boost::system::error_code ec;
+		explicit request_t(const strand_t& strand)
+			:timer(strand),done(false)
+		{
+		}
+	};
+	typedef boost::shared_ptr<request_t> request_spt;
+	typedef boost::unordered_map<kg::uint32_t,request_spt> pending_t;
+
+	async_client_t _client;
+
+	boost::mutex _mutex;
+	pending_t _pending;
+	kg::uint32_t _id;
+	//等待 發送隊列 可寫 的 請求
+	std::vector<request_spt> _blocked;
+	//是否 有 等待 可寫 的 協程
+	bool _watching;
+	//連接 出錯 後 所有 請求 返回 此 錯誤
+	boost::system::error_code _error;
+public:
+	/**
+	*	\param service	共享的 io_service
+	*	\param framer	分幀 規則 需要 是 長度前綴
+	*/
+	explicit multiplexer_t(io_service_t& service,const framer_t& framer = framer_t::length(4))
+		:_client(service,framer),_id(0),_watching(false)
+	{
+	}
+	/**
+	*	\brief 返回 底層 連接 用於 在 connect 前 設置 stage 與 socket 選項
+	*
+	*/
+	inline async_client_t& client()
+	{
+		return _client;
+	}
+	/**
+	*	\brief 連接 服務器 並 在 連接 strand 上 啓動 讀取 協程
+	*
+	*	\exception boost::system::system_error
+	*/
+	void connect(const std::string& addr,const boost::asio::yield_context& ctx)
+	{
+		_client.connect(addr,ctx);
+		boost::asio::spawn(_client.strand(),boost::bind(&multiplexer_t::coroutine_read,shared_from_this(),_1));
+	}
+	/**
+	*	\brief 在 連接 strand 上 關閉 連接 所有 待響應 請求 以 錯誤 返回
+	*
+	*	線程安全
+	*/
+	void close()
+	{
+		boost::asio::post(_client.strand(),boost::bind(&multiplexer_t::do_close,shared_from_this()));
+	}
+	/**
+	*	\brief 返回 待響應 請求數
+	*
+	*/
+	std::size_t pending()
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		return _pending.size();
+	}
+	/**
+	*	\brief 發送 請求 並 等待 對應的 響應
+	*
+	*	\param timeout	等待 響應 的 毫秒數 爲0 不限制 超時 後 遲到的 響應 被 丟棄
+	*	\exception boost::system::system_error
+	*	\return 去掉 關聯 id 的 響應 消息體
+	*/
+	bytes_t call(const kg::byte_t* b,std::size_t n,const boost::asio::yield_context& ctx,std::size_t timeout = 0)
+	{
+		request_spt request = boost::make_shared<request_t>(_client.strand());
+		kg::uint32_t id;
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			if(_error)
+			{
+				BOOST_THROW_EXCEPTION(boost::system::system_error(_error));
+			}
+			do
+			{
+				id = ++_id;
+			}
+			while(_pending.find(id) != _pending.end());
+			_pending[id] = request;
+		}
+
+		kg::byte_t prefix[KG_NET_MULTIPLEXER_ID_SIZE] = {kg::byte_t(id >> 24),kg::byte_t(id >> 16),kg::byte_t(id >> 8),kg::byte_t(id)};
+		try
+		{
+			//超過 發送隊列 高水位 時 由 連接 strand 上的 協程 等待 可寫 yield
+			while(!_client.send(prefix,KG_NET_MULTIPLEXER_ID_SIZE,b,n))
+			{
+				boost::mutex::scoped_lock lock(_mutex);
+				if(_error)
+				{
+					BOOST_THROW_EXCEPTION(boost::system::system_error(_error));
+				}
+				_blocked.push_back(request);
+				if(!_watching)
+				{
+					//spawn 可能 在 當前 線程 內聯 運行 協程 持有 mutex 時 只能 投遞
+					_watching = true;
+					boost::asio::post(_client.strand(),boost::bind(&multiplexer_t::spawn_writable,shared_from_this()));
+				}
+				request->notifier.wait(lock,ctx);
+			}
+		}
+		catch(...)
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			_pending.erase(id);
+			throw;
+		}
+
+		//在 連接 strand 上 啓動 超時 定時器
+		if(timeout)
+		{
+			boost::asio::post(_client.strand(),boost::bind(&multiplexer_t::do_timeout,shared_from_this(),id,request,timeout));
+		}
+		//等待 響應 yield
+		boost::mutex::scoped_lock lock(_mutex);
+		while(!request->done)
+		{
+			request->notifier.wait(lock,ctx);
+		}
+		if(request->ec)
+		{
+			BOOST_THROW_EXCEPTION(boost::system::system_error(request->ec));
+		}
+		return request->response;
+	}
+	/**
+	*	\brief 發送 請求 並 等待 對應的 響應
+	*
+	*/
+	bytes_t call(const kg::byte_t* b,std::size_t n,const boost::asio::yield_context& ctx,std::size_t timeout,boost::system::error_code& ec)
+	{
+		try
+		{
+			return call(b,n,ctx,timeout);
+		}
+		catch(const boost::system::system_error& e)
+		{
+			ec = e.code();
+		}
+		catch(const std::bad_alloc&)
+		{
+			ec = boost::system::error_code(KG_NET_ASYNC_CLIENT_CODE_BAD_ALLOC,async_client_category::get());
+		}
+		return bytes_t();
+	}
+private:
+	//以下 函數 都 運行在 連接 strand 上
+
+	//喚醒 請求 協程 需要 持有 mutex
+	static void complete(request_spt request)
+	{
+		request->done = true;
+		boost::system::error_code ec;
+		request->timer.cancel(ec);
+		request->notifier.notify();
+	}
+	void do_timeout(kg::uint32_t id,request_spt request,std::size_t timeout)
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		if(request->done)
+		{
+			return;
+		}
+		request->timer.expires_from_now(boost::posix_time::milliseconds(timeout));
+		request->timer.async_wait(boost::bind(&multiplexer_t::handler_timeout,shared_from_this(),id,request,_1));
+	}
+	void handler_timeout(kg::uint32_t id,request_spt request,const boost::system::error_code& e)
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		if(e || request->done)
+		{
+			return;
+		}
+		_pending.erase(id);
+		request->ec = boost::asio::error::timed_out;
+		complete(request);
+	}
+	void do_close()
+	{
+		boost::system::error_code ec;
+		_client.close(ec);
+	}
+	void spawn_writable()
+	{
+		boost::asio::spawn(_client.strand(),boost::bind(&multiplexer_t::coroutine_writable,shared_from_this(),_1));
+	}
+	void coroutine_writable(boost::asio::yield_context ctx)
+	{
+		boost::system::error_code ec;
+		try
+		{
+			//wait yield
+			_client.wait_writable(ctx);
+		}
+		catch(const boost::system::system_error& e)
+		{
+			ec = e.code();
+		}
+		boost::mutex::scoped_lock lock(_mutex);
+		if(ec && !_error)
+		{
+			_error = ec;
+		}
+		_watching = false;
+		BOOST_FOREACH(const request_spt& request,_blocked)
+		{
+			request->notifier.notify();
+		}
+		_blocked.clear();
+	}
+	void coroutine_read(boost::asio::yield_context ctx)
+	{
+		boost::system::error_code ec;
+		while(true)
+		{
+			//讀取 響應 yield
+			bytes_t msg = _client.read(ctx,ec);
+			if(ec)
+			{
+				break;
+			}
+			if(msg.size() < KG_NET_MULTIPLEXER_ID_SIZE)
+			{
+				ec = boost::system::error_code(KG_NET_ASYNC_CLIENT_CODE_BAD_MSG,async_client_category::get());
+				break;
+			}
+			const kg::byte_t* b = msg.get();
+			kg::uint32_t id = (kg::uint32_t(b[0]) << 24) | (kg::uint32_t(b[1]) << 16) | (kg::uint32_t(b[2]) << 8) | kg::uint32_t(b[3]);
+
+			boost::mutex::scoped_lock lock(_mutex);
+			BOOST_AUTO(find,_pending.find(id));
+			//已經 超時 的 請求
+			if(find == _pending.end())
+			{
+				continue;
+			}
+			//響應 引用 接收 緩衝區 不拷貝
+			find->second->response = msg.range(KG_NET_MULTIPLEXER_ID_SIZE);
+			complete(find->second);
+			_pending.erase(find);
+		}
+
+		//通知 所有 待響應 與 等待 可寫 的 請求
+		do_close();
+		boost::mutex::scoped_lock lock(_mutex);
+		if(!_error)
+		{
+			_error = ec;
+		}
+		BOOST_FOREACH(const pending_t::value_type& node,_pending)
+		{
+			node.second->ec = _error;
+			complete(node.second);
+		}
+		_pending.clear();
+		BOOST_FOREACH(const request_spt& request,_blocked)
+		{
+			request->notifier.notify();
+		}
+		_blocked.clear();
+	}
+};
+typedef multiplexer_t::type_spt multiplexer_spt;
+
+};
+};
+#endif // KG_NET_MULTIPLEXER_HEADER_HPP
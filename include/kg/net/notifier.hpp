@@ -0,0 +1,89 @@
+#ifndef KG_NET_NOTIFIER_HEADER_HPP
+#define KG_NET_NOTIFIER_HEADER_HPP
+
+#include <boost/noncopyable.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/asio/spawn.hpp>
+
+#include "types.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 掛起 協程 直到 其它 線程 通知
+*
+*	wait 保存 協程 的 完成 回調 notify 將其 投遞到 協程 所屬的 executor 上 恢復 通知者 無需 與 協程 在 同一 strand\n
+*	wait 與 notify 需要 持有 同一個 外部 mutex 先於 wait 的 notify 不會 丟失 一次 只能 有 一個 協程 等待
+*/
+class notifier_t
+	: boost::noncopyable
+{
+private:
+	typedef void signature_t(boost::system::error_code);
+	typedef boost::asio::async_completion<boost::asio::yield_context,signature_t> completion_t;
+	typedef completion_t::completion_handler_type handler_t;
+	typedef boost::asio::associated_executor<handler_t>::type executor_t;
+	class waiter_t
+	{
+	public:
+		handler_t handler;
+		//等待 期間 協程 所屬的 io_service 不會 因爲 沒有 任務 而 返回
+		boost::asio::executor_work_guard<executor_t> work;
+		explicit waiter_t(const handler_t& handler)
+			:handler(handler),work(boost::asio::get_associated_executor(handler))
+		{
+		}
+	};
+
+	bool _notified;
+	boost::shared_ptr<waiter_t> _waiter;
+public:
+	notifier_t()
+		:_notified(false)
+	{
+	}
+	/**
+	*	\brief 掛起 協程 直到 notify 已經 被 通知 時 立刻 返回
+	*
+	*	調用時 lock 需要 已 鎖定 等待 期間 解鎖 返回時 重新 鎖定
+	*
+	*	\exception std::bad_alloc
+	*/
+	void wait(boost::mutex::scoped_lock& lock,boost::asio::yield_context ctx)
+	{
+		if(!_notified)
+		{
+			completion_t completion(ctx);
+			_waiter = boost::make_shared<waiter_t>(completion.completion_handler);
+			lock.unlock();
+			//yield
+			completion.result.get();
+			lock.lock();
+		}
+		_notified = false;
+	}
+	/**
+	*	\brief 恢復 等待中的 協程 沒有 等待者 時 記錄 通知
+	*
+	*	需要 持有 wait 使用的 mutex
+	*/
+	void notify()
+	{
+		_notified = true;
+		if(_waiter)
+		{
+			boost::shared_ptr<waiter_t> waiter;
+			waiter.swap(_waiter);
+			boost::asio::post(waiter->work.get_executor(),
+				boost::bind<void>(waiter->handler,boost::system::error_code())
+			);
+		}
+	}
+};
+
+};
+};
+#endif // KG_NET_NOTIFIER_HEADER_HPP
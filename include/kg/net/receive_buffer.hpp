@@ -0,0 +1,134 @@
+#ifndef KG_NET_RECEIVE_BUFFER_HEADER_HPP
+#define KG_NET_RECEIVE_BUFFER_HEADER_HPP
+
+#include <cstring>
+
+#include <boost/noncopyable.hpp>
+
+#include "types.hpp"
+#include "../slice.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 客戶端 默認 每次 讀取 至少 準備的 字節數
+*
+*/
+#define KG_NET_RECEIVE_BUFFER_SIZE	(64 * 1024)
+
+/**
+*	\brief 客戶端 接收 緩衝區
+*
+*	prepare 返回 可寫入的 連續 空間 讀取 完成後 commit 寫入的 字節數\n
+*	slice 返回 引用 緩衝區 內存 的 切片 不拷貝 被 引用的 內存 不會 再被 寫入\n
+*	空間 不足 時 分配 新的 內存 只 拷貝 未讀取的 數據 舊內存 在 所有 切片 釋放後 回收\n
+*	非線程安全
+*/
+class receive_buffer_t
+	: boost::noncopyable
+{
+public:
+	typedef kg::slice_t<kg::byte_t> bytes_t;
+private:
+	bytes_t _storage;
+	std::size_t _begin;
+	std::size_t _end;
+	std::size_t _read;
+	//[0,_begin) 是否 被 切片 引用
+	bool _published;
+public:
+	/**
+	*	\param read	每次 prepare 至少 準備的 字節數
+	*/
+	explicit receive_buffer_t(std::size_t read = KG_NET_RECEIVE_BUFFER_SIZE)
+		:_begin(0),_end(0),_read(read ? read : 1),_published(false)
+	{
+	}
+	/**
+	*	\brief 返回 未讀取的 數據
+	*
+	*/
+	inline kg::byte_t* data()const
+	{
+		return _storage.get() + _begin;
+	}
+	/**
+	*	\brief 返回 未讀取的 數據 長度
+	*
+	*/
+	inline std::size_t size()const
+	{
+		return _end - _begin;
+	}
+	/**
+	*	\brief 返回 至少 n 字節 (不少於 構造時 指定的 讀取量) 的 可寫入 空間
+	*
+	*	\exception std::bad_alloc
+	*/
+	boost::asio::mutable_buffers_1 prepare(std::size_t n = 0)
+	{
+		if(n < _read)
+		{
+			n = _read;
+		}
+		const std::size_t capacity = _storage.size();
+		if(capacity - _end < n)
+		{
+			const std::size_t size = _end - _begin;
+			if(!_published && capacity >= size + n)
+			{
+				//內存 未被 引用 前移 未讀取的 數據
+				std::memmove(_storage.get(),_storage.get() + _begin,size);
+			}
+			else
+			{
+				bytes_t storage(size + n);
+				if(size)
+				{
+					std::memcpy(storage.get(),_storage.get() + _begin,size);
+				}
+				_storage = storage;
+				_published = false;
+			}
+			_begin = 0;
+			_end = size;
+		}
+		return boost::asio::buffer(_storage.get() + _end,_storage.size() - _end);
+	}
+	/**
+	*	\brief 將 讀取到 prepare 空間 的 n 字節 加入 未讀取 數據
+	*
+	*/
+	inline void commit(std::size_t n)
+	{
+		_end += n;
+	}
+	/**
+	*	\brief 丟棄 n 字節 未讀取 數據
+	*
+	*/
+	inline void consume(std::size_t n)
+	{
+		_begin += n;
+		if(_begin == _end && !_published)
+		{
+			_begin = _end = 0;
+		}
+	}
+	/**
+	*	\brief 取出 n 字節 未讀取 數據 返回的 切片 引用 緩衝區 內存
+	*
+	*/
+	bytes_t slice(std::size_t n)
+	{
+		bytes_t b = _storage.range(_begin,_begin + n);
+		_published = true;
+		_begin += n;
+		return b;
+	}
+};
+};
+};
+#endif	//KG_NET_RECEIVE_BUFFER_HEADER_HPP
@@ -0,0 +1,404 @@
+#ifndef KG_NET_SESSION_TABLE_HEADER_HPP
+#define KG_NET_SESSION_TABLE_HEADER_HPP
+
+#include <vector>
+#include <algorithm>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "types.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 以 64位 id 爲 鍵 的 分片 哈希表 讀取 無鎖
+*
+*	每個 分片 是一個 線性探測 的 開放定址表 槽 中 保存 指向 條目 的 原子指針\n
+*	寫入 (insert erase) 持有 分片 互斥量 只修改 一個 槽 不複製 整表 故爲 O(1)\n
+*	讀取 (find) 不加鎖 只對 分片 當前 紀元 的 讀者計數 做 原子加減\n
+*	被 移除的 條目 與 擴容後 的 舊表 先 等待 寫入者 推進 紀元 之後 只需 等待 舊紀元 的 讀者 離開 即可 由 寫入者 釋放\n
+*	新 讀者 總是 計入 新紀元 故 持續 查找 時 舊紀元 計數 也會 在 一次 查找 的 時間 內 歸零 延遲 釋放 的 內存 有界
+*
+*	\param T	值 型別 需要 支持 copy 語義
+*/
+template<typename T>
+class session_table_t
+	: boost::noncopyable
+{
+private:
+	class entry_t
+	{
+	public:
+		kg::uint64_t id;
+		T value;
+		entry_t(kg::uint64_t id,const T& value)
+			:id(id),value(value)
+		{
+		}
+	};
+	class table_t
+	{
+	public:
+		std::size_t mask;
+		boost::atomic<entry_t*>* slots;
+		explicit table_t(std::size_t capacity)
+			:mask(capacity - 1),slots(new boost::atomic<entry_t*>[capacity])
+		{
+			for(std::size_t i=0;i<capacity;++i)
+			{
+				slots[i].store(NULL,boost::memory_order_relaxed);
+			}
+		}
+		~table_t()
+		{
+			delete[] slots;
+		}
+	};
+	//等待 釋放 的 舊數據
+	class retired_t
+	{
+	public:
+		std::vector<entry_t*> entries;
+		std::vector<table_t*> tables;
+		inline bool empty()const
+		{
+			return entries.empty() && tables.empty();
+		}
+		void release()
+		{
+			for(std::size_t i=0;i<entries.size();++i)
+			{
+				delete entries[i];
+			}
+			entries.clear();
+			for(std::size_t i=0;i<tables.size();++i)
+			{
+				delete tables[i];
+			}
+			tables.clear();
+		}
+	};
+	class shard_t
+		: boost::noncopyable
+	{
+	public:
+		boost::atomic<table_t*> table;
+		//讀者 計入 readers[epoch & 1]
+		boost::atomic<std::size_t> epoch;
+		boost::atomic<std::size_t> readers[2];
+
+		//以下 只在 持有 mutex 時 使用
+		boost::mutex mutex;
+		std::size_t used;
+		std::size_t tombs;
+		//上次 推進 紀元 之後 移除的
+		retired_t retired;
+		//上次 推進 紀元 之前 移除的 等待 readers[waiting_epoch & 1] 歸零
+		retired_t waiting;
+		std::size_t waiting_epoch;
+
+		shard_t()
+			:table(NULL),epoch(0),used(0),tombs(0),waiting_epoch(0)
+		{
+			readers[0].store(0,boost::memory_order_relaxed);
+			readers[1].store(0,boost::memory_order_relaxed);
+		}
+	};
+	std::vector<shard_t*> _shards;
+	std::size_t _mask;
+	unsigned _bits;
+	//已刪除 標記
+	entry_t _tomb;
+
+	static inline kg::uint64_t mix(kg::uint64_t id)
+	{
+		id ^= id >> 33;
+		id *= 0xff51afd7ed558ccdULL;
+		id ^= id >> 33;
+		return id;
+	}
+	inline shard_t& shard(kg::uint64_t hash)const
+	{
+		return *_shards[hash & _mask];
+	}
+
+	//釋放 沒有 讀者 能 看到的 舊數據 需要 持有 mutex
+	void reclaim(shard_t& s)
+	{
+		if(!s.waiting.empty())
+		{
+			if(s.readers[s.waiting_epoch & 1].load(boost::memory_order_seq_cst))
+			{
+				return;
+			}
+			s.waiting.release();
+		}
+		if(s.retired.empty())
+		{
+			return;
+		}
+		//推進 紀元 之後的 讀者 看不到 retired 只需 等待 舊紀元 的 讀者
+		s.waiting_epoch = s.epoch.fetch_add(1,boost::memory_order_seq_cst);
+		std::swap(s.waiting,s.retired);
+		if(!s.readers[s.waiting_epoch & 1].load(boost::memory_order_seq_cst))
+		{
+			s.waiting.release();
+		}
+	}
+	//等待 所有 已經 開始的 讀者 離開 之後 釋放 所有 舊數據 需要 持有 mutex
+	void synchronize(shard_t& s)
+	{
+		//推進 兩次 兩個 計數 都 只剩 推進 之後的 讀者
+		for(int i=0;i<2;++i)
+		{
+			std::size_t epoch = s.epoch.fetch_add(1,boost::memory_order_seq_cst);
+			while(s.readers[epoch & 1].load(boost::memory_order_seq_cst))
+			{
+				boost::this_thread::yield();
+			}
+		}
+		s.waiting.release();
+		s.retired.release();
+	}
+	//重建 分片 清除 刪除標記 需要 持有 mutex
+	void rebuild(shard_t& s,std::size_t capacity)
+	{
+		table_t* old = s.table.load(boost::memory_order_relaxed);
+		//先 預留 使 替換 之後 不會 失敗
+		s.retired.tables.reserve(s.retired.tables.size() + 1);
+		table_t* t = new table_t(capacity);
+		for(std::size_t i=0;i<=old->mask;++i)
+		{
+			entry_t* e = old->slots[i].load(boost::memory_order_relaxed);
+			if(e && e != &_tomb)
+			{
+				std::size_t pos = (mix(e->id) >> _bits) & t->mask;
+				while(t->slots[pos].load(boost::memory_order_relaxed))
+				{
+					pos = (pos + 1) & t->mask;
+				}
+				t->slots[pos].store(e,boost::memory_order_relaxed);
+			}
+		}
+		s.table.store(t,boost::memory_order_seq_cst);
+		s.tombs = 0;
+		s.retired.tables.push_back(old);
+	}
+public:
+	/**
+	*	\param shards	分片數 會被 調整爲 2的冪 爲0 使用 64
+	*	\param capacity	每個 分片 初始 容量 會被 調整爲 2的冪
+	*
+	*	\exception std::bad_alloc
+	*/
+	explicit session_table_t(std::size_t shards = 64,std::size_t capacity = 16)
+		:_bits(0),_tomb(0,T())
+	{
+		if(!shards)
+		{
+			shards = 64;
+		}
+		std::size_t n = 1;
+		while(n < shards)
+		{
+			n <<= 1;
+			++_bits;
+		}
+		_mask = n - 1;
+		std::size_t c = 4;
+		while(c < capacity)
+		{
+			c <<= 1;
+		}
+
+		_shards.reserve(n);
+		try
+		{
+			for(std::size_t i=0;i<n;++i)
+			{
+				_shards.push_back(new shard_t());
+				_shards.back()->table.store(new table_t(c),boost::memory_order_relaxed);
+			}
+		}
+		catch(const std::bad_alloc&)
+		{
+			clear();
+			throw;
+		}
+	}
+	~session_table_t()
+	{
+		clear();
+	}
+	/**
+	*	\brief 加入 id 對應的 值 id 不能 已經 存在 需要 外部 保證
+	*
+	*	\exception std::bad_alloc
+	*/
+	void insert(kg::uint64_t id,const T& value)
+	{
+		const kg::uint64_t hash = mix(id);
+		shard_t& s = shard(hash);
+		boost::mutex::scoped_lock lock(s.mutex);
+
+		//負載 超過 一半 時 擴容 或 清除 刪除標記
+		table_t* t = s.table.load(boost::memory_order_relaxed);
+		const std::size_t capacity = t->mask + 1;
+		if((s.used + s.tombs + 1) * 2 > capacity)
+		{
+			rebuild(s,(s.used + 1) * 4 > capacity ? capacity * 2 : capacity);
+			t = s.table.load(boost::memory_order_relaxed);
+		}
+
+		entry_t* e = new entry_t(id,value);
+		std::size_t pos = (hash >> _bits) & t->mask;
+		while(true)
+		{
+			entry_t* old = t->slots[pos].load(boost::memory_order_relaxed);
+			if(!old || old == &_tomb)
+			{
+				if(old)
+				{
+					--s.tombs;
+				}
+				break;
+			}
+			pos = (pos + 1) & t->mask;
+		}
+		t->slots[pos].store(e,boost::memory_order_seq_cst);
+		++s.used;
+		reclaim(s);
+	}
+	/**
+	*	\brief 移除 id 對應的 值
+	*
+	*	\return id 不存在 時 返回 false
+	*/
+	bool erase(kg::uint64_t id)
+	{
+		const kg::uint64_t hash = mix(id);
+		shard_t& s = shard(hash);
+		boost::mutex::scoped_lock lock(s.mutex);
+
+		table_t* t = s.table.load(boost::memory_order_relaxed);
+		std::size_t pos = (hash >> _bits) & t->mask;
+		while(true)
+		{
+			entry_t* e = t->slots[pos].load(boost::memory_order_relaxed);
+			if(!e)
+			{
+				return false;
+			}
+			if(e != &_tomb && e->id == id)
+			{
+				t->slots[pos].store(&_tomb,boost::memory_order_seq_cst);
+				--s.used;
+				++s.tombs;
+				try
+				{
+					s.retired.entries.push_back(e);
+				}
+				catch(const std::bad_alloc&)
+				{
+					//無法 延遲 釋放 時 等待 已經 開始的 讀者 離開 (新 讀者 看不到 e 等待 有界)
+					synchronize(s);
+					delete e;
+				}
+				reclaim(s);
+				return true;
+			}
+			pos = (pos + 1) & t->mask;
+		}
+	}
+	/**
+	*	\brief 查找 id 對應的 值 可在 任意線程 調用 不加鎖
+	*
+	*	\return id 不存在 時 返回 false
+	*/
+	bool find(kg::uint64_t id,T& value)const
+	{
+		const kg::uint64_t hash = mix(id);
+		shard_t& s = shard(hash);
+		bool ok = false;
+
+		//計入 當前 紀元 計入 時 紀元 已 推進 則 重試
+		std::size_t epoch;
+		while(true)
+		{
+			epoch = s.epoch.load(boost::memory_order_seq_cst);
+			s.readers[epoch & 1].fetch_add(1,boost::memory_order_seq_cst);
+			if(s.epoch.load(boost::memory_order_seq_cst) == epoch)
+			{
+				break;
+			}
+			s.readers[epoch & 1].fetch_sub(1,boost::memory_order_seq_cst);
+		}
+		table_t* t = s.table.load(boost::memory_order_seq_cst);
+		std::size_t pos = (hash >> _bits) & t->mask;
+		while(true)
+		{
+			entry_t* e = t->slots[pos].load(boost::memory_order_seq_cst);
+			if(!e)
+			{
+				break;
+			}
+			if(e != &_tomb && e->id == id)
+			{
+				value = e->value;
+				ok = true;
+				break;
+			}
+			pos = (pos + 1) & t->mask;
+		}
+		s.readers[epoch & 1].fetch_sub(1,boost::memory_order_seq_cst);
+		return ok;
+	}
+	/**
+	*	\brief 返回 元素數量 寫入 併發時 只是 近似值
+	*
+	*/
+	std::size_t size()const
+	{
+		std::size_t n = 0;
+		for(std::size_t i=0;i<_shards.size();++i)
+		{
+			boost::mutex::scoped_lock lock(_shards[i]->mutex);
+			n += _shards[i]->used;
+		}
+		return n;
+	}
+private:
+	void clear()
+	{
+		for(std::size_t i=0;i<_shards.size();++i)
+		{
+			shard_t* s = _shards[i];
+			table_t* t = s->table.load(boost::memory_order_relaxed);
+			if(t)
+			{
+				for(std::size_t j=0;j<=t->mask;++j)
+				{
+					entry_t* e = t->slots[j].load(boost::memory_order_relaxed);
+					if(e && e != &_tomb)
+					{
+						delete e;
+					}
+				}
+				delete t;
+			}
+			s->table.store(NULL,boost::memory_order_relaxed);
+			s->waiting.release();
+			s->retired.release();
+			delete s;
+		}
+		_shards.clear();
+	}
+};
+};
+};
+#endif	//KG_NET_SESSION_TABLE_HEADER_HPP
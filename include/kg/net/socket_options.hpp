@@ -0,0 +1,218 @@
+#ifndef KG_NET_SOCKET_OPTIONS_HEADER_HPP
+#define KG_NET_SOCKET_OPTIONS_HEADER_HPP
+
+#include <boost/asio.hpp>
+
+#ifdef __linux__
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif // __linux__
+
+#include "types.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief tcp socket 選項
+*
+*	數值選項 爲0 表示 不設置 使用 系統 默認值\n
+*	TCP_QUICKACK TCP_KEEPIDLE TCP_KEEPINTVL TCP_KEEPCNT TCP_DEFER_ACCEPT 只在 linux 上 生效 其它平臺 被忽略
+*/
+class socket_options_t
+{
+public:
+	/**
+	*	\brief 是否 設置 TCP_NODELAY 關閉 Nagle 算法
+	*
+	*	請求/響應 式 協議 應設置 否則 小消息 可能被 延遲 40ms
+	*/
+	bool no_delay;
+	/**
+	*	\brief SO_RCVBUF (字節)
+	*
+	*	設置在 監聽 socket 上時 accept 的 連接 會 繼承 從而 影響 握手時 通告的 窗口
+	*/
+	int recv_buffer;
+	/**
+	*	\brief SO_SNDBUF (字節)
+	*
+	*/
+	int send_buffer;
+	/**
+	*	\brief 是否 設置 TCP_QUICKACK 立即 回覆 ack
+	*
+	*	此選項 不是 持久的 內核 可能 隨時 將其 重置 basic_server_t 會在 每次 讀取後 重新設置
+	*/
+	bool quick_ack;
+	/**
+	*	\brief 是否 設置 SO_KEEPALIVE
+	*
+	*/
+	bool keep_alive;
+	/**
+	*	\brief TCP_KEEPIDLE 連接 空閒 多久後 開始 發送 探測 (秒)
+	*
+	*/
+	int keep_idle;
+	/**
+	*	\brief TCP_KEEPINTVL 探測 間隔 (秒)
+	*
+	*/
+	int keep_interval;
+	/**
+	*	\brief TCP_KEEPCNT 探測 失敗 多少次 後 斷開
+	*
+	*/
+	int keep_count;
+	/**
+	*	\brief listen 隊列 長度 爲0 使用 socket_base::max_listen_connections
+	*
+	*/
+	int backlog;
+	/**
+	*	\brief TCP_DEFER_ACCEPT 收到 數據後 才 喚醒 accept 最多 等待 的 秒數
+	*
+	*/
+	int defer_accept;
+
+	socket_options_t()
+		:no_delay(false),recv_buffer(0),send_buffer(0),quick_ack(false),
+		keep_alive(false),keep_idle(0),keep_interval(0),keep_count(0),
+		backlog(0),defer_accept(0)
+	{
+	}
+
+	/**
+	*	\brief 返回 listen 隊列 長度
+	*
+	*/
+	inline int listen_backlog()const
+	{
+		return backlog > 0 ? backlog : int(boost::asio::socket_base::max_listen_connections);
+	}
+	/**
+	*	\brief 將 選項 設置到 監聽 socket (在 bind listen 之前 調用)
+	*
+	*	設置 SO_RCVBUF SO_SNDBUF TCP_DEFER_ACCEPT
+	*
+	*	\exception boost::system::system_error
+	*/
+	void apply(acceptor_t& acceptor)const
+	{
+		if(recv_buffer > 0)
+		{
+			acceptor.set_option(boost::asio::socket_base::receive_buffer_size(recv_buffer));
+		}
+		if(send_buffer > 0)
+		{
+			acceptor.set_option(boost::asio::socket_base::send_buffer_size(send_buffer));
+		}
+#ifdef __linux__
+		if(defer_accept > 0)
+		{
+			acceptor.set_option(boost::asio::detail::socket_option::integer<IPPROTO_TCP,TCP_DEFER_ACCEPT>(defer_accept));
+		}
+#endif // __linux__
+	}
+	/**
+	*	\brief 將 選項 設置到 監聽 socket (在 bind listen 之前 調用)
+	*
+	*/
+	void apply(acceptor_t& acceptor,boost::system::error_code& ec)const
+	{
+		try
+		{
+			apply(acceptor);
+		}
+		catch(const boost::system::system_error& e)
+		{
+			ec = e.code();
+		}
+	}
+	/**
+	*	\brief 將 選項 設置到 已連接的 socket
+	*
+	*	\exception boost::system::system_error
+	*/
+	void apply(socket_t& s)const
+	{
+		if(no_delay)
+		{
+			s.set_option(boost::asio::ip::tcp::no_delay(true));
+		}
+		if(recv_buffer > 0)
+		{
+			s.set_option(boost::asio::socket_base::receive_buffer_size(recv_buffer));
+		}
+		if(send_buffer > 0)
+		{
+			s.set_option(boost::asio::socket_base::send_buffer_size(send_buffer));
+		}
+		if(keep_alive)
+		{
+			s.set_option(boost::asio::socket_base::keep_alive(true));
+#ifdef __linux__
+			if(keep_idle > 0)
+			{
+				s.set_option(boost::asio::detail::socket_option::integer<IPPROTO_TCP,TCP_KEEPIDLE>(keep_idle));
+			}
+			if(keep_interval > 0)
+			{
+				s.set_option(boost::asio::detail::socket_option::integer<IPPROTO_TCP,TCP_KEEPINTVL>(keep_interval));
+			}
+			if(keep_count > 0)
+			{
+				s.set_option(boost::asio::detail::socket_option::integer<IPPROTO_TCP,TCP_KEEPCNT>(keep_count));
+			}
+#endif // __linux__
+		}
+		rearm(s);
+	}
+	/**
+	*	\brief 將 選項 設置到 已連接的 socket
+	*
+	*/
+	void apply(socket_t& s,boost::system::error_code& ec)const
+	{
+		try
+		{
+			apply(s);
+		}
+		catch(const boost::system::system_error& e)
+		{
+			ec = e.code();
+		}
+	}
+	/**
+	*	\brief 重新設置 非持久的 選項 (TCP_QUICKACK)
+	*
+	*	\exception boost::system::system_error
+	*/
+	inline void rearm(socket_t& s)const
+	{
+#ifdef __linux__
+		if(quick_ack)
+		{
+			s.set_option(boost::asio::detail::socket_option::boolean<IPPROTO_TCP,TCP_QUICKACK>(true));
+		}
+#endif // __linux__
+	}
+	/**
+	*	\brief 重新設置 非持久的 選項 (TCP_QUICKACK)
+	*
+	*/
+	inline void rearm(socket_t& s,boost::system::error_code& ec)const
+	{
+#ifdef __linux__
+		if(quick_ack)
+		{
+			s.set_option(boost::asio::detail::socket_option::boolean<IPPROTO_TCP,TCP_QUICKACK>(true),ec);
+		}
+#endif // __linux__
+	}
+};
+};
+};
+#endif	//KG_NET_SOCKET_OPTIONS_HEADER_HPP
@@ -0,0 +1,258 @@
+#ifndef KG_NET_STAGE_HEADER_HPP
+#define KG_NET_STAGE_HEADER_HPP
+
+#include <cstring>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/shared_array.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "types.hpp"
+#include "compressor.hpp"
+#include "../crypto/k3xsx_salt.hpp"
+
+namespace kg
+{
+namespace net
+{
+/**
+*	\brief 在 各 stage 間 傳遞 的 消息 視圖
+*
+*	data 可以 指向 接收 緩衝區 owner 爲空 時 不擁有 內存\n
+*	headroom 是 data 之前 可以 寫入 的 字節數 編碼 時 用於 原地 加上 頭部\n
+*	limit 是 解碼 輸出 的 最大 長度 爲0 不限制 echo_server_t 在 解碼 時 設爲 當前的 max_frame
+*/
+class view_t
+{
+public:
+	kg::byte_t* data;
+	std::size_t size;
+	std::size_t headroom;
+	boost::shared_array<kg::byte_t> owner;
+	std::size_t limit;
+
+	view_t():data(NULL),size(0),headroom(0),limit(0)
+	{
+	}
+	view_t(kg::byte_t* data,std::size_t size,std::size_t headroom = 0,boost::shared_array<kg::byte_t> owner = boost::shared_array<kg::byte_t>())
+		:data(data),size(size),headroom(headroom),owner(owner),limit(0)
+	{
+	}
+	/**
+	*	\brief 分配 headroom + size 字節 的 新 緩衝區 data 指向 headroom 之後
+	*
+	*	\exception std::bad_alloc
+	*/
+	void reset(std::size_t headroom,std::size_t size)
+	{
+		owner.reset(new kg::byte_t[headroom + size]);
+		data = owner.get() + headroom;
+		this->size = size;
+		this->headroom = headroom;
+	}
+	/**
+	*	\brief 返回 是否 可以 在 data 之前 原地 寫入 n 字節
+	*
+	*/
+	inline bool writable(std::size_t n)const
+	{
+		return owner && headroom >= n;
+	}
+};
+
+/**
+*	\brief echo_server_t 的 消息 處理 階段
+*
+*	收到 消息 時 去掉 幀頭 後 按 加入 順序 調用 decode\n
+*	發送 消息 時 按 相反 順序 調用 encode 之後 加上 幀頭\n
+*	stage 被 所有 連接 與 工作線程 共享 需要 線程安全 能 原地 完成 的 轉換 不應 分配 內存
+*/
+class stage_t
+{
+public:
+	KG_TYPEDEF_TT(stage_t);
+	virtual ~stage_t()
+	{
+	}
+	/**
+	*	\brief 返回 encode 最多 在 data 之前 加上 的 字節數
+	*
+	*/
+	virtual std::size_t headroom()const
+	{
+		return 0;
+	}
+	/**
+	*	\brief 解碼 收到的 消息 可以 原地 修改 view.data 或 替換 view
+	*
+	*	\exception std::bad_alloc
+	*	\return 數據 非法 返回 false 連接 將被 斷開
+	*/
+	virtual bool decode(view_t& view) = 0;
+	/**
+	*	\brief 編碼 待發送 消息 結果 之前 必須 保留 至少 headroom 字節 供 之後的 stage 與 幀頭 使用
+	*
+	*	\exception std::bad_alloc
+	*	\return 無法 編碼 返回 false
+	*/
+	virtual bool encode(view_t& view,std::size_t headroom) = 0;
+};
+typedef stage_t::type_spt stage_spt;
+
+/**
+*	\brief k3xsx_salt_t 加密 階段
+*
+*	解密 原地 完成 加密 在 有 足夠 headroom 時 原地 完成 否則 加密 到 新 緩衝區 (同時 完成 拷貝)
+*/
+class crypto_stage_t
+	: public stage_t
+{
+private:
+	kg::crypto::k3xsx_salt_t _crypto;
+public:
+	explicit crypto_stage_t(const kg::byte_t salt = 0)
+		:_crypto(salt)
+	{
+	}
+	virtual std::size_t headroom()const
+	{
+		return kg::crypto::k3xsx_salt_t::salt_len();
+	}
+	virtual bool decode(view_t& view)
+	{
+		const std::size_t salt = kg::crypto::k3xsx_salt_t::salt_len();
+		//明文 寫在 鹽 之後 逐字節 讀取 後 寫回 原位置
+		if(!_crypto.decryption(view.data,view.size,view.data + salt))
+		{
+			return false;
+		}
+		view.data += salt;
+		view.size -= salt;
+		view.headroom += salt;
+		return true;
+	}
+	virtual bool encode(view_t& view,std::size_t headroom)
+	{
+		const std::size_t salt = kg::crypto::k3xsx_salt_t::salt_len();
+		if(view.writable(salt + headroom))
+		{
+			_crypto.encryption(view.data,view.size,view.data - salt);
+			view.data -= salt;
+			view.size += salt;
+			view.headroom -= salt;
+			return true;
+		}
+		view_t out;
+		out.reset(headroom,salt + view.size);
+		_crypto.encryption(view.data,view.size,out.data);
+		view = out;
+		return true;
+	}
+};
+
+/**
+*	\brief compressor_t 壓縮 階段
+*
+*	每個 工作線程 一個 compressor_t (zlib 狀態 較大 不爲 每個 連接 創建)\n
+*	壓縮 與 解壓 無法 原地 完成 輸出 到 新 緩衝區 (回調 可能 讓出 協程 不能 使用 線程 共享的 緩衝區)\n
+*	不壓縮 的 消息 在 有 足夠 headroom 時 原地 加上 標記 否則 只 拷貝 一次\n
+*	未壓縮 的 消息 解碼 時 直接 指向 原數據 解壓後 長度 受 max 與 view_t::limit 中 較小者 限制
+*/
+class compress_stage_t
+	: public stage_t
+{
+private:
+	std::size_t _threshold;
+	int _level;
+	std::size_t _max;
+	boost::thread_specific_ptr<compressor_t> _compressors;
+
+	compressor_t& compressor()
+	{
+		compressor_t* c = _compressors.get();
+		if(!c)
+		{
+			c = new compressor_t(_threshold,_level,_max);
+			_compressors.reset(c);
+		}
+		return *c;
+	}
+public:
+	/**
+	*	\param threshold	消息 長度 達到 此值 才 壓縮
+	*	\param level	zlib 壓縮 等級
+	*	\param max	解壓後 最大 長度
+	*/
+	explicit compress_stage_t(std::size_t threshold = KG_NET_COMPRESS_THRESHOLD,int level = Z_DEFAULT_COMPRESSION,std::size_t max = KG_NET_COMPRESS_MAX)
+		:_threshold(threshold),_level(level),_max(max)
+	{
+	}
+	virtual bool decode(view_t& view)
+	{
+		compressor_t& c = compressor();
+		std::size_t size;
+		int flag = c.peek(view.data,view.size,size);
+		if(flag == KG_NET_COMPRESS_FLAG_RAW)
+		{
+			++view.data;
+			view.size = size;
+			++view.headroom;
+			return true;
+		}
+		else if(flag != KG_NET_COMPRESS_FLAG_DEFLATE)
+		{
+			return false;
+		}
+		if(view.limit && size > view.limit)
+		{
+			return false;
+		}
+		boost::shared_array<kg::byte_t> data;
+		if(!c.inflate(view.data,view.size,size,data))
+		{
+			return false;
+		}
+		view.owner = data;
+		view.data = data.get();
+		view.size = size;
+		view.headroom = 0;
+		return true;
+	}
+	virtual bool encode(view_t& view,std::size_t headroom)
+	{
+		compressor_t& c = compressor();
+		view_t out;
+		if(c.compressible(view.size))
+		{
+			//壓縮 輸出 空間 也 足夠 放下 未壓縮 的 消息體
+			out.reset(headroom,KG_NET_COMPRESS_HEADER + view.size);
+			out.size = c.compress(view.data,view.size,out.data);
+			if(out.size)
+			{
+				view = out;
+				return true;
+			}
+		}
+		//不壓縮 時 原地 加上 標記
+		if(view.writable(1 + headroom))
+		{
+			--view.data;
+			++view.size;
+			--view.headroom;
+			view.data[0] = KG_NET_COMPRESS_FLAG_RAW;
+			return true;
+		}
+		if(!out.owner)
+		{
+			out.reset(headroom,1 + view.size);
+		}
+		out.data[0] = KG_NET_COMPRESS_FLAG_RAW;
+		std::memcpy(out.data + 1,view.data,view.size);
+		out.size = 1 + view.size;
+		view = out;
+		return true;
+	}
+};
+};
+};
+#endif	//KG_NET_STAGE_HEADER_HPP
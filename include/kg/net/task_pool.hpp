@@ -0,0 +1,262 @@
+#ifndef KG_NET_TASK_POOL_HEADER_HPP
+#define KG_NET_TASK_POOL_HEADER_HPP
+
+#include <vector>
+#include <exception>
+
+#include <boost/asio/spawn.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/type_traits/is_void.hpp>
+
+#include "types.hpp"
+
+namespace kg
+{
+namespace net
+{
+#define KG_NET_TASK_POOL_CODE_BUSY	1
+#define KG_NET_TASK_POOL_CODE_STOPPED	2
+/**
+*	\brief task_pool_t 異常定義
+*
+*/
+class task_pool_category :
+    public boost::system::error_category
+{
+public:
+    virtual const char *name() const BOOST_SYSTEM_NOEXCEPT
+    {
+        return "kg::net::task_pool : ";
+    }
+    virtual std::string message(int ev) const
+    {
+    	std::string msg("kg::net::task_pool : ");
+        switch(ev)
+        {
+        case 0:
+            return msg + "success";
+		case KG_NET_TASK_POOL_CODE_BUSY:
+            return msg + "too many pending tasks";
+		case KG_NET_TASK_POOL_CODE_STOPPED:
+            return msg + "pool stopped";
+        }
+        return msg + "unknow";
+    }
+    static task_pool_category& get()
+    {
+    	static task_pool_category instance;
+    	return instance;
+    }
+};
+
+/**
+*	\brief 執行 阻塞任務的 有界 線程池
+*
+*	協程 調用 call 將 阻塞函數 投遞到 線程池 並掛起 函數 完成後 協程 在其 原本的 io_service 上 恢復\n
+*	如此 一個 慢操作 不會 凍結 整個 響應服務器 上的 其它連接
+*
+*	\code
+std::string data = pool.call([&]{
+	return read_file(path);
+},ctx);
+	*	\endcode
+*/
+class task_pool_t
+	: boost::noncopyable
+{
+public:
+	/**
+	*	\brief type_t type_spt
+	*
+	*/
+	KG_TYPEDEF_TT(task_pool_t);
+private:
+	io_service_t _service;
+	//保護 _work 投遞 任務 與 stop 互斥 stop 之後 不會 再有 任務 被 投遞
+	boost::mutex _mutex;
+	work_spt _work;
+	std::vector<thread_spt> _threads;
+
+	//最多 等待/執行中 的 任務數 0 不限制
+	std::size_t _max;
+	boost::atomic<std::size_t> _pending;
+
+	template<typename R>
+	class state_t
+	{
+	public:
+		boost::optional<R> value;
+		std::exception_ptr exception;
+		template<typename Func>
+		void run(Func& func)
+		{
+			try
+			{
+				value = func();
+			}
+			catch(...)
+			{
+				exception = std::current_exception();
+			}
+		}
+		R get()
+		{
+			if(exception)
+			{
+				std::rethrow_exception(exception);
+			}
+			return *value;
+		}
+	};
+
+	template<typename Func,typename Handler,typename State>
+	class task_t
+	{
+	public:
+		typedef typename boost::asio::associated_executor<Handler>::type executor_t;
+		task_pool_t* pool;
+		Func func;
+		Handler handler;
+		boost::shared_ptr<State> state;
+		//任務 執行 期間 協程 所屬的 io_service 不會 因爲 沒有 任務 而 返回
+		boost::asio::executor_work_guard<executor_t> work;
+		task_t(task_pool_t* pool,Func func,Handler handler,boost::shared_ptr<State> state)
+			:pool(pool),func(func),handler(handler),state(state),work(boost::asio::get_associated_executor(handler))
+		{
+		}
+		void operator()()
+		{
+			state->run(func);
+			--pool->_pending;
+
+			//回到 協程 所屬的 io_service 恢復
+			boost::asio::post(work.get_executor(),
+				boost::bind<void>(handler,boost::system::error_code())
+			);
+		}
+	};
+public:
+	/**
+	*	\brief 創建 線程池
+	*
+	*	\exception boost::system::system_error
+	*	\param threads	線程數 爲0 使用 cpu 數
+	*	\param max	最多 等待/執行中 的 任務數 爲0 不限制
+	*/
+	task_pool_t(std::size_t threads,std::size_t max)
+		:_max(max),_pending(0)
+	{
+		if(!threads)
+		{
+			threads = boost::thread::hardware_concurrency();
+		}
+		_work = boost::make_shared<work_t>(_service);
+		for(std::size_t i=0; i<threads; ++i)
+		{
+			_threads.push_back(boost::make_shared<thread_t>(boost::bind(&io_service_t::run,&_service)));
+		}
+	}
+	~task_pool_t()
+	{
+		stop();
+	}
+	/**
+	*	\brief 等待 已投遞的 任務 完成 並 停止 線程池
+	*
+	*/
+	void stop()
+	{
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			_work.reset();
+		}
+		BOOST_FOREACH(thread_spt& thread,_threads)
+		{
+			thread->join();
+		}
+		_threads.clear();
+	}
+	/**
+	*	\brief 返回 等待/執行中 的 任務數
+	*
+	*/
+	inline std::size_t pending()const
+	{
+		return _pending;
+	}
+	/**
+	*	\brief 在 線程池中 執行 func 並 掛起 協程 直到 完成
+	*
+	*	func 拋出的 異常 會在 協程中 重新 拋出
+	*
+	*	\exception boost::system::system_error 任務數 已達 上限 或 線程池 已停止
+	*	\return func 的 返回值
+	*/
+	template<typename Func>
+	auto call(Func func,boost::asio::yield_context ctx) -> decltype(func())
+	{
+		typedef decltype(func()) result_t;
+		typedef state_t<typename boost::mpl::if_c<boost::is_void<result_t>::value,bool,result_t>::type> state_type;
+
+		typedef void signature_t(boost::system::error_code);
+		boost::asio::async_completion<boost::asio::yield_context,signature_t> completion(ctx);
+		typedef typename boost::asio::async_completion<boost::asio::yield_context,signature_t>::completion_handler_type handler_t;
+
+		boost::shared_ptr<state_type> state = boost::make_shared<state_type>();
+		void_adapter_t<Func,result_t> adapter(func);
+		{
+			//stop 之後 線程 已 退出 投遞的 任務 永遠 不會 執行
+			boost::mutex::scoped_lock lock(_mutex);
+			if(!_work)
+			{
+				BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_TASK_POOL_CODE_STOPPED,task_pool_category::get()));
+			}
+			if(++_pending > _max && _max)
+			{
+				--_pending;
+				BOOST_THROW_EXCEPTION(boost::system::system_error(KG_NET_TASK_POOL_CODE_BUSY,task_pool_category::get()));
+			}
+			boost::asio::post(_service,task_t<void_adapter_t<Func,result_t>,handler_t,state_type>(this,adapter,completion.completion_handler,state));
+		}
+		completion.result.get();
+
+		return static_cast<result_t>(state->get());
+	}
+private:
+	//將 返回 void 的 函數 適配爲 返回 bool
+	template<typename Func,typename R>
+	class void_adapter_t
+	{
+	public:
+		Func func;
+		explicit void_adapter_t(Func func):func(func)
+		{
+		}
+		inline R operator()()
+		{
+			return func();
+		}
+	};
+	template<typename Func>
+	class void_adapter_t<Func,void>
+	{
+	public:
+		Func func;
+		explicit void_adapter_t(Func func):func(func)
+		{
+		}
+		inline bool operator()()
+		{
+			func();
+			return true;
+		}
+	};
+};
+};
+};
+#endif	//KG_NET_TASK_POOL_HEADER_HPP
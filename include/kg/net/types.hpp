@@ -1,6 +1,29 @@
 #ifndef KG_NET_TYPES_HEADER_HPP
 #define KG_NET_TYPES_HEADER_HPP
 
+/**
+*	\brief 定義 KG_NET_IO_URING 後 以 io_uring 替代 epoll 作爲 boost::asio 的 後端
+*
+*	boost::asio 只能在 編譯期 選擇 後端 且 需要 boost 1.78 以上 鏈接時 需要 -luring\n
+*	必須 在 任何 boost::asio 頭文件 之前 包含 此文件 否則 同一 程序 中 會 混用 兩種 後端\n
+*	註冊 緩衝區 與 multishot accept/recv 未被 boost::asio 公開 回調 與 epoll 後端 完全 相同
+*/
+#ifdef KG_NET_IO_URING
+#include <boost/version.hpp>
+#if BOOST_VERSION < 107800
+#error "KG_NET_IO_URING requires boost 1.78 or later"
+#endif // BOOST_VERSION
+#ifdef BOOST_ASIO_DETAIL_CONFIG_HPP
+#error "KG_NET_IO_URING must be defined before any boost::asio header is included"
+#endif // BOOST_ASIO_DETAIL_CONFIG_HPP
+#ifndef BOOST_ASIO_HAS_IO_URING
+#define BOOST_ASIO_HAS_IO_URING
+#endif // BOOST_ASIO_HAS_IO_URING
+#ifndef BOOST_ASIO_DISABLE_EPOLL
+#define BOOST_ASIO_DISABLE_EPOLL
+#endif // BOOST_ASIO_DISABLE_EPOLL
+#endif // KG_NET_IO_URING
+
 #include <boost/asio.hpp>
 #include <boost/smart_ptr.hpp>
 #include <boost/thread.hpp>
@@ -24,10 +47,15 @@ namespace net
 	typedef boost::shared_ptr<socket_t> socket_spt;
 	typedef boost::shared_ptr<endpoint_t> endpoint_spt;
 
+	typedef boost::asio::ip::udp::socket udp_socket_t;
+	typedef boost::asio::ip::udp::endpoint udp_endpoint_t;
+	typedef boost::shared_ptr<udp_socket_t> udp_socket_spt;
+
 	typedef boost::thread thread_t;
 	typedef boost::shared_ptr<thread_t> thread_spt;
 
 	typedef boost::asio::deadline_timer deadline_timer_t;
+	typedef boost::asio::strand<io_service_t::executor_type> strand_t;
 };
 };
 #endif	//KG_NET_TYPES_HEADER_HPP
@@ -126,6 +126,25 @@ TEST(TypeBuffer, HandleNoneZeroInput)
 		n = buf.copy_to(pos,(std::uint8_t*)b,size);
 		EXPECT_EQ(std::string(b,n),str.substr(pos));
     }
+
+    {
+        kg::bytes::buffer_t<> buf(8);
+		std::string str = "0123456789abcdefghijklmnopqrstwxz";
+		//分多次 寫入 產生 多個 分片
+		for(std::size_t i=0;i<str.size();i+=5)
+		{
+			std::size_t n = std::min<std::size_t>(5,str.size() - i);
+			EXPECT_EQ(buf.write((std::uint8_t*)str.data() + i,n),n);
+		}
+
+		//跳過 跨越 分片
+		char b[64];
+		for(std::size_t pos=0;pos<=str.size();++pos)
+		{
+			std::size_t n = buf.copy_to(pos,(std::uint8_t*)b,sizeof(b));
+			EXPECT_EQ(std::string(b,n),str.substr(pos));
+		}
+    }
 }
 
 int main(int argc, char* argv[])
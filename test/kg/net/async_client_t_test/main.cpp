@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <boost/thread.hpp>
+#include <kg/net/async_client.hpp>
+#include <kg/net/echo_server.hpp>
+#define ADDRESS "127.0.0.1:1132"
+#define PORT 1132
+typedef int session_t;
+typedef kg::net::echo_server_t<session_t> echo_server_t;
+
+//在 獨立 線程 上 同步 接受 一個 連接 的 回環 服務器
+class loopback_t
+{
+public:
+	kg::net::io_service_t service;
+	kg::net::acceptor_t acceptor;
+	kg::net::socket_t socket;
+	boost::thread thread;
+	loopback_t()
+		:acceptor(service,kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT)),socket(service)
+	{
+	}
+	template<typename F>
+	void run(F f)
+	{
+		thread = boost::thread([this,f]()
+		{
+			acceptor.accept(socket);
+			f(socket);
+		});
+	}
+	~loopback_t()
+	{
+		thread.join();
+	}
+};
+std::string to_string(const kg::net::async_client_t::bytes_t& b)
+{
+	return std::string((const char*)b.get(),b.size());
+}
+void sleep(kg::net::io_service_t& service,const boost::asio::yield_context& ctx,std::size_t ms)
+{
+	kg::net::deadline_timer_t timer(service);
+	timer.expires_from_now(boost::posix_time::milliseconds(ms));
+	boost::system::error_code ec;
+	timer.async_wait(ctx[ec]);
+}
+
+TEST(TypeAsyncClient, HandleFraming)
+{
+	std::string written;
+	loopback_t server;
+	server.run([&](kg::net::socket_t& s)
+	{
+		//write 與 send 的 幀
+		written.resize(9 + 10);
+		boost::asio::read(s,boost::asio::buffer(&written[0],written.size()));
+
+		//兩幀 一次 寫入 第三幀 分 兩次 寫入
+		std::string frames("\x00\x00\x00\x03" "abc" "\x00\x00\x00\x02" "xy" "\x00\x00",4 + 3 + 4 + 2 + 2);
+		boost::asio::write(s,boost::asio::buffer(frames));
+		boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+		boost::asio::write(s,boost::asio::buffer(std::string("\x00\x01" "z",3)));
+	});
+
+	std::vector<std::string> readed;
+	kg::net::io_service_t service;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		kg::net::async_client_t c(service);
+		c.connect(ADDRESS,ctx);
+		c.write((const kg::byte_t*)"hello",5,ctx);
+		EXPECT_TRUE(c.send((const kg::byte_t*)"id",2,(const kg::byte_t*)"body",4));
+		for(int i=0;i<3;++i)
+		{
+			readed.push_back(to_string(c.read(ctx)));
+		}
+		EXPECT_TRUE(c.healthy());
+	});
+	service.run();
+
+	EXPECT_EQ(written,std::string("\x00\x00\x00\x05" "hello" "\x00\x00\x00\x06" "idbody",19));
+	ASSERT_EQ(readed.size(),3);
+	EXPECT_EQ(readed[0],"abc");
+	EXPECT_EQ(readed[1],"xy");
+	EXPECT_EQ(readed[2],"z");
+}
+TEST(TypeAsyncClient, HandleStages)
+{
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::length(4));
+	s.encryption(3);
+	s.compression(32);
+	echo_server_t* ps = &s;
+	s.readed([ps](const kg::net::connection_spt& c,session_t&,kg::byte_t* b,std::size_t n,const boost::asio::yield_context&){
+		return ps->send(c,b,n);
+	});
+	s.run();
+
+	std::vector<std::string> requests;
+	requests.push_back("small");
+	requests.push_back(std::string(10000,'a'));
+	std::string random(3000,0);
+	for(std::size_t i=0;i<random.size();++i)
+	{
+		random[i] = char(i * 7919 % 251);
+	}
+	requests.push_back(random);
+
+	std::vector<std::string> responses;
+	kg::net::io_service_t service;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		kg::net::async_client_t c(service);
+		c.stage(boost::make_shared<kg::net::crypto_stage_t>(3));
+		c.stage(boost::make_shared<kg::net::compress_stage_t>(32));
+		c.connect(ADDRESS,ctx);
+		for(std::size_t i=0;i<requests.size();++i)
+		{
+			responses.push_back(to_string(c.request((const kg::byte_t*)requests[i].data(),requests[i].size(),ctx)));
+		}
+		//經 發送隊列 寫出
+		EXPECT_TRUE(c.send((const kg::byte_t*)"q:",2,(const kg::byte_t*)random.data(),random.size()));
+		responses.push_back(to_string(c.read(ctx)));
+	});
+	service.run();
+	s.stop();
+
+	ASSERT_EQ(responses.size(),4);
+	for(std::size_t i=0;i<requests.size();++i)
+	{
+		EXPECT_EQ(responses[i],requests[i]);
+	}
+	EXPECT_EQ(responses[3],"q:" + random);
+}
+TEST(TypeAsyncClient, HandleHealthy)
+{
+	boost::mutex mutex;
+	boost::condition_variable cv;
+	int step = 0;
+	loopback_t server;
+	server.run([&](kg::net::socket_t& s)
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		while(step != 1)
+		{
+			cv.wait(lock);
+		}
+		//未請求的 數據
+		boost::asio::write(s,boost::asio::buffer("x",1));
+	});
+
+	bool fresh = false;
+	bool unsolicited = true;
+	kg::net::io_service_t service;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		kg::net::async_client_t c(service);
+		c.connect(ADDRESS,ctx);
+		fresh = c.healthy();
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			step = 1;
+			cv.notify_all();
+		}
+		sleep(service,ctx,100);
+		unsolicited = c.healthy();
+	});
+	service.run();
+	EXPECT_TRUE(fresh);
+	EXPECT_FALSE(unsolicited);
+}
+TEST(TypeAsyncClient, HandlePeerClosed)
+{
+	loopback_t server;
+	server.run([&](kg::net::socket_t& s)
+	{
+		boost::system::error_code ec;
+		s.close(ec);
+	});
+
+	bool closed = true;
+	bool local = true;
+	boost::system::error_code ec;
+	kg::net::io_service_t service;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		kg::net::async_client_t c(service);
+		c.connect(ADDRESS,ctx);
+		sleep(service,ctx,100);
+		closed = c.healthy();
+		c.read(ctx,ec);
+
+		kg::net::async_client_t other(service);
+		boost::system::error_code err;
+		other.close(err);
+		local = other.healthy();
+	});
+	service.run();
+	EXPECT_FALSE(closed);
+	EXPECT_TRUE(ec);
+	EXPECT_FALSE(local);
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <kg/net/basic_server.hpp>
+#define ADDRESS "127.0.0.1:1142"
+#define PORT 1142
+typedef int session_t;
+typedef kg::net::basic_server_t<session_t> server_t;
+typedef boost::shared_ptr<kg::net::socket_t> client_spt;
+
+kg::net::endpoint_t endpoint()
+{
+	return kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT);
+}
+//回覆 收到的 數據
+void echo(server_t& s)
+{
+	s.readed([](const kg::net::connection_spt& c,session_t&,kg::byte_t* b,std::size_t n,const boost::asio::yield_context&){
+		return c->send(b,n);
+	});
+}
+//從 local 地址 連接 服務器
+client_spt connect(kg::net::io_service_t& service,const char* local = "127.0.0.1")
+{
+	client_spt c = boost::make_shared<kg::net::socket_t>(service);
+	c->open(boost::asio::ip::tcp::v4());
+	c->bind(kg::net::endpoint_t(boost::asio::ip::address::from_string(local),0));
+	c->connect(endpoint());
+	return c;
+}
+//連接 被 接受 返回 true 被 拒絕 (服務器 立刻 關閉) 返回 false
+bool accepted(kg::net::socket_t& c)
+{
+	boost::system::error_code ec;
+	boost::asio::write(c,boost::asio::buffer("ok",2),ec);
+	if(ec)
+	{
+		return false;
+	}
+	char b[2];
+	boost::asio::read(c,boost::asio::buffer(b,2),ec);
+	return !ec;
+}
+void wait_connections(server_t& s,std::size_t n)
+{
+	for(int i=0;i<300 && s.connections() != n;++i)
+	{
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	ASSERT_EQ(s.connections(),n);
+}
+//拒絕 計數 在 關閉 連接 之後 更新
+void wait_rejected(server_t& s,kg::uint64_t n)
+{
+	for(int i=0;i<300 && s.metrics().total.rejected != n;++i)
+	{
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	ASSERT_EQ(s.metrics().total.rejected,n);
+}
+TEST(TypeBasicServerAdmission, HandleMaxConnections)
+{
+	kg::net::basic_server_options_t options;
+	options.threads = 2;
+	options.max_connections = 2;
+	server_t s(ADDRESS,1,0,options);
+	echo(s);
+	s.run();
+
+	kg::net::io_service_t service;
+	client_spt c0 = connect(service);
+	client_spt c1 = connect(service);
+	EXPECT_TRUE(accepted(*c0));
+	EXPECT_TRUE(accepted(*c1));
+	client_spt c2 = connect(service);
+	EXPECT_FALSE(accepted(*c2));
+	wait_rejected(s,1);
+	EXPECT_EQ(s.connections(),2);
+
+	//連接 斷開 後 釋放 名額
+	c0->close();
+	wait_connections(s,1);
+	client_spt c3 = connect(service);
+	EXPECT_TRUE(accepted(*c3));
+	EXPECT_EQ(s.metrics().total.rejected,1);
+	s.stop();
+}
+TEST(TypeBasicServerAdmission, HandlePerIp)
+{
+	kg::net::basic_server_options_t options;
+	options.threads = 1;
+	options.max_connections_per_ip = 1;
+	server_t s(ADDRESS,1,0,options);
+	echo(s);
+	s.run();
+
+	kg::net::io_service_t service;
+	client_spt c0 = connect(service);
+	EXPECT_TRUE(accepted(*c0));
+	client_spt c1 = connect(service);
+	EXPECT_FALSE(accepted(*c1));
+	//其它 來源 ip 不受 影響
+	client_spt c2 = connect(service,"127.0.0.2");
+	EXPECT_TRUE(accepted(*c2));
+	wait_rejected(s,1);
+
+	c0->close();
+	wait_connections(s,1);
+	client_spt c3 = connect(service);
+	EXPECT_TRUE(accepted(*c3));
+	s.stop();
+}
+TEST(TypeBasicServerAdmission, HandleAcceptRate)
+{
+	kg::net::basic_server_options_t options;
+	options.threads = 1;
+	options.accept_rate = 4;
+	options.accept_burst = 2;
+	server_t s(ADDRESS,1,0,options);
+	boost::atomic<std::size_t> count(0);
+	s.connected([&](const kg::net::connection_spt&,session_t&,const boost::asio::yield_context&){
+		++count;
+		return true;
+	});
+	echo(s);
+	s.run();
+
+	//超出 令牌 的 連接 留在 listen 隊列 中 而不是 被 拒絕
+	kg::net::io_service_t service;
+	std::vector<client_spt> clients;
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+	for(int i=0;i<6;++i)
+	{
+		clients.push_back(connect(service));
+	}
+	boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+	EXPECT_EQ(count,2);
+
+	for(std::size_t i=0;i<clients.size();++i)
+	{
+		EXPECT_TRUE(accepted(*clients[i]));
+	}
+	//後 4個 連接 需要 等待 補充 令牌 約 1秒
+	EXPECT_GE(boost::posix_time::microsec_clock::universal_time() - start,boost::posix_time::milliseconds(800));
+	EXPECT_EQ(count,6);
+	EXPECT_EQ(s.metrics().total.rejected,0);
+	s.stop();
+}
+TEST(TypeBasicServerAdmission, HandleReadRate)
+{
+	const std::size_t rate = 64 * 1024;
+	const std::size_t size = rate * 3;
+	kg::net::basic_server_options_t options;
+	options.threads = 1;
+	options.read_rate = rate;
+	server_t s(ADDRESS,1,0,options);
+	boost::atomic<std::size_t> sum(0);
+	s.readed([&](const kg::net::connection_spt&,session_t&,kg::byte_t*,std::size_t n,const boost::asio::yield_context&){
+		sum += n;
+		return true;
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	client_spt c = connect(service);
+	std::vector<kg::byte_t> data(size);
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+	boost::asio::write(*c,boost::asio::buffer(data));
+	for(int i=0;i<1000 && sum != size;++i)
+	{
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	ASSERT_EQ(sum,size);
+	//令牌桶 初始 裝滿 其餘 2倍 rate 需要 約 2秒
+	boost::posix_time::time_duration used = boost::posix_time::microsec_clock::universal_time() - start;
+	EXPECT_GE(used,boost::posix_time::milliseconds(1500));
+	EXPECT_LT(used,boost::posix_time::seconds(5));
+	s.stop();
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
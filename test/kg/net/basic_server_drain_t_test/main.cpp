@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <boost/thread.hpp>
+#include <kg/net/basic_server.hpp>
+#define ADDRESS "127.0.0.1:1139"
+#define PORT 1139
+#define RESPONSE_SIZE (16 * 1024 * 1024)
+typedef int session_t;
+typedef kg::net::basic_server_t<session_t> server_t;
+
+kg::net::endpoint_t endpoint()
+{
+	return kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT);
+}
+kg::net::basic_server_options_t options()
+{
+	kg::net::basic_server_options_t options;
+	options.threads = 1;
+	options.write_high_watermark = RESPONSE_SIZE * 2;
+	return options;
+}
+//讀取 直到 對端 半關閉 返回 讀到的 字節數
+std::size_t read_all(kg::net::socket_t& c)
+{
+	std::size_t sum = 0;
+	kg::byte_t b[64 * 1024];
+	boost::system::error_code ec;
+	while(!ec)
+	{
+		sum += c.read_some(boost::asio::buffer(b,sizeof(b)),ec);
+	}
+	EXPECT_EQ(ec,boost::asio::error::eof);
+	return sum;
+}
+void wait_connections(server_t& s,std::size_t n)
+{
+	for(int i=0;i<300 && s.connections() != n;++i)
+	{
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	ASSERT_EQ(s.connections(),n);
+}
+TEST(TypeBasicServerDrain, HandleQueuedWrites)
+{
+	server_t s(ADDRESS,1,0,options());
+	boost::shared_array<kg::byte_t> response(new kg::byte_t[RESPONSE_SIZE]);
+	for(std::size_t i=0;i<RESPONSE_SIZE;++i)
+	{
+		response[i] = kg::byte_t(i);
+	}
+	s.readed([&](const kg::net::connection_spt& c,session_t&,kg::byte_t*,std::size_t,const boost::asio::yield_context&){
+		return c->send(response,RESPONSE_SIZE);
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	c.connect(endpoint());
+	boost::asio::write(c,boost::asio::buffer("go",2));
+	//不 讀取 響應 留在 發送隊列 中
+	for(int i=0;i<300 && s.metrics().total.reads != 1;++i)
+	{
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+	boost::thread thread(boost::bind(&server_t::shutdown,&s,boost::posix_time::seconds(10)));
+	boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+
+	//優雅關閉 期間 不 接受 新連接
+	kg::net::socket_t other(service);
+	boost::system::error_code ec;
+	other.connect(endpoint(),ec);
+	EXPECT_TRUE(ec);
+
+	//發送隊列 完整 寫出 之後 半關閉
+	EXPECT_EQ(read_all(c),RESPONSE_SIZE);
+	c.close();
+	thread.join();
+	EXPECT_LT(boost::posix_time::microsec_clock::universal_time() - start,boost::posix_time::seconds(5));
+}
+TEST(TypeBasicServerDrain, HandleIdle)
+{
+	server_t s(ADDRESS,1,0,options());
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	c.connect(endpoint());
+	wait_connections(s,1);
+
+	//空閒 連接 立刻 被 關閉
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+	boost::thread thread(boost::bind(&server_t::shutdown,&s,boost::posix_time::seconds(10)));
+	EXPECT_EQ(read_all(c),0);
+	c.close();
+	thread.join();
+	EXPECT_LT(boost::posix_time::microsec_clock::universal_time() - start,boost::posix_time::seconds(5));
+}
+TEST(TypeBasicServerDrain, HandleDeadline)
+{
+	server_t s(ADDRESS,1,0,options());
+	//回調 直到 連接 被 強制 關閉 才 返回
+	s.readed([&](const kg::net::connection_spt& c,session_t&,kg::byte_t*,std::size_t,const boost::asio::yield_context& ctx){
+		kg::net::deadline_timer_t timer(c->get_executor());
+		boost::system::error_code ec;
+		while(c->is_open())
+		{
+			timer.expires_from_now(boost::posix_time::milliseconds(10));
+			timer.async_wait(ctx[ec]);
+		}
+		return false;
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	c.connect(endpoint());
+	boost::asio::write(c,boost::asio::buffer("go",2));
+	for(int i=0;i<300 && s.metrics().total.reads != 1;++i)
+	{
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+
+	//回調 未 返回 deadline 到達 後 強制 關閉
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+	s.shutdown(boost::posix_time::milliseconds(300));
+	boost::posix_time::time_duration used = boost::posix_time::microsec_clock::universal_time() - start;
+	EXPECT_GE(used,boost::posix_time::milliseconds(290));
+	EXPECT_LT(used,boost::posix_time::seconds(5));
+	EXPECT_EQ(s.connections(),0);
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
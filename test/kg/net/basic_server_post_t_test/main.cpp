@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <boost/thread.hpp>
+#include <kg/net/basic_server.hpp>
+#define ADDRESS "127.0.0.1:1143"
+#define PORT 1143
+#define CLIENTS 4
+typedef kg::uint64_t session_t;
+typedef kg::net::basic_server_t<session_t> server_t;
+typedef boost::shared_ptr<kg::net::socket_t> client_spt;
+
+//記錄 連接 id 的 服務器 與 按 連接 順序 對應的 客戶端
+class fixture_t
+{
+public:
+	server_t server;
+	kg::net::io_service_t service;
+	std::vector<client_spt> clients;
+	std::vector<kg::uint64_t> ids;
+	boost::mutex mutex;
+	fixture_t()
+		:server(ADDRESS,1,0,options())
+	{
+		server.connected([this](const kg::net::connection_spt& c,session_t& session,const boost::asio::yield_context&){
+			session = c->id();
+			boost::mutex::scoped_lock lock(mutex);
+			ids.push_back(c->id());
+			return true;
+		});
+		server.readed([](const kg::net::connection_spt&,session_t&,kg::byte_t*,std::size_t,const boost::asio::yield_context&){
+			return true;
+		});
+	}
+	static kg::net::basic_server_options_t options()
+	{
+		kg::net::basic_server_options_t options;
+		options.threads = 2;
+		return options;
+	}
+	void connect()
+	{
+		server.run();
+		for(std::size_t i=0;i<CLIENTS;++i)
+		{
+			client_spt c = boost::make_shared<kg::net::socket_t>(service);
+			c->connect(kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT));
+			clients.push_back(c);
+			for(int j=0;j<300 && server.connections() != i+1;++j)
+			{
+				boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+			}
+			ASSERT_EQ(server.connections(),i+1);
+		}
+		//connections 在 connected 回調 之後 更新
+		ASSERT_EQ(ids.size(),CLIENTS);
+		//連接 分佈在 兩個 響應服務器 上
+		std::size_t second = 0;
+		for(std::size_t i=0;i<CLIENTS;++i)
+		{
+			if(ids[i] >> KG_NET_CONNECTION_ID_SHIFT)
+			{
+				++second;
+			}
+		}
+		EXPECT_GT(second,0);
+		EXPECT_LT(second,CLIENTS);
+	}
+};
+std::string read(kg::net::socket_t& c,std::size_t n)
+{
+	std::string rs(n,0);
+	boost::asio::read(c,boost::asio::buffer(&rs[0],n));
+	return rs;
+}
+const kg::byte_t* bytes(const char* str)
+{
+	return (const kg::byte_t*)str;
+}
+TEST(TypeBasicServerPost, HandleSend)
+{
+	fixture_t f;
+	f.connect();
+	server_t& s = f.server;
+
+	//未設置 posted 回調 時 直接 發送
+	EXPECT_TRUE(s.post_to(f.ids[2],bytes("kate"),4));
+	EXPECT_EQ(read(*f.clients[2],4),"kate");
+	EXPECT_TRUE(s.post_to(f.ids[1],bytes("anita"),5));
+	EXPECT_EQ(read(*f.clients[1],5),"anita");
+
+	EXPECT_TRUE(s.broadcast(bytes("all"),3));
+	//只 收到 投遞給 自己 的 消息
+	for(std::size_t i=0;i<CLIENTS;++i)
+	{
+		EXPECT_EQ(read(*f.clients[i],3),"all");
+	}
+
+	//已 關閉 的 連接 丟棄 消息
+	f.clients[0]->close();
+	for(int i=0;i<300 && s.connections() != CLIENTS-1;++i)
+	{
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	EXPECT_TRUE(s.post_to(f.ids[0],bytes("lost"),4));
+	EXPECT_TRUE(s.broadcast(bytes("end"),3));
+	for(std::size_t i=1;i<CLIENTS;++i)
+	{
+		EXPECT_EQ(read(*f.clients[i],3),"end");
+	}
+	s.stop();
+}
+TEST(TypeBasicServerPost, HandlePosted)
+{
+	fixture_t f;
+	boost::atomic<std::size_t> count(0);
+	f.server.posted([&](const kg::net::connection_spt& c,session_t& session,const boost::shared_array<kg::byte_t>& data,std::size_t n){
+		//在 連接 自己的 會話 上 調用
+		EXPECT_EQ(session,c->id());
+		++count;
+		std::string str = "[" + std::string((const char*)data.get(),n) + "]";
+		c->send((const kg::byte_t*)str.data(),str.size());
+	});
+	f.connect();
+	server_t& s = f.server;
+
+	EXPECT_TRUE(s.post_to(f.ids[3],bytes("king"),4));
+	EXPECT_EQ(read(*f.clients[3],6),"[king]");
+
+	boost::shared_array<kg::byte_t> data(new kg::byte_t[3]);
+	memcpy(data.get(),"all",3);
+	EXPECT_TRUE(s.broadcast(data,3));
+	for(std::size_t i=0;i<CLIENTS;++i)
+	{
+		EXPECT_EQ(read(*f.clients[i],5),"[all]");
+	}
+	EXPECT_EQ(count,CLIENTS+1);
+	s.stop();
+}
+TEST(TypeBasicServerPost, HandleInvalid)
+{
+	fixture_t f;
+	f.connect();
+	server_t& s = f.server;
+
+	//響應服務器 不存在
+	kg::uint64_t id = kg::uint64_t(2) << KG_NET_CONNECTION_ID_SHIFT;
+	EXPECT_FALSE(s.post_to(id,bytes("none"),4));
+	//響應服務器 存在 但 連接 不存在 時 丟棄
+	id = (f.ids[0] >> KG_NET_CONNECTION_ID_SHIFT) << KG_NET_CONNECTION_ID_SHIFT;
+	id |= 0xffffff;
+	EXPECT_TRUE(s.post_to(id,bytes("none"),4));
+
+	EXPECT_TRUE(s.post_to(f.ids[0],bytes("ok"),2));
+	EXPECT_EQ(read(*f.clients[0],2),"ok");
+	s.stop();
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
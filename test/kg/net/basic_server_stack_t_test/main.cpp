@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <boost/thread.hpp>
+#include <kg/net/basic_server.hpp>
+#define ADDRESS "127.0.0.1:1137"
+#define PORT 1137
+typedef int session_t;
+typedef kg::net::basic_server_t<session_t> server_t;
+
+//等待 服務器 接受 accepts 個 連接 並 全部 關閉
+bool wait_closed(server_t& s,kg::uint64_t accepts)
+{
+	for(int i=0;i<300;++i)
+	{
+		if(s.metrics().total.accepts == accepts && !s.connections())
+		{
+			return true;
+		}
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	return false;
+}
+kg::net::endpoint_t endpoint()
+{
+	return kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT);
+}
+//依次 建立 n 個 連接 每個 在 服務器 關閉 之後 才 建立 下一個
+void sequential(server_t& s,int n)
+{
+	kg::net::io_service_t service;
+	kg::uint64_t accepts = s.metrics().total.accepts;
+	for(int i=0;i<n;++i)
+	{
+		kg::net::socket_t c(service);
+		c.connect(endpoint());
+		c.close();
+		ASSERT_TRUE(wait_closed(s,++accepts));
+	}
+}
+kg::net::basic_server_options_t options(std::size_t pool)
+{
+	kg::net::basic_server_options_t options;
+	options.threads = 1;
+	options.stack_size = 64 * 1024;
+	options.stack_pool = pool;
+	return options;
+}
+TEST(TypeBasicServerStack, HandleReuse)
+{
+	server_t s(ADDRESS,1,0,options(2));
+	s.run();
+
+	//連接 斷開後 協程 掛起 下個 連接 由 它 處理
+	sequential(s,20);
+	kg::net::server_metrics_t metrics = s.metrics();
+	EXPECT_EQ(metrics.total.accepts,20);
+	EXPECT_EQ(metrics.total.coroutines,1);
+	s.stop();
+}
+TEST(TypeBasicServerStack, HandlePoolLimit)
+{
+	server_t s(ADDRESS,1,0,options(2));
+	s.run();
+
+	//同時 3 個 連接 需要 3 個 協程
+	{
+		kg::net::io_service_t service;
+		std::vector<kg::net::socket_spt> clients;
+		for(int i=0;i<3;++i)
+		{
+			kg::net::socket_spt c = boost::make_shared<kg::net::socket_t>(service);
+			c->connect(endpoint());
+			clients.push_back(c);
+		}
+		for(int i=0;i<300 && s.connections() != 3;++i)
+		{
+			boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+		}
+		ASSERT_EQ(s.connections(),3);
+	}
+	ASSERT_TRUE(wait_closed(s,3));
+	EXPECT_EQ(s.metrics().total.coroutines,3);
+
+	//最多 保留 2 個 空閒協程 之後的 連接 只 重用 它們
+	sequential(s,10);
+	EXPECT_EQ(s.metrics().total.coroutines,3);
+	s.stop();
+}
+TEST(TypeBasicServerStack, HandleNoPool)
+{
+	server_t s(ADDRESS,1,0,options(0));
+	s.run();
+
+	//不 保留 空閒協程 時 每個 連接 一個 新 協程
+	sequential(s,5);
+	EXPECT_EQ(s.metrics().total.coroutines,5);
+	s.stop();
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
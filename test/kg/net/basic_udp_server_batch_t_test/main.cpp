@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <set>
+#include <boost/thread.hpp>
+#include <kg/net/basic_udp_server.hpp>
+#define ADDRESS "127.0.0.1:1141"
+#define PORT 1141
+typedef int session_t;
+typedef kg::net::basic_udp_server_t<session_t> server_t;
+
+kg::net::udp_endpoint_t endpoint()
+{
+	return kg::net::udp_endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT);
+}
+kg::net::basic_udp_server_options_t options(std::size_t batch)
+{
+	kg::net::basic_udp_server_options_t options;
+	options.threads = 1;
+	options.batch = batch;
+	options.datagram_size = 64;
+	options.recv_buffer = 1024 * 1024;
+	return options;
+}
+//接收 n 個 數據報 超時 返回 已 收到的
+std::multiset<std::string> receive(kg::net::udp_socket_t& c,std::size_t n)
+{
+	std::multiset<std::string> rs;
+	kg::byte_t b[1024];
+	for(int i=0;i<300 && rs.size() < n;)
+	{
+		boost::system::error_code ec;
+		kg::net::udp_endpoint_t from;
+		std::size_t size = c.receive_from(boost::asio::buffer(b,sizeof(b)),from,0,ec);
+		if(ec == boost::asio::error::would_block)
+		{
+			boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+			++i;
+			continue;
+		}
+		EXPECT_FALSE(ec);
+		rs.insert(std::string((const char*)b,size));
+	}
+	return rs;
+}
+void open(kg::net::udp_socket_t& c)
+{
+	c.open(boost::asio::ip::udp::v4());
+	c.set_option(boost::asio::socket_base::receive_buffer_size(1024 * 1024));
+	c.bind(kg::net::udp_endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),0));
+	c.non_blocking(true);
+}
+TEST(TypeBasicUdpServerBatch, HandleBatch)
+{
+	server_t s(ADDRESS,0,options(64));
+	boost::mutex mutex;
+	std::size_t max = 0;
+	s.readed([&](kg::net::udp_sender_t& sender,const kg::net::udp_endpoint_t& peer,session_t& session,kg::byte_t* b,std::size_t n){
+		{
+			//同一批 的 回覆 在 本批 處理完 之前 不會 發出
+			boost::mutex::scoped_lock lock(mutex);
+			if(sender.pending() > max)
+			{
+				max = sender.pending();
+			}
+		}
+		++session;
+		return sender.send(peer,b,n);
+	});
+
+	//socket 已 綁定 run 之前 發送的 數據報 留在 內核 隊列 中
+	kg::net::io_service_t service;
+	kg::net::udp_socket_t c(service);
+	open(c);
+	std::multiset<std::string> expect;
+	for(int i=0;i<100;++i)
+	{
+		std::string str = boost::lexical_cast<std::string>(i);
+		c.send_to(boost::asio::buffer(str),endpoint());
+		expect.insert(str);
+	}
+	s.run();
+
+	EXPECT_EQ(receive(c,expect.size()),expect);
+	kg::net::server_metrics_t metrics = s.metrics();
+	EXPECT_EQ(metrics.total.reads,100);
+	EXPECT_EQ(metrics.total.accepts,1);
+	EXPECT_EQ(metrics.total.active,1);
+	EXPECT_EQ(metrics.total.bytes_in,metrics.total.bytes_out);
+	s.stop();
+
+	//一次 recvmmsg 讀取 整批 回覆 一次 sendmmsg 發出
+	boost::mutex::scoped_lock lock(mutex);
+	EXPECT_EQ(max,63);
+}
+TEST(TypeBasicUdpServerBatch, HandleSendFull)
+{
+	server_t s(ADDRESS,0,options(4));
+	//每個 數據報 回覆 3 個 超過 批量 時 在 回調 中 發出 不 掛起
+	s.readed([&](kg::net::udp_sender_t& sender,const kg::net::udp_endpoint_t& peer,session_t&,kg::byte_t* b,std::size_t n){
+		for(int i=0;i<3;++i)
+		{
+			std::string str = std::string((const char*)b,n) + "-" + boost::lexical_cast<std::string>(i);
+			if(!sender.send(peer,(const kg::byte_t*)str.data(),str.size()))
+			{
+				return false;
+			}
+		}
+		return true;
+	});
+
+	kg::net::io_service_t service;
+	kg::net::udp_socket_t c(service);
+	open(c);
+	std::multiset<std::string> expect;
+	for(int i=0;i<20;++i)
+	{
+		std::string str = boost::lexical_cast<std::string>(i);
+		c.send_to(boost::asio::buffer(str),endpoint());
+		for(int j=0;j<3;++j)
+		{
+			expect.insert(str + "-" + boost::lexical_cast<std::string>(j));
+		}
+	}
+	s.run();
+
+	EXPECT_EQ(receive(c,expect.size()),expect);
+	EXPECT_EQ(s.connections(),1);
+	s.stop();
+}
+TEST(TypeBasicUdpServerBatch, HandleOversize)
+{
+	server_t s(ADDRESS,0,options(8));
+	s.readed([&](kg::net::udp_sender_t& sender,const kg::net::udp_endpoint_t& peer,session_t&,kg::byte_t* b,std::size_t n){
+		//超過 max_size 的 回覆 被 拒絕
+		std::string big(sender.max_size() + 1,'x');
+		EXPECT_FALSE(sender.send(peer,(const kg::byte_t*)big.data(),big.size()));
+		return sender.send(peer,b,n);
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::udp_socket_t c(service);
+	open(c);
+	//超過 datagram_size 的 數據報 被 截斷 後 丟棄
+	std::string big(100,'x');
+	c.send_to(boost::asio::buffer(big),endpoint());
+	c.send_to(boost::asio::buffer("ok",2),endpoint());
+
+	std::multiset<std::string> expect;
+	expect.insert("ok");
+	EXPECT_EQ(receive(c,1),expect);
+	EXPECT_EQ(s.metrics().total.reads,1);
+	s.stop();
+}
+TEST(TypeBasicUdpServerBatch, HandleTimeout)
+{
+	server_t s(ADDRESS,1,options(8));
+	boost::mutex mutex;
+	int connected = 0;
+	int closed = 0;
+	s.connected([&](kg::net::udp_sender_t&,const kg::net::udp_endpoint_t&,session_t&){
+		boost::mutex::scoped_lock lock(mutex);
+		++connected;
+		return true;
+	});
+	s.closed([&](const kg::net::udp_endpoint_t&,session_t&){
+		boost::mutex::scoped_lock lock(mutex);
+		++closed;
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::udp_socket_t c(service);
+	open(c);
+	c.send_to(boost::asio::buffer("ok",2),endpoint());
+
+	//未活動 的 來源地址 在 一到兩個 週期 後 被 移除
+	for(int i=0;i<400 && s.metrics().total.timeouts != 1;++i)
+	{
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	EXPECT_EQ(s.connections(),0);
+	s.stop();
+	boost::mutex::scoped_lock lock(mutex);
+	EXPECT_EQ(connected,1);
+	EXPECT_EQ(closed,1);
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <kg/net/basic_udp_server.hpp>
+#define ADDRESS "127.0.0.1:1102"
+typedef int session_t;
+typedef kg::net::basic_udp_server_t<session_t> server_t;
+void input(server_t& s);
+
+int main(int argc, char* argv[])
+{
+	int rs = 0;
+	try
+    {
+    	//創建 服務
+        server_t s(ADDRESS,60);
+
+
+        //設置 回調
+        s.connected([](kg::net::udp_sender_t& sender,const kg::net::udp_endpoint_t& peer,session_t& session){
+				//std::cout<<"one in "<<peer<<std::endl;
+				return true;
+		});
+		s.closed([](const kg::net::udp_endpoint_t& peer,session_t& session){
+				//std::cout<<"one out "<<peer<<" "<<session<<std::endl;
+		});
+		s.readed([](kg::net::udp_sender_t& sender,const kg::net::udp_endpoint_t& peer,session_t& session,kg::byte_t* b,std::size_t n){
+				++session;
+				sender.send(peer,b,n);
+				return true;
+		});
+
+		//運行 服務
+		s.run();
+
+		input(s);
+
+		s.stop();
+		s.join();
+    }
+    catch(const boost::system::system_error& e)
+    {
+		std::cout<< boost::diagnostic_information(e)<<std::endl;
+		rs = 1;
+    }
+    return rs;
+}
+void input(server_t& s)
+{
+	std::string cmd;
+	while(true)
+	{
+		std::cout<<"\n$>";
+		std::cin>>cmd;
+
+		if(cmd == "e")
+		{
+			break;
+		}
+		else if(cmd == "m")
+		{
+			kg::net::server_metrics_t m = s.metrics();
+			std::cout<<"peers "<<m.total.active<<" datagrams "<<m.total.reads<<" in "<<m.total.bytes_in<<" out "<<m.total.bytes_out<<std::endl;
+		}
+	}
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <boost/thread.hpp>
+#include <kg/net/basic_server.hpp>
+#define ADDRESS "127.0.0.1:1136"
+#define PORT 1136
+typedef int session_t;
+typedef kg::net::basic_server_t<session_t> server_t;
+
+TEST(TypeBufferPool, HandleFit)
+{
+	kg::net::buffer_pool_t pool(100,1000,2);
+	//分級 爲 2的冪 限制在 [min,max]
+	EXPECT_EQ(pool.min_size(),128);
+	EXPECT_EQ(pool.max_size(),1024);
+	EXPECT_EQ(pool.fit(1),128);
+	EXPECT_EQ(pool.fit(129),256);
+	EXPECT_EQ(pool.fit(512),512);
+	EXPECT_EQ(pool.fit(100000),1024);
+}
+TEST(TypeBufferPool, HandleReuse)
+{
+	kg::net::buffer_pool_t pool(128,1024,2);
+	kg::byte_t* a = pool.get(256);
+	kg::byte_t* b = pool.get(256);
+	kg::byte_t* c = pool.get(256);
+	pool.put(a,256);
+	pool.put(b,256);
+	//超過 緩存 數量 的 直接 釋放
+	pool.put(c,256);
+
+	//同級 緩衝區 被 重用 不同級 不會
+	kg::byte_t* d = pool.get(256);
+	EXPECT_TRUE(d == a || d == b);
+	kg::byte_t* e = pool.get(512);
+	EXPECT_NE(e,a);
+	EXPECT_NE(e,b);
+	pool.put(d,256);
+	pool.put(e,512);
+}
+TEST(TypeAdaptiveBuffer, HandleAdapt)
+{
+	kg::net::buffer_pool_t pool(128,1024,4);
+	kg::net::adaptive_buffer_t buffer(pool,128);
+	EXPECT_EQ(buffer.size(),128);
+	kg::byte_t* first = buffer.get();
+
+	//讀滿 時 加倍 直到 max
+	std::size_t expect[] = {256,512,1024,1024};
+	for(std::size_t i=0; i<sizeof(expect)/sizeof(expect[0]); ++i)
+	{
+		buffer.get();
+		buffer.adapt(buffer.size());
+		EXPECT_EQ(buffer.size(),expect[i]);
+	}
+
+	//不足 四分之一 時 減半 直到 min
+	buffer.get();
+	buffer.adapt(buffer.size() / 4);
+	EXPECT_EQ(buffer.size(),1024);
+	std::size_t shrink[] = {512,256,128,128};
+	for(std::size_t i=0; i<sizeof(shrink)/sizeof(shrink[0]); ++i)
+	{
+		buffer.get();
+		buffer.adapt(buffer.size() / 4 - 1);
+		EXPECT_EQ(buffer.size(),shrink[i]);
+	}
+
+	//改變 大小 時 歸還的 緩衝區 被 重新 使用
+	EXPECT_EQ(buffer.get(),first);
+}
+TEST(TypeAdaptiveBuffer, HandleRelease)
+{
+	kg::net::buffer_pool_t pool(128,1024,4);
+	kg::byte_t* b;
+	{
+		kg::net::adaptive_buffer_t buffer(pool,128);
+		b = buffer.get();
+		buffer.release();
+		//歸還 後 重新 取得
+		EXPECT_EQ(buffer.get(),b);
+	}
+	//析構時 歸還
+	kg::byte_t* c = pool.get(128);
+	EXPECT_EQ(c,b);
+	pool.put(c,128);
+}
+TEST(TypeAdaptiveBuffer, HandleServerGrow)
+{
+	boost::mutex mutex;
+	std::size_t max = 0;
+	std::size_t total = 0;
+
+	kg::net::basic_server_options_t options;
+	options.read_buffer_min = 64;
+	options.read_buffer_max = 4096;
+	options.threads = 1;
+	server_t s(ADDRESS,1,0,options);
+	s.readed([&](const kg::net::connection_spt&,session_t&,kg::byte_t*,std::size_t n,const boost::asio::yield_context&){
+		boost::mutex::scoped_lock lock(mutex);
+		if(n > max)
+		{
+			max = n;
+		}
+		total += n;
+		return true;
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	c.connect(kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT));
+	std::string data(64 * 1024,'k');
+	boost::asio::write(c,boost::asio::buffer(data));
+	for(int i=0;i<200;++i)
+	{
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			if(total == data.size())
+			{
+				break;
+			}
+		}
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	s.stop();
+
+	//連續 讀滿 緩衝區 讀取量 增長 但 不超過 max
+	boost::mutex::scoped_lock lock(mutex);
+	EXPECT_EQ(total,data.size());
+	EXPECT_GT(max,options.read_buffer_min);
+	EXPECT_LE(max,options.read_buffer_max);
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
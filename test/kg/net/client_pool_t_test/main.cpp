@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <boost/thread.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <kg/net/client_pool.hpp>
+#include <kg/net/echo_server.hpp>
+#define ADDRESS "127.0.0.1:1133"
+typedef int session_t;
+typedef kg::net::echo_server_t<session_t> echo_server_t;
+
+//原樣 返回 消息體 的 長度前綴 服務器 (沒有 stage 時 回調 收到 包含 幀頭 的 整幀)
+class server_t
+{
+public:
+	boost::scoped_ptr<echo_server_t> s;
+	server_t()
+	{
+		start();
+	}
+	~server_t()
+	{
+		stop();
+	}
+	void start()
+	{
+		s.reset(new echo_server_t(ADDRESS,1,0,0));
+		s->framer(kg::net::framer_t::length(4));
+		echo_server_t* ps = s.get();
+		s->readed([ps](const kg::net::connection_spt& c,session_t&,kg::byte_t* b,std::size_t n,const boost::asio::yield_context&){
+			return ps->send(c,b,n);
+		});
+		s->run();
+	}
+	void stop()
+	{
+		if(s)
+		{
+			s->stop();
+			s.reset();
+		}
+	}
+};
+std::string to_string(const kg::net::async_client_t::bytes_t& b)
+{
+	return std::string((const char*)b.get(),b.size());
+}
+void sleep(kg::net::io_service_t& service,const boost::asio::yield_context& ctx,std::size_t ms)
+{
+	kg::net::deadline_timer_t timer(service);
+	timer.expires_from_now(boost::posix_time::milliseconds(ms));
+	boost::system::error_code ec;
+	timer.async_wait(ctx[ec]);
+}
+
+TEST(TypeClientPool, HandleFifoHandoff)
+{
+	server_t server;
+	kg::net::io_service_t service;
+	kg::net::client_pool_t pool(service,1);
+	std::vector<int> order;
+	std::size_t peak = 0;
+
+	//持有 唯一 名額 時 其它 協程 依次 排隊
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		kg::net::client_pool_t::lease_t c = pool.acquire(ADDRESS,ctx);
+		order.push_back(0);
+		sleep(service,ctx,100);
+	});
+	for(int i=1;i<=3;++i)
+	{
+		boost::asio::spawn(service,[&,i](boost::asio::yield_context ctx)
+		{
+			sleep(service,ctx,10 * i);
+			kg::net::client_pool_t::lease_t c = pool.acquire(ADDRESS,ctx);
+			std::size_t inflight,idle;
+			pool.count(ADDRESS,inflight,idle);
+			peak = std::max(peak,inflight);
+			order.push_back(i);
+			std::string str(i,'a');
+			EXPECT_EQ(to_string(c->request((const kg::byte_t*)str.data(),str.size(),ctx)),str);
+		});
+	}
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		//等待 所有 協程 完成 後 停止 清理 定時器
+		while(order.size() != 4)
+		{
+			sleep(service,ctx,10);
+		}
+		sleep(service,ctx,10);
+		pool.stop();
+	});
+	service.run();
+
+	ASSERT_EQ(order.size(),4);
+	for(int i=0;i<4;++i)
+	{
+		EXPECT_EQ(order[i],i);
+	}
+	EXPECT_EQ(peak,1);
+}
+TEST(TypeClientPool, HandleReuseIdle)
+{
+	server_t server;
+	kg::net::io_service_t service;
+	kg::net::client_pool_t pool(service);
+	kg::net::async_client_spt first;
+	kg::net::async_client_spt second;
+	std::size_t inflight = 0;
+	std::size_t idle = 0;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		{
+			kg::net::client_pool_t::lease_t c = pool.acquire(ADDRESS,ctx);
+			EXPECT_EQ(to_string(c->request((const kg::byte_t*)"abc",3,ctx)),"abc");
+			first = c.get();
+		}
+		pool.count(ADDRESS,inflight,idle);
+		EXPECT_EQ(inflight,0);
+		EXPECT_EQ(idle,1);
+		{
+			kg::net::client_pool_t::lease_t c = pool.acquire(ADDRESS,ctx);
+			EXPECT_EQ(to_string(c->request((const kg::byte_t*)"xy",2,ctx)),"xy");
+			second = c.get();
+		}
+		pool.stop();
+	});
+	service.run();
+	EXPECT_EQ(first,second);
+}
+TEST(TypeClientPool, HandleDiscardUnhealthy)
+{
+	server_t server;
+	kg::net::io_service_t service;
+	kg::net::client_pool_t pool(service);
+	kg::net::async_client_spt first;
+	kg::net::async_client_spt second;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		{
+			kg::net::client_pool_t::lease_t c = pool.acquire(ADDRESS,ctx);
+			EXPECT_EQ(to_string(c->request((const kg::byte_t*)"abc",3,ctx)),"abc");
+			first = c.get();
+		}
+		//服務器 重啓 空閒 連接 被 對端 關閉
+		server.stop();
+		server.start();
+		sleep(service,ctx,50);
+		{
+			kg::net::client_pool_t::lease_t c = pool.acquire(ADDRESS,ctx);
+			EXPECT_EQ(to_string(c->request((const kg::byte_t*)"xy",2,ctx)),"xy");
+			second = c.get();
+		}
+		std::size_t inflight,idle;
+		pool.count(ADDRESS,inflight,idle);
+		EXPECT_EQ(inflight,0);
+		EXPECT_EQ(idle,1);
+		pool.stop();
+	});
+	service.run();
+	ASSERT_TRUE(first);
+	EXPECT_NE(first,second);
+	EXPECT_FALSE(first->healthy());
+}
+TEST(TypeClientPool, HandleStopWakesWaiters)
+{
+	server_t server;
+	kg::net::io_service_t service;
+	kg::net::client_pool_t pool(service,1);
+	int stopped = 0;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		kg::net::client_pool_t::lease_t c = pool.acquire(ADDRESS,ctx);
+		sleep(service,ctx,50);
+		pool.stop();
+	});
+	for(int i=0;i<2;++i)
+	{
+		boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+		{
+			sleep(service,ctx,10);
+			boost::system::error_code ec;
+			pool.acquire(ADDRESS,ctx,ec);
+			if(ec == boost::system::error_code(KG_NET_ASYNC_CLIENT_CODE_POOL_STOPPED,kg::net::async_client_category::get()))
+			{
+				++stopped;
+			}
+		});
+	}
+	service.run();
+	EXPECT_EQ(stopped,2);
+
+	std::size_t inflight,idle;
+	pool.count(ADDRESS,inflight,idle);
+	EXPECT_EQ(inflight,0);
+	EXPECT_EQ(idle,0);
+}
+TEST(TypeClientPool, HandleSweepIdle)
+{
+	server_t server;
+	kg::net::io_service_t service;
+	kg::net::client_pool_t pool(service,8,8,1);
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		kg::net::client_pool_t::lease_t c = pool.acquire(ADDRESS,ctx);
+		EXPECT_EQ(to_string(c->request((const kg::byte_t*)"abc",3,ctx)),"abc");
+	});
+	//清理 定時器 關閉 過期的 空閒 連接 後 run 返回
+	boost::posix_time::ptime begin = boost::posix_time::microsec_clock::universal_time();
+	service.run();
+	boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - begin;
+
+	std::size_t inflight,idle;
+	pool.count(ADDRESS,inflight,idle);
+	EXPECT_EQ(inflight,0);
+	EXPECT_EQ(idle,0);
+	EXPECT_GE(elapsed.total_milliseconds(),900);
+	EXPECT_LT(elapsed.total_milliseconds(),3000);
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <kg/net/compressor.hpp>
+
+//按 標記 解碼 消息體
+bool decompress(kg::net::compressor_t& c,const kg::byte_t* b,std::size_t n,std::string& out)
+{
+	std::size_t size = 0;
+	int flag = c.peek(b,n,size);
+	if(flag == KG_NET_COMPRESS_FLAG_RAW)
+	{
+		out.assign((const char*)b + 1,size);
+		return true;
+	}
+	else if(flag != KG_NET_COMPRESS_FLAG_DEFLATE)
+	{
+		return false;
+	}
+	boost::shared_array<kg::byte_t> data;
+	if(!c.inflate(b,n,size,data))
+	{
+		return false;
+	}
+	out.assign((const char*)data.get(),size);
+	return true;
+}
+
+TEST(TypeCompressor, HandleRoundTrip)
+{
+	kg::net::compressor_t c(16);
+	std::string str;
+	for(int i=0; i<1000; ++i)
+	{
+		str += "cerberus is an idea ";
+	}
+	const kg::byte_t* b = (const kg::byte_t*)str.data();
+	std::vector<kg::byte_t> out(KG_NET_COMPRESS_HEADER + str.size());
+
+	//重複使用 同一 壓縮器
+	for(int i=0; i<3; ++i)
+	{
+		std::size_t n = c.compress(b,str.size(),out.data());
+		ASSERT_GT(n,0);
+		EXPECT_LT(n,str.size() / 10);
+		EXPECT_EQ(out[0],KG_NET_COMPRESS_FLAG_DEFLATE);
+
+		std::size_t size = 0;
+		EXPECT_EQ(c.peek(out.data(),n,size),KG_NET_COMPRESS_FLAG_DEFLATE);
+		EXPECT_EQ(size,str.size());
+		std::string rs;
+		ASSERT_TRUE(decompress(c,out.data(),n,rs));
+		EXPECT_EQ(rs,str);
+	}
+}
+TEST(TypeCompressor, HandleRaw)
+{
+	kg::net::compressor_t c(16);
+	std::vector<kg::byte_t> out(KG_NET_COMPRESS_HEADER + 64);
+
+	//小於 閾值 不壓縮 由 調用者 加上 標記
+	EXPECT_FALSE(c.compressible(4));
+	EXPECT_EQ(c.compress((const kg::byte_t*)"king",4,out.data()),0);
+	std::string rs;
+	const kg::byte_t raw[] = {KG_NET_COMPRESS_FLAG_RAW,'k','i','n','g'};
+	ASSERT_TRUE(decompress(c,raw,sizeof(raw),rs));
+	EXPECT_EQ(rs,"king");
+
+	//壓縮後 未變小 不寫入
+	kg::byte_t random[64];
+	kg::uint32_t x = 2463534242u;
+	for(int i=0; i<64; ++i)
+	{
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		random[i] = kg::byte_t(x);
+	}
+	EXPECT_TRUE(c.compressible(64));
+	EXPECT_EQ(c.compress(random,64,out.data()),0);
+
+	//空 消息
+	EXPECT_FALSE(c.compressible(0));
+	ASSERT_TRUE(decompress(c,raw,1,rs));
+	EXPECT_TRUE(rs.empty());
+}
+TEST(TypeCompressor, HandleBadData)
+{
+	kg::net::compressor_t c(16,Z_DEFAULT_COMPRESSION,1024);
+	std::string str(4096,'a');
+	std::vector<kg::byte_t> out(KG_NET_COMPRESS_HEADER + str.size());
+	std::size_t n = c.compress((const kg::byte_t*)str.data(),str.size(),out.data());
+	ASSERT_GT(n,KG_NET_COMPRESS_HEADER);
+
+	std::string rs;
+	std::size_t size = 0;
+	//超過 最大長度
+	EXPECT_EQ(c.peek(out.data(),n,size),-1);
+	EXPECT_FALSE(decompress(c,out.data(),n,rs));
+
+	kg::net::compressor_t d(16);
+	//截斷
+	EXPECT_FALSE(decompress(d,out.data(),n - 1,rs));
+	//聲明的 原始長度 不符
+	out[4] ^= 1;
+	EXPECT_FALSE(decompress(d,out.data(),n,rs));
+	out[4] ^= 1;
+	//未知 標記
+	out[0] = 9;
+	EXPECT_FALSE(decompress(d,out.data(),n,rs));
+	EXPECT_FALSE(decompress(d,out.data(),0,rs));
+	//錯誤後 仍可 繼續 使用
+	out[0] = KG_NET_COMPRESS_FLAG_DEFLATE;
+	ASSERT_TRUE(decompress(d,out.data(),n,rs));
+	EXPECT_EQ(rs,str);
+}
+TEST(TypeCompressor, HandleDeclaredSize)
+{
+	//高 壓縮比 的 數據 輸出 需要 多次 增長
+	kg::net::compressor_t c(16);
+	std::string str(4 * 1024 * 1024,0);
+	for(std::size_t i=0;i<str.size();i+=4096)
+	{
+		str[i] = char(i >> 12);
+	}
+	std::vector<kg::byte_t> out(KG_NET_COMPRESS_HEADER + str.size());
+	std::size_t n = c.compress((const kg::byte_t*)str.data(),str.size(),out.data());
+	ASSERT_LT(n,str.size() / 100);
+	std::string rs;
+	ASSERT_TRUE(decompress(c,out.data(),n,rs));
+	EXPECT_TRUE(rs == str);
+
+	//聲明的 長度 遠大於 實際 數據 時 在 輸入 用盡 後 失敗 不會 按 聲明 分配
+	std::vector<kg::byte_t> small(KG_NET_COMPRESS_HEADER + 64);
+	std::string body(64,'a');
+	n = c.compress((const kg::byte_t*)body.data(),body.size(),small.data());
+	ASSERT_EQ(small[0],KG_NET_COMPRESS_FLAG_DEFLATE);
+	const std::size_t declared = 0xffffffff;
+	small[1] = kg::byte_t(declared >> 24);
+	small[2] = kg::byte_t(declared >> 16);
+	small[3] = kg::byte_t(declared >> 8);
+	small[4] = kg::byte_t(declared);
+	kg::net::compressor_t big(16,Z_DEFAULT_COMPRESSION,declared);
+	std::size_t size = 0;
+	ASSERT_EQ(big.peek(small.data(),n,size),KG_NET_COMPRESS_FLAG_DEFLATE);
+	boost::shared_array<kg::byte_t> data;
+	EXPECT_FALSE(big.inflate(small.data(),n,size,data));
+
+	//實際 數據 超過 聲明的 長度 時 失敗
+	n = c.compress((const kg::byte_t*)str.data(),str.size(),out.data());
+	size = 8 * 1024;
+	EXPECT_FALSE(c.inflate(out.data(),n,size,data));
+	EXPECT_FALSE(data);
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <boost/lexical_cast.hpp>
+#include <kg/net/connection.hpp>
+#define PORT 1138
+
+//建立 回環 連接 s 爲 被 accept 的 一端
+void pair(kg::net::io_service_t& service,kg::net::connection_t& s,kg::net::socket_t& peer)
+{
+	kg::net::endpoint_t endpoint(boost::asio::ip::address::from_string("127.0.0.1"),PORT);
+	kg::net::acceptor_t acceptor(service,endpoint);
+	peer.connect(endpoint);
+	acceptor.accept(s);
+}
+std::string read(kg::net::socket_t& peer,std::size_t n)
+{
+	std::string str(n,0);
+	boost::asio::read(peer,boost::asio::buffer(&str[0],n));
+	return str;
+}
+TEST(TypeConnection, HandleWatermarks)
+{
+	kg::net::io_service_t service;
+	kg::net::connection_spt s = boost::make_shared<kg::net::connection_t>(service);
+	kg::net::socket_t peer(service);
+	pair(service,*s,peer);
+	s->watermarks(1000,200);
+
+	//io_service 未 運行 消息 都 留在 隊列中
+	std::string expect;
+	std::string msg(300,0);
+	int i = 0;
+	while(s->writable())
+	{
+		msg.assign(300,char('a' + i++));
+		ASSERT_TRUE(s->send((const kg::byte_t*)msg.data(),msg.size()));
+		expect += msg;
+	}
+	EXPECT_EQ(i,4);
+	EXPECT_EQ(s->pending(),1200);
+	//超過 高水位 拒絕
+	EXPECT_FALSE(s->send((const kg::byte_t*)msg.data(),msg.size()));
+	EXPECT_EQ(s->pending(),1200);
+
+	//寫出 後 回落到 低水位 喚醒 等待者
+	bool woken = false;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx){
+		s->wait_writable(ctx);
+		woken = true;
+		EXPECT_LE(s->pending(),200);
+	});
+	service.run();
+	EXPECT_TRUE(woken);
+	EXPECT_TRUE(s->writable());
+	EXPECT_EQ(read(peer,expect.size()),expect);
+}
+TEST(TypeConnection, HandleGather)
+{
+	kg::net::io_service_t service;
+	kg::net::connection_spt s = boost::make_shared<kg::net::connection_t>(service);
+	kg::net::socket_t peer(service);
+	pair(service,*s,peer);
+	kg::net::counter_t bytes_out;
+	s->metrics(&bytes_out);
+
+	std::string expect;
+	for(int i=0;i<100;++i)
+	{
+		std::string msg = boost::lexical_cast<std::string>(i) + ",";
+		ASSERT_TRUE(s->send((const kg::byte_t*)msg.data(),msg.size()));
+		expect += msg;
+	}
+
+	//100 個 消息 合併 爲 KG_NET_CONNECTION_MAX_GATHER 個 一組 的 兩次 寫出
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx){
+		s->flush(ctx);
+	});
+	std::size_t handlers = service.run();
+	EXPECT_LT(handlers,20);
+	EXPECT_EQ(s->pending(),0);
+	EXPECT_EQ(bytes_out.get(),expect.size());
+	EXPECT_EQ(read(peer,expect.size()),expect);
+}
+TEST(TypeConnection, HandleOffset)
+{
+	kg::net::io_service_t service;
+	kg::net::connection_spt s = boost::make_shared<kg::net::connection_t>(service);
+	kg::net::socket_t peer(service);
+	pair(service,*s,peer);
+
+	//只 發送 data 中 由 offset 開始的 部分 不拷貝
+	std::string str = "xxkatexxking";
+	boost::shared_array<kg::byte_t> data(new kg::byte_t[str.size()]);
+	memcpy(data.get(),str.data(),str.size());
+	ASSERT_TRUE(s->send(data,2,4));
+	ASSERT_TRUE(s->send(data,8,4));
+	EXPECT_EQ(s->pending(),8);
+	service.run();
+	EXPECT_EQ(read(peer,8),"kateking");
+}
+TEST(TypeConnection, HandleError)
+{
+	kg::net::io_service_t service;
+	kg::net::connection_spt s = boost::make_shared<kg::net::connection_t>(service);
+	kg::net::socket_t peer(service);
+	pair(service,*s,peer);
+
+	//寫出 失敗 後 丟棄 隊列 拒絕 send flush 拋出 異常
+	ASSERT_TRUE(s->send((const kg::byte_t*)"king",4));
+	s->close();
+	bool thrown = false;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx){
+		try
+		{
+			s->flush(ctx);
+		}
+		catch(const boost::system::system_error&)
+		{
+			thrown = true;
+		}
+	});
+	service.run();
+	EXPECT_TRUE(thrown);
+	EXPECT_EQ(s->pending(),0);
+	EXPECT_FALSE(s->writable());
+	EXPECT_FALSE(s->send((const kg::byte_t*)"king",4));
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <boost/thread.hpp>
+#include <kg/net/echo_client.hpp>
+#define ADDRESS "127.0.0.1:1135"
+#define PORT 1135
+
+//在 獨立 線程 上 同步 接受 一個 連接 並 分段 寫入 數據 的 回環 服務器
+class loopback_t
+{
+public:
+	kg::net::io_service_t service;
+	kg::net::acceptor_t acceptor;
+	kg::net::socket_t socket;
+	boost::thread thread;
+	explicit loopback_t(const std::vector<std::string>& chunks)
+		:acceptor(service,kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT)),socket(service)
+	{
+		thread = boost::thread([this,chunks]()
+		{
+			acceptor.accept(socket);
+			for(std::size_t i=0;i<chunks.size();++i)
+			{
+				boost::asio::write(socket,boost::asio::buffer(chunks[i]));
+				boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+			}
+		});
+	}
+	~loopback_t()
+	{
+		thread.join();
+	}
+};
+std::string to_string(const kg::net::echo_client_t::bytes_t& b)
+{
+	return std::string((const char*)b.get(),b.size());
+}
+//u32 大端 長度 (包含 4字節 包頭)
+int length_reader(kg::byte_t* b,std::size_t)
+{
+	return int((kg::uint32_t(b[0]) << 24) | (kg::uint32_t(b[1]) << 16) | (kg::uint32_t(b[2]) << 8) | kg::uint32_t(b[3])) + 4;
+}
+std::string frame(const std::string& body)
+{
+	std::string s(4,0);
+	s[0] = char(body.size() >> 24);
+	s[1] = char(body.size() >> 16);
+	s[2] = char(body.size() >> 8);
+	s[3] = char(body.size());
+	return s + body;
+}
+
+//分段 輸入 的 數據 組成 完整 消息 後 才 返回 且 消息 完全 一致
+void expect_messages(kg::net::echo_client_t& c)
+{
+	const std::string bytes = frame("abc") + frame("xy") + frame(std::string(1000,'z'));
+	const kg::byte_t* b = (const kg::byte_t*)bytes.data();
+
+	EXPECT_EQ(c.reader_message(b,5).size(),0);
+	EXPECT_EQ(to_string(c.reader_message(b + 5,7)),frame("abc"));
+	//緩衝區 中 剩餘的 部分 消息
+	EXPECT_EQ(c.reader_message().size(),0);
+	EXPECT_EQ(to_string(c.reader_message(b + 12,1)),frame("xy"));
+	EXPECT_EQ(c.reader_message(b + 13,500).size(),0);
+	EXPECT_EQ(to_string(c.reader_message(b + 513,bytes.size() - 513)),frame(std::string(1000,'z')));
+	EXPECT_EQ(c.reader_message().size(),0);
+}
+TEST(TypeEchoClientRead, HandleReaderMessageFramer)
+{
+	kg::net::echo_client_t c(0);
+	c.framer(kg::net::framer_t::length(4));
+	expect_messages(c);
+}
+TEST(TypeEchoClientRead, HandleReaderMessageCallback)
+{
+	kg::net::echo_client_t c(4);
+	c.reader(length_reader);
+	expect_messages(c);
+}
+TEST(TypeEchoClientRead, HandleBadHeader)
+{
+	//長度 溢出 爲 負數
+	kg::net::echo_client_t c(4);
+	c.reader(length_reader);
+	const kg::byte_t b[4] = {0xff,0xff,0xff,0xff};
+	boost::system::error_code ec;
+	c.reader_message(b,4,ec);
+	EXPECT_EQ(ec,boost::system::error_code(KG_NET_ECHO_CLIENT_CODE_BAD_MSG_HEADER,kg::net::echo_client_category::get()));
+}
+TEST(TypeEchoClientRead, HandleRawRead)
+{
+	std::vector<std::string> chunks;
+	chunks.push_back("hello");
+	chunks.push_back(std::string("\x00\x01\x02\xff",4));
+	loopback_t server(chunks);
+
+	//沒有 解包 函數 時 原樣 返回 收到的 數據
+	kg::net::echo_client_t c(0);
+	c.connect(ADDRESS);
+	std::string got;
+	while(got.size() < 9)
+	{
+		got += to_string(c.read());
+	}
+	EXPECT_EQ(got,std::string("hello\x00\x01\x02\xff",9));
+}
+TEST(TypeEchoClientRead, HandleFramedRead)
+{
+	//兩個 消息 一次 寫入 第三個 消息 分 兩次 寫入
+	const std::string big(100000,'q');
+	std::vector<std::string> chunks;
+	chunks.push_back(frame("abc") + frame("xy") + frame(big).substr(0,7));
+	chunks.push_back(frame(big).substr(7));
+	loopback_t server(chunks);
+
+	kg::net::echo_client_t c(4);
+	c.reader(length_reader);
+	c.connect(ADDRESS);
+	EXPECT_EQ(to_string(c.read()),frame("abc"));
+	EXPECT_EQ(to_string(c.read()),frame("xy"));
+	EXPECT_EQ(to_string(c.read()),frame(big));
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
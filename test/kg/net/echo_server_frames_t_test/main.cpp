@@ -0,0 +1,303 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <boost/thread.hpp>
+#include <kg/net/echo_server.hpp>
+#define ADDRESS "127.0.0.1:1144"
+#define PORT 1144
+typedef int session_t;
+typedef kg::net::echo_server_t<session_t> echo_server_t;
+
+//記錄 交付的 消息 與 每次 batch 回調 的 消息數
+class recorder_t
+{
+public:
+	boost::mutex mutex;
+	std::vector<std::string> messages;
+	std::vector<std::size_t> batches;
+	void readed(echo_server_t& s)
+	{
+		s.readed([this](const kg::net::connection_spt&,session_t&,kg::byte_t* b,std::size_t n,const boost::asio::yield_context&){
+			boost::mutex::scoped_lock lock(mutex);
+			messages.push_back(std::string((const char*)b,n));
+			return true;
+		});
+	}
+	void batch(echo_server_t& s)
+	{
+		s.batch([this](const kg::net::connection_spt&,session_t&,const std::vector<echo_server_t::message_t>& batch,const boost::asio::yield_context&){
+			boost::mutex::scoped_lock lock(mutex);
+			batches.push_back(batch.size());
+			for(std::size_t i=0;i<batch.size();++i)
+			{
+				messages.push_back(std::string((const char*)batch[i].data,batch[i].size));
+			}
+			return true;
+		});
+	}
+	//等待 收到 n 個 消息
+	std::vector<std::string> wait(std::size_t n)
+	{
+		for(int i=0;i<300;++i)
+		{
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				if(messages.size() >= n)
+				{
+					return messages;
+				}
+			}
+			boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+		}
+		boost::mutex::scoped_lock lock(mutex);
+		return messages;
+	}
+};
+void connect(kg::net::socket_t& c)
+{
+	c.connect(kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT));
+	//每次 write 儘量 成爲 一個 tcp 段
+	c.set_option(boost::asio::ip::tcp::no_delay(true));
+}
+//返回 u32 大端 長度前綴 的 幀
+std::string frame(const std::string& body)
+{
+	std::string rs(4,0);
+	rs[0] = char(body.size() >> 24);
+	rs[1] = char(body.size() >> 16);
+	rs[2] = char(body.size() >> 8);
+	rs[3] = char(body.size());
+	return rs + body;
+}
+//u16 大端 包頭 中 記錄 包括 包頭 的 消息 長度
+int reader(session_t&,kg::byte_t* b,std::size_t,const boost::asio::yield_context&)
+{
+	return (int(b[0]) << 8) | int(b[1]);
+}
+std::string packet(const std::string& body)
+{
+	std::size_t n = body.size() + 2;
+	std::string rs(2,0);
+	rs[0] = char(n >> 8);
+	rs[1] = char(n);
+	return rs + body;
+}
+TEST(TypeEchoServerFrames, HandleCoalescedFramer)
+{
+	recorder_t r;
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::length(4));
+	r.readed(s);
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	//一次 寫入 多個 完整 幀
+	boost::asio::write(c,boost::asio::buffer(frame("kate") + frame("anita") + frame("king")));
+	std::vector<std::string> messages = r.wait(3);
+	ASSERT_EQ(messages.size(),3);
+	EXPECT_EQ(messages[0],"kate");
+	EXPECT_EQ(messages[1],"anita");
+	EXPECT_EQ(messages[2],"king");
+	s.stop();
+}
+TEST(TypeEchoServerFrames, HandleCoalescedReader)
+{
+	recorder_t r;
+	echo_server_t s(ADDRESS,1,0,2);
+	s.reader(reader);
+	r.readed(s);
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	boost::asio::write(c,boost::asio::buffer(packet("kate") + packet("anita") + packet("king")));
+	std::vector<std::string> messages = r.wait(3);
+	ASSERT_EQ(messages.size(),3);
+	EXPECT_EQ(messages[0],packet("kate"));
+	EXPECT_EQ(messages[1],packet("anita"));
+	EXPECT_EQ(messages[2],packet("king"));
+	s.stop();
+}
+TEST(TypeEchoServerFrames, HandleCoalescedBatch)
+{
+	recorder_t r;
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::delimiter("\r\n"));
+	r.batch(s);
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	//一次 讀取 的 所有 完整 消息 一次 交給 batch
+	std::string data;
+	for(int i=0;i<10;++i)
+	{
+		data += "line" + boost::lexical_cast<std::string>(i) + "\r\n";
+	}
+	boost::asio::write(c,boost::asio::buffer(data));
+	std::vector<std::string> messages = r.wait(10);
+	ASSERT_EQ(messages.size(),10);
+	for(int i=0;i<10;++i)
+	{
+		EXPECT_EQ(messages[i],"line" + boost::lexical_cast<std::string>(i));
+	}
+	s.stop();
+
+	boost::mutex::scoped_lock lock(r.mutex);
+	ASSERT_EQ(r.batches.size(),1);
+	EXPECT_EQ(r.batches[0],10);
+}
+
+//分多次 寫入 每次 之間 等待 服務器 讀取
+void write_parts(kg::net::socket_t& c,const std::string& data,const std::vector<std::size_t>& cuts)
+{
+	std::size_t pos = 0;
+	for(std::size_t i=0;i<=cuts.size();++i)
+	{
+		std::size_t end = i < cuts.size() ? cuts[i] : data.size();
+		boost::asio::write(c,boost::asio::buffer(data.data() + pos,end - pos));
+		pos = end;
+		boost::this_thread::sleep(boost::posix_time::milliseconds(30));
+	}
+}
+TEST(TypeEchoServerFrames, HandleSplitFramer)
+{
+	recorder_t r;
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::length(4));
+	r.readed(s);
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	//在 包頭 中間 消息體 中間 與 下一幀 中間 拆分
+	std::string data = frame("kate") + frame("anita") + frame("king");
+	std::vector<std::size_t> cuts;
+	cuts.push_back(2);
+	cuts.push_back(6);
+	cuts.push_back(12);
+	cuts.push_back(19);
+	write_parts(c,data,cuts);
+	std::vector<std::string> messages = r.wait(3);
+	ASSERT_EQ(messages.size(),3);
+	EXPECT_EQ(messages[0],"kate");
+	EXPECT_EQ(messages[1],"anita");
+	EXPECT_EQ(messages[2],"king");
+
+	//超過 讀取 緩衝區 的 幀 被 拼接
+	std::string big(300 * 1024,0);
+	for(std::size_t i=0;i<big.size();++i)
+	{
+		big[i] = char(i % 251);
+	}
+	boost::asio::write(c,boost::asio::buffer(frame(big) + frame("end")));
+	messages = r.wait(5);
+	ASSERT_EQ(messages.size(),5);
+	EXPECT_TRUE(messages[3] == big);
+	EXPECT_EQ(messages[4],"end");
+	s.stop();
+}
+TEST(TypeEchoServerFrames, HandleSplitReader)
+{
+	recorder_t r;
+	echo_server_t s(ADDRESS,1,0,2);
+	s.reader(reader);
+	r.readed(s);
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	std::string data = packet("kate") + packet("anita");
+	std::vector<std::size_t> cuts;
+	for(std::size_t i=1;i<data.size();++i)
+	{
+		cuts.push_back(i);
+	}
+	//逐 字節 寫入
+	write_parts(c,data,cuts);
+	std::vector<std::string> messages = r.wait(2);
+	ASSERT_EQ(messages.size(),2);
+	EXPECT_EQ(messages[0],packet("kate"));
+	EXPECT_EQ(messages[1],packet("anita"));
+	s.stop();
+}
+TEST(TypeEchoServerFrames, HandleSplitDelimiter)
+{
+	recorder_t r;
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::delimiter("\r\n"));
+	r.readed(s);
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	//在 分隔符 中間 拆分
+	std::string data = "kate\r\nanita\r\n";
+	std::vector<std::size_t> cuts;
+	cuts.push_back(5);
+	cuts.push_back(9);
+	cuts.push_back(13);
+	write_parts(c,data,cuts);
+	std::vector<std::string> messages = r.wait(2);
+	ASSERT_EQ(messages.size(),2);
+	EXPECT_EQ(messages[0],"kate");
+	EXPECT_EQ(messages[1],"anita");
+	s.stop();
+}
+
+//回調 只 處理 消息體 send 按 framer 加上 幀頭 或 分隔符
+void echo(echo_server_t& s,const kg::net::framer_t& framer,const std::string& request,const std::string& response)
+{
+	s.framer(framer);
+	echo_server_t* ps = &s;
+	s.readed([ps](const kg::net::connection_spt& c,session_t&,kg::byte_t* b,std::size_t n,const boost::asio::yield_context&){
+		for(std::size_t i=0;i<n;++i)
+		{
+			b[i] = kg::byte_t(std::toupper(b[i]));
+		}
+		return ps->send(c,b,n);
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	boost::asio::write(c,boost::asio::buffer(request));
+	std::string rs(response.size(),0);
+	boost::asio::read(c,boost::asio::buffer(&rs[0],rs.size()));
+	EXPECT_EQ(rs,response);
+	s.stop();
+}
+TEST(TypeEchoServerFrames, HandleEcho)
+{
+	{
+		echo_server_t s(ADDRESS,1,0,0);
+		echo(s,kg::net::framer_t::length(4),frame("kate"),frame("KATE"));
+	}
+	{
+		echo_server_t s(ADDRESS,1,0,0);
+		echo(s,kg::net::framer_t::varint(),std::string("\x04king",5),std::string("\x04KING",5));
+	}
+	{
+		echo_server_t s(ADDRESS,1,0,0);
+		echo(s,kg::net::framer_t::delimiter("\r\n"),"kate\r\nking\r\n","KATE\r\nKING\r\n");
+	}
+	{
+		echo_server_t s(ADDRESS,1,0,0);
+		echo(s,kg::net::framer_t::fixed(4),"kateking","KATEKING");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
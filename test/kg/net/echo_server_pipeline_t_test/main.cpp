@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <kg/net/echo_server.hpp>
+#define ADDRESS "127.0.0.1:1145"
+#define PORT 1145
+typedef int session_t;
+typedef kg::net::echo_server_t<session_t> echo_server_t;
+
+//返回 u32 大端 長度前綴 的 幀
+std::string frame(const std::string& body)
+{
+	std::string rs(4,0);
+	rs[0] = char(body.size() >> 24);
+	rs[1] = char(body.size() >> 16);
+	rs[2] = char(body.size() >> 8);
+	rs[3] = char(body.size());
+	return rs + body;
+}
+//讀取 一個 幀 的 消息體
+std::string read_frame(kg::net::socket_t& c)
+{
+	kg::byte_t header[4];
+	boost::asio::read(c,boost::asio::buffer(header));
+	std::size_t n = (std::size_t(header[0]) << 24) | (std::size_t(header[1]) << 16) | (std::size_t(header[2]) << 8) | std::size_t(header[3]);
+	std::string rs(n,0);
+	boost::asio::read(c,boost::asio::buffer(&rs[0],n));
+	return rs;
+}
+//消息體 爲 "延遲毫秒:名稱" 延遲 後 以 名稱 響應 名稱 爲 bad 時 返回 false
+class handler_t
+{
+public:
+	boost::mutex mutex;
+	std::vector<std::string> completed;
+	boost::atomic<int> inflight;
+	boost::atomic<int> peak;
+	handler_t():inflight(0),peak(0)
+	{
+	}
+	bool operator()(const kg::net::connection_spt& s,session_t&,kg::byte_t* b,std::size_t n,echo_server_t::response_t& response,const boost::asio::yield_context& ctx)
+	{
+		int current = ++inflight;
+		int old = peak;
+		while(current > old && !peak.compare_exchange_weak(old,current))
+		{
+		}
+		std::string body((const char*)b,n);
+		std::size_t find = body.find(':');
+		int delay = boost::lexical_cast<int>(body.substr(0,find));
+		std::string name = body.substr(find + 1);
+
+		kg::net::deadline_timer_t timer(s->get_executor());
+		timer.expires_from_now(boost::posix_time::milliseconds(delay));
+		timer.async_wait(ctx);
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			completed.push_back(name);
+		}
+		--inflight;
+		if(name == "bad")
+		{
+			return false;
+		}
+
+		//響應 寫出 時 加上 幀頭
+		response.data.reset(new kg::byte_t[name.size()]);
+		std::memcpy(response.data.get(),name.data(),name.size());
+		response.size = name.size();
+		return true;
+	}
+};
+void connect(kg::net::socket_t& c)
+{
+	c.connect(kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT));
+}
+TEST(TypeEchoServerPipeline, HandleReorder)
+{
+	handler_t h;
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::length(4));
+	s.pipeline(boost::ref(h),8);
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	//先 到達 的 消息 後 完成
+	std::string data;
+	for(int i=0;i<5;++i)
+	{
+		data += frame(boost::lexical_cast<std::string>((5 - i) * 40) + ":m" + boost::lexical_cast<std::string>(i));
+	}
+	boost::asio::write(c,boost::asio::buffer(data));
+	for(int i=0;i<5;++i)
+	{
+		EXPECT_EQ(read_frame(c),"m" + boost::lexical_cast<std::string>(i));
+	}
+	s.stop();
+
+	boost::mutex::scoped_lock lock(h.mutex);
+	ASSERT_EQ(h.completed.size(),5);
+	for(int i=0;i<5;++i)
+	{
+		EXPECT_EQ(h.completed[i],"m" + boost::lexical_cast<std::string>(4 - i));
+	}
+	EXPECT_EQ(h.peak,5);
+}
+TEST(TypeEchoServerPipeline, HandleRingFull)
+{
+	handler_t h;
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::length(4));
+	//環形 隊列 只有 2個 位置
+	s.pipeline(boost::ref(h),2);
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	std::string data;
+	for(int i=0;i<6;++i)
+	{
+		data += frame((i % 2 ? "10:m" : "50:m") + boost::lexical_cast<std::string>(i));
+	}
+	boost::asio::write(c,boost::asio::buffer(data));
+	for(int i=0;i<6;++i)
+	{
+		EXPECT_EQ(read_frame(c),"m" + boost::lexical_cast<std::string>(i));
+	}
+	s.stop();
+	//隊列 滿 時 暫停 讀取 同時 處理的 消息 不超過 上限
+	EXPECT_EQ(h.peak,2);
+}
+TEST(TypeEchoServerPipeline, HandleError)
+{
+	handler_t h;
+	boost::atomic<bool> closed(false);
+	boost::atomic<bool> pending(false);
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::length(4));
+	s.pipeline(boost::ref(h),8);
+	s.closed([&](const kg::net::connection_spt&,session_t&,const boost::asio::yield_context&){
+		//closed 在 處理中的 消息 結束 之後 調用
+		boost::mutex::scoped_lock lock(h.mutex);
+		pending = h.completed.size() != 3;
+		closed = true;
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	//slow 尚未 完成 時 bad 出錯
+	boost::asio::write(c,boost::asio::buffer(frame("0:fast") + frame("200:slow") + frame("20:bad")));
+	EXPECT_EQ(read_frame(c),"fast");
+	//出錯 之後 的 響應 不再 寫出
+	kg::byte_t b[16];
+	boost::system::error_code ec;
+	c.read_some(boost::asio::buffer(b),ec);
+	EXPECT_TRUE(ec == boost::asio::error::eof || ec == boost::asio::error::connection_reset);
+	for(int i=0;i<300 && !closed;++i)
+	{
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	EXPECT_TRUE(closed);
+	EXPECT_FALSE(pending);
+	s.stop();
+
+	boost::mutex::scoped_lock lock(h.mutex);
+	ASSERT_EQ(h.completed.size(),3);
+	EXPECT_EQ(h.completed[0],"fast");
+	EXPECT_EQ(h.completed[1],"bad");
+	EXPECT_EQ(h.completed[2],"slow");
+}
+TEST(TypeEchoServerPipeline, HandleStackSize)
+{
+	//處理 協程 使用 服務器 設定的 棧 大小
+	kg::net::basic_server_options_t options;
+	options.stack_size = 2 * 1024 * 1024;
+	echo_server_t s(ADDRESS,1,0,0,options);
+	s.framer(kg::net::framer_t::length(4));
+	s.pipeline([](const kg::net::connection_spt&,session_t&,kg::byte_t*,std::size_t,echo_server_t::response_t& response,const boost::asio::yield_context&){
+		//使用 超過 默認 棧 的 內存
+		volatile char big[1024 * 1024];
+		big[0] = 1;
+		big[sizeof(big) - 1] = big[0];
+		response.data.reset(new kg::byte_t[2]);
+		std::memcpy(response.data.get(),"ok",2);
+		response.size = 2;
+		return true;
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	boost::asio::write(c,boost::asio::buffer(frame("0:big")));
+	EXPECT_EQ(read_frame(c),"ok");
+	s.stop();
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,286 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <kg/net/echo_server.hpp>
+#define ADDRESS "127.0.0.1:1131"
+#define PORT 1131
+typedef int session_t;
+typedef kg::net::echo_server_t<session_t> echo_server_t;
+
+//寫入 u32 大端 長度前綴 的 幀
+void write_frame(kg::net::socket_t& c,const std::string& body)
+{
+	std::string frame(4,0);
+	frame[0] = char(body.size() >> 24);
+	frame[1] = char(body.size() >> 16);
+	frame[2] = char(body.size() >> 8);
+	frame[3] = char(body.size());
+	frame += body;
+	boost::asio::write(c,boost::asio::buffer(frame));
+}
+TEST(TypeEchoServerStream, HandleStreamOnly)
+{
+	boost::mutex mutex;
+	std::string streamed;
+	int begins = 0;
+	int ends = 0;
+
+	//只 設置 stream 回調
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::length(4));
+	s.stream([&](const kg::net::connection_spt&,session_t&,int flags,kg::byte_t* b,std::size_t n,const boost::asio::yield_context&){
+		boost::mutex::scoped_lock lock(mutex);
+		if(flags & KG_NET_STREAM_BEGIN)
+		{
+			++begins;
+		}
+		if(flags & KG_NET_STREAM_END)
+		{
+			++ends;
+		}
+		streamed.append((const char*)b,n);
+		return true;
+	},16);
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	c.connect(kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT));
+	std::string big(1000,'a');
+	for(std::size_t i=0;i<big.size();++i)
+	{
+		big[i] = char('a' + i % 26);
+	}
+	//不超過 threshold 的 消息 被 丟棄 連接 保持
+	write_frame(c,big);
+	write_frame(c,"small");
+	write_frame(c,big);
+
+	//只 交付 消息體
+	std::string expect = big + big;
+	for(int i=0;i<200;++i)
+	{
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			if(streamed.size() >= expect.size())
+			{
+				break;
+			}
+		}
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	s.stop();
+
+	boost::mutex::scoped_lock lock(mutex);
+	EXPECT_EQ(streamed,expect);
+	EXPECT_EQ(begins,2);
+	EXPECT_EQ(ends,2);
+}
+
+//等待 服務器 斷開 連接
+bool closed(kg::net::socket_t& c)
+{
+	kg::byte_t b[16];
+	boost::system::error_code ec;
+	c.read_some(boost::asio::buffer(b),ec);
+	return ec == boost::asio::error::eof || ec == boost::asio::error::connection_reset;
+}
+void connect(kg::net::socket_t& c)
+{
+	c.connect(kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT));
+}
+TEST(TypeEchoServerStream, HandleMaxFrame)
+{
+	boost::atomic<int> count(0);
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::length(4));
+	s.max_frame(16);
+	echo_server_t* ps = &s;
+	s.readed([&](const kg::net::connection_spt& c,session_t&,kg::byte_t* b,std::size_t n,const boost::asio::yield_context&){
+		++count;
+		return ps->send(c,b,n);
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	write_frame(c,"kate");
+	std::string echo(8,0);
+	boost::asio::read(c,boost::asio::buffer(&echo[0],echo.size()));
+	EXPECT_EQ(echo,std::string("\x00\x00\x00\x04kate",8));
+
+	//只 收到 包頭 就 斷開 不會 等待 消息體
+	std::string header("\x00\x10\x00\x00",4);
+	boost::asio::write(c,boost::asio::buffer(header));
+	EXPECT_TRUE(closed(c));
+	EXPECT_EQ(count,1);
+	s.stop();
+}
+int reader(session_t&,kg::byte_t* b,std::size_t,const boost::asio::yield_context&)
+{
+	return (int(b[0]) << 8) | int(b[1]);
+}
+TEST(TypeEchoServerStream, HandleMaxFrameReader)
+{
+	boost::atomic<int> count(0);
+	echo_server_t s(ADDRESS,1,0,2);
+	s.reader(reader);
+	s.max_frame(16);
+	s.readed([&](const kg::net::connection_spt&,session_t&,kg::byte_t*,std::size_t,const boost::asio::yield_context&){
+		++count;
+		return true;
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	//包頭 記錄的 長度 16 不超過 上限
+	std::string packet("\x00\x10",2);
+	packet += std::string(14,'a');
+	packet += std::string("\x00\x11",2);
+	boost::asio::write(c,boost::asio::buffer(packet));
+	EXPECT_TRUE(closed(c));
+	EXPECT_EQ(count,1);
+	s.stop();
+}
+TEST(TypeEchoServerStream, HandleMaxFrameDelimiter)
+{
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::delimiter("\n"));
+	s.max_frame(16);
+	echo_server_t* ps = &s;
+	s.readed([&](const kg::net::connection_spt& c,session_t&,kg::byte_t* b,std::size_t n,const boost::asio::yield_context&){
+		return ps->send(c,b,n);
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	boost::asio::write(c,boost::asio::buffer(std::string("kate\n")));
+	std::string echo(5,0);
+	boost::asio::read(c,boost::asio::buffer(&echo[0],echo.size()));
+	EXPECT_EQ(echo,"kate\n");
+
+	//超過 上限 仍未 找到 分隔符
+	boost::asio::write(c,boost::asio::buffer(std::string(10,'a')));
+	boost::this_thread::sleep(boost::posix_time::milliseconds(30));
+	boost::asio::write(c,boost::asio::buffer(std::string(10,'a')));
+	EXPECT_TRUE(closed(c));
+	s.stop();
+}
+TEST(TypeEchoServerStream, HandleStreamMixed)
+{
+	boost::mutex mutex;
+	std::vector<std::string> events;
+	std::string streamed;
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::length(4));
+	//流式 交付的 消息 不受 max_frame 限制
+	s.max_frame(32);
+	s.readed([&](const kg::net::connection_spt&,session_t&,kg::byte_t* b,std::size_t n,const boost::asio::yield_context&){
+		boost::mutex::scoped_lock lock(mutex);
+		events.push_back("readed " + std::string((const char*)b,n));
+		return true;
+	});
+	s.stream([&](const kg::net::connection_spt&,session_t&,int flags,kg::byte_t* b,std::size_t n,const boost::asio::yield_context&){
+		boost::mutex::scoped_lock lock(mutex);
+		if(flags & KG_NET_STREAM_BEGIN)
+		{
+			events.push_back("begin");
+		}
+		streamed.append((const char*)b,n);
+		if(flags & KG_NET_STREAM_END)
+		{
+			events.push_back("end");
+		}
+		return true;
+	},16);
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	c.set_option(boost::asio::ip::tcp::no_delay(true));
+	std::string big(1000,0);
+	for(std::size_t i=0;i<big.size();++i)
+	{
+		big[i] = char('a' + i % 26);
+	}
+	//大消息 分 多次 到達 前後 的 小消息 保持 順序
+	write_frame(c,"kate");
+	std::string frame = std::string("\x00\x00\x03\xe8",4) + big;
+	boost::asio::write(c,boost::asio::buffer(frame.data(),300));
+	boost::this_thread::sleep(boost::posix_time::milliseconds(30));
+	boost::asio::write(c,boost::asio::buffer(frame.data() + 300,frame.size() - 300));
+	write_frame(c,"king");
+	for(int i=0;i<200;++i)
+	{
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			if(events.size() >= 4)
+			{
+				break;
+			}
+		}
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	s.stop();
+
+	boost::mutex::scoped_lock lock(mutex);
+	ASSERT_EQ(events.size(),4);
+	EXPECT_EQ(events[0],"readed kate");
+	EXPECT_EQ(events[1],"begin");
+	EXPECT_EQ(events[2],"end");
+	EXPECT_EQ(events[3],"readed king");
+	EXPECT_TRUE(streamed == big);
+}
+
+TEST(TypeEchoServerStream, HandleMaxFrameDecoded)
+{
+	boost::atomic<int> count(0);
+	echo_server_t s(ADDRESS,1,0,0);
+	s.framer(kg::net::framer_t::length(4));
+	s.compression(64);
+	//在 compression 之後 設置 的 上限 同樣 限制 解壓後 長度
+	s.max_frame(1024);
+	s.readed([&](const kg::net::connection_spt&,session_t&,kg::byte_t*,std::size_t n,const boost::asio::yield_context&){
+		++count;
+		return true;
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	connect(c);
+	kg::net::compress_stage_t stage(64);
+	std::string body(512,'a');
+	kg::net::view_t view((kg::byte_t*)body.data(),body.size());
+	ASSERT_TRUE(stage.encode(view,0));
+	write_frame(c,std::string((const char*)view.data,view.size));
+	for(int i=0;i<200 && count != 1;++i)
+	{
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	EXPECT_EQ(count,1);
+
+	//壓縮後 不超過 上限 解壓後 超過
+	body.assign(4096,'a');
+	view = kg::net::view_t((kg::byte_t*)body.data(),body.size());
+	ASSERT_TRUE(stage.encode(view,0));
+	ASSERT_LT(view.size,1024);
+	write_frame(c,std::string((const char*)view.data,view.size));
+	EXPECT_TRUE(closed(c));
+	EXPECT_EQ(count,1);
+	s.stop();
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <kg/net/framer.hpp>
+
+TEST(TypeFramer, HandleLength)
+{
+	kg::net::frame_t frame;
+	//u16 大端 不含 頭長
+	{
+		kg::net::framer_t framer = kg::net::framer_t::length(2);
+		kg::byte_t b[] = {0x01,0x02,'a'};
+		EXPECT_EQ(framer.decode(b,1,frame),KG_NET_FRAME_MORE);
+		EXPECT_EQ(framer.decode(b,3,frame),KG_NET_FRAME_OK);
+		EXPECT_EQ(frame.header,2);
+		EXPECT_EQ(frame.body,0x0102);
+		EXPECT_EQ(frame.size,0x0102 + 2);
+	}
+	//u32 小端 含 頭長
+	{
+		kg::net::framer_t framer = kg::net::framer_t::length(4,false,true);
+		kg::byte_t b[] = {0x0a,0x00,0x00,0x00};
+		EXPECT_EQ(framer.decode(b,4,frame),KG_NET_FRAME_OK);
+		EXPECT_EQ(frame.body,6);
+		EXPECT_EQ(frame.size,10);
+
+		//長度 小於 頭長
+		b[0] = 3;
+		EXPECT_EQ(framer.decode(b,4,frame),KG_NET_FRAME_ERROR);
+	}
+	//encode 與 decode 對稱
+	for(std::size_t bytes=1;bytes<=8;bytes<<=1)
+	{
+		for(int i=0;i<4;++i)
+		{
+			kg::net::framer_t framer = kg::net::framer_t::length(bytes,i & 1,(i & 2) != 0);
+			kg::byte_t b[8];
+			EXPECT_EQ(framer.encode(b,200),bytes);
+			EXPECT_EQ(framer.decode(b,bytes,frame),KG_NET_FRAME_OK);
+			EXPECT_EQ(frame.body,200);
+		}
+	}
+}
+TEST(TypeFramer, HandleVarint)
+{
+	kg::net::frame_t frame;
+	kg::net::framer_t framer = kg::net::framer_t::varint();
+	const std::size_t values[] = {0,1,127,128,300,16383,16384,1 << 30};
+	for(std::size_t i=0;i<sizeof(values)/sizeof(values[0]);++i)
+	{
+		kg::byte_t b[KG_NET_FRAMER_PEEK_MAX];
+		std::size_t n = framer.encode(b,values[i]);
+		EXPECT_EQ(n,framer.header_size(values[i]));
+		//前綴 不完整
+		EXPECT_EQ(framer.decode(b,n - 1,frame),KG_NET_FRAME_MORE);
+		EXPECT_EQ(framer.decode(b,n,frame),KG_NET_FRAME_OK);
+		EXPECT_EQ(frame.header,n);
+		EXPECT_EQ(frame.body,values[i]);
+	}
+
+	//超過 10 字節
+	kg::byte_t bad[KG_NET_FRAMER_PEEK_MAX];
+	memset(bad,0xff,sizeof(bad));
+	EXPECT_EQ(framer.decode(bad,sizeof(bad),frame),KG_NET_FRAME_ERROR);
+}
+TEST(TypeFramer, HandleDelimiter)
+{
+	kg::net::frame_t frame;
+	kg::net::framer_t framer = kg::net::framer_t::delimiter("\r\n");
+	std::string str = "abc\rdef\r\nxyz";
+	const kg::byte_t* b = (const kg::byte_t*)str.data();
+	EXPECT_EQ(framer.decode(b,4,frame),KG_NET_FRAME_MORE);
+	EXPECT_EQ(framer.decode(b,str.size(),frame),KG_NET_FRAME_OK);
+	EXPECT_EQ(frame.body,7);
+	EXPECT_EQ(frame.size,9);
+	EXPECT_EQ(framer.find(b + 9,3),3);
+	EXPECT_TRUE(framer.fits(1024));
+	EXPECT_EQ(framer.header_size(1024),0);
+}
+TEST(TypeFramer, HandleFixed)
+{
+	kg::net::frame_t frame;
+	kg::net::framer_t framer = kg::net::framer_t::fixed(64);
+	EXPECT_EQ(framer.peek(),0);
+	EXPECT_EQ(framer.decode(NULL,0,frame),KG_NET_FRAME_OK);
+	EXPECT_EQ(frame.size,64);
+	EXPECT_TRUE(framer.fits(64));
+	EXPECT_FALSE(framer.fits(63));
+
+	EXPECT_EQ(kg::net::framer_t().kind(),KG_NET_FRAMER_NONE);
+	EXPECT_FALSE(kg::net::framer_t().fits(1));
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
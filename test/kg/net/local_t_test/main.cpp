@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <cstdio>
+#include <sys/stat.h>
+#include <kg/net/basic_server.hpp>
+#include <kg/net/echo_client.hpp>
+#define PATH "/tmp/kg_net_local_t_test.sock"
+#define ADDRESS "unix:" PATH
+typedef int session_t;
+typedef kg::net::basic_server_t<session_t> server_t;
+typedef boost::asio::local::stream_protocol protocol_t;
+
+bool exists(const char* path)
+{
+	struct stat st;
+	return !stat(path,&st);
+}
+//回覆 收到的 數據
+void echo(server_t& s)
+{
+	s.readed([](const kg::net::connection_spt& c,session_t&,kg::byte_t* b,std::size_t n,const boost::asio::yield_context&){
+		//unix 域 socket 沒有 ip 地址
+		EXPECT_TRUE(c->peer().is_unspecified());
+		return c->send(b,n);
+	});
+}
+std::string call(kg::net::socket_t& c,const std::string& str)
+{
+	boost::asio::write(c,boost::asio::buffer(str));
+	std::string rs(str.size(),0);
+	boost::asio::read(c,boost::asio::buffer(&rs[0],rs.size()));
+	return rs;
+}
+TEST(TypeLocal, HandleAddress)
+{
+	std::string path;
+	EXPECT_TRUE(kg::net::is_local_address("unix:/tmp/a.sock",path));
+	EXPECT_EQ(path,"/tmp/a.sock");
+	EXPECT_FALSE(kg::net::is_local_address("unix:",path));
+	EXPECT_FALSE(kg::net::is_local_address("127.0.0.1:1102",path));
+}
+TEST(TypeLocal, HandleAccept)
+{
+	std::remove(PATH);
+	kg::net::basic_server_options_t options;
+	options.threads = 2;
+	//tcp 選項 對 unix 域 socket 被 忽略
+	options.socket.no_delay = true;
+	options.socket.keep_alive = true;
+	{
+		server_t s(ADDRESS,1,0,options);
+		echo(s);
+		s.run();
+		EXPECT_TRUE(exists(PATH));
+
+		kg::net::echo_client_t c(4);
+		c.connect(ADDRESS);
+		EXPECT_EQ(call(c.get(),"kate"),"kate");
+
+		kg::net::io_service_t service;
+		protocol_t::socket raw(service);
+		raw.connect(protocol_t::endpoint(PATH));
+		boost::asio::write(raw,boost::asio::buffer("anita",5));
+		char b[5];
+		boost::asio::read(raw,boost::asio::buffer(b,5));
+		EXPECT_EQ(std::string(b,5),"anita");
+
+		EXPECT_EQ(s.metrics().total.accepts,2);
+		s.stop();
+	}
+	//析構時 刪除 socket 文件
+	EXPECT_FALSE(exists(PATH));
+}
+TEST(TypeLocal, HandleStale)
+{
+	//殘留的 socket 文件 無人 監聽 被 刪除 後 重新 綁定
+	std::remove(PATH);
+	{
+		kg::net::io_service_t service;
+		protocol_t::acceptor acceptor(service,protocol_t::endpoint(PATH));
+	}
+	ASSERT_TRUE(exists(PATH));
+
+	server_t s(ADDRESS,1,0);
+	echo(s);
+	s.run();
+	kg::net::echo_client_t c(4);
+	c.connect(ADDRESS);
+	EXPECT_EQ(call(c.get(),"king"),"king");
+
+	//正在 使用的 地址 不會 被 搶佔
+	boost::system::error_code ec;
+	server_t other(ADDRESS,1,0,ec);
+	EXPECT_EQ(ec,boost::asio::error::address_in_use);
+	EXPECT_EQ(call(c.get(),"cerberus"),"cerberus");
+	s.stop();
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
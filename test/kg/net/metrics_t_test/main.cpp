@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <kg/net/metrics.hpp>
+
+TEST(TypeHistogram, HandleIndex)
+{
+	typedef kg::net::histogram_snapshot_t snapshot_t;
+
+	//小值 一個值 一個桶
+	for(kg::uint64_t v=0; v<8; ++v)
+	{
+		EXPECT_EQ(snapshot_t::index(v),v);
+		EXPECT_EQ(snapshot_t::upper_bound(v),v);
+	}
+
+	//每個值 都在 其桶的 上界內 並大於 前一個桶的 上界
+	for(kg::uint64_t v=8; v<100000; v += 7)
+	{
+		std::size_t i = snapshot_t::index(v);
+		EXPECT_LE(v,snapshot_t::upper_bound(i));
+		EXPECT_GT(v,snapshot_t::upper_bound(i-1));
+	}
+
+	//最大值
+	EXPECT_LT(snapshot_t::index(~kg::uint64_t(0)),std::size_t(KG_NET_HISTOGRAM_BUCKETS));
+}
+TEST(TypeHistogram, HandlePercentile)
+{
+	kg::net::histogram_t h;
+	for(kg::uint64_t v=1; v<=1000; ++v)
+	{
+		h.record(v);
+	}
+
+	kg::net::histogram_snapshot_t s;
+	h.snapshot(s);
+	EXPECT_EQ(s.count,1000);
+	EXPECT_EQ(s.max,1000);
+	EXPECT_EQ(s.sum,500500);
+
+	//相對誤差 不超過 12.5%
+	kg::uint64_t p50 = s.percentile(50);
+	EXPECT_GE(p50,500);
+	EXPECT_LE(p50,500 * 1.125);
+	kg::uint64_t p99 = s.percentile(99);
+	EXPECT_GE(p99,990);
+	EXPECT_LE(p99,1000);
+	EXPECT_EQ(s.percentile(100),1000);
+
+	//合併
+	kg::net::histogram_snapshot_t total;
+	total += s;
+	total += s;
+	EXPECT_EQ(total.count,2000);
+	EXPECT_EQ(total.percentile(50),p50);
+}
+TEST(TypeMetrics, HandleSnapshot)
+{
+	kg::net::service_metrics_t m;
+	m.accepts.add();
+	m.reads.add(3);
+	m.bytes_in.add(100);
+	m.latency.record(10);
+
+	kg::net::metrics_snapshot_t s;
+	m.snapshot(s,1);
+	EXPECT_EQ(s.accepts,1);
+	EXPECT_EQ(s.active,1);
+	EXPECT_EQ(s.reads,3);
+	EXPECT_EQ(s.bytes_in,100);
+	EXPECT_EQ(s.latency.count,1);
+
+	kg::net::metrics_snapshot_t prev = s;
+	prev.reads = 0;
+	prev.time -= std::chrono::seconds(1);
+	EXPECT_NEAR(s.reads_per_second(prev),3,0.01);
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
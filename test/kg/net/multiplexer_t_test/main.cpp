@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <boost/thread.hpp>
+#include <kg/net/multiplexer.hpp>
+#define ADDRESS "127.0.0.1:1134"
+#define PORT 1134
+#define THREADS 4
+
+//在 獨立 線程 上 同步 接受 一個 連接 的 回環 服務器
+class loopback_t
+{
+public:
+	kg::net::io_service_t service;
+	kg::net::acceptor_t acceptor;
+	kg::net::socket_t socket;
+	boost::thread thread;
+	loopback_t()
+		:acceptor(service,kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT)),socket(service)
+	{
+	}
+	template<typename F>
+	void run(F f)
+	{
+		thread = boost::thread([this,f]()
+		{
+			acceptor.accept(socket);
+			try
+			{
+				f(socket);
+			}
+			catch(const boost::system::system_error&)
+			{
+			}
+		});
+	}
+	~loopback_t()
+	{
+		thread.join();
+	}
+};
+//讀取 u32 大端 長度前綴 的 幀 返回 關聯 id 與 消息體
+std::string read_frame(kg::net::socket_t& s)
+{
+	kg::byte_t header[4];
+	boost::asio::read(s,boost::asio::buffer(header));
+	std::string body((std::size_t(header[0]) << 24) | (std::size_t(header[1]) << 16) | (std::size_t(header[2]) << 8) | std::size_t(header[3]),0);
+	boost::asio::read(s,boost::asio::buffer(&body[0],body.size()));
+	return body;
+}
+void write_frame(kg::net::socket_t& s,const std::string& body)
+{
+	std::string frame(4,0);
+	frame[0] = char(body.size() >> 24);
+	frame[1] = char(body.size() >> 16);
+	frame[2] = char(body.size() >> 8);
+	frame[3] = char(body.size());
+	frame += body;
+	boost::asio::write(s,boost::asio::buffer(frame));
+}
+std::string to_string(const kg::net::multiplexer_t::bytes_t& b)
+{
+	return std::string((const char*)b.get(),b.size());
+}
+void sleep(kg::net::io_service_t& service,const boost::asio::yield_context& ctx,std::size_t ms)
+{
+	kg::net::deadline_timer_t timer(service);
+	timer.expires_from_now(boost::posix_time::milliseconds(ms));
+	boost::system::error_code ec;
+	timer.async_wait(ctx[ec]);
+}
+//在 多個 線程 上 運行 直到 沒有 任務
+void run(kg::net::io_service_t& service)
+{
+	boost::thread_group threads;
+	for(int i=0;i<THREADS;++i)
+	{
+		threads.create_thread(boost::bind(&kg::net::io_service_t::run,&service));
+	}
+	threads.join_all();
+}
+
+TEST(TypeMultiplexer, HandleOutOfOrder)
+{
+	loopback_t server;
+	server.run([](kg::net::socket_t& s)
+	{
+		//收齊 後 逆序 響應
+		std::vector<std::string> requests;
+		for(int i=0;i<8;++i)
+		{
+			requests.push_back(read_frame(s));
+		}
+		for(std::size_t i=requests.size();i>0;--i)
+		{
+			const std::string& request = requests[i - 1];
+			write_frame(s,request.substr(0,4) + "r:" + request.substr(4));
+		}
+		read_frame(s);
+	});
+
+	kg::net::io_service_t service;
+	kg::net::multiplexer_spt mux = boost::make_shared<kg::net::multiplexer_t>(boost::ref(service));
+	boost::mutex mutex;
+	std::vector<std::string> responses(8);
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		mux->connect(ADDRESS,ctx);
+		for(int i=0;i<8;++i)
+		{
+			boost::asio::spawn(service,[&,i](boost::asio::yield_context ctx)
+			{
+				std::string str(i + 1,char('a' + i));
+				std::string response = to_string(mux->call((const kg::byte_t*)str.data(),str.size(),ctx));
+				boost::mutex::scoped_lock lock(mutex);
+				responses[i] = response;
+				if(std::count(responses.begin(),responses.end(),std::string()) == 0)
+				{
+					mux->close();
+				}
+			});
+		}
+	});
+	run(service);
+
+	for(int i=0;i<8;++i)
+	{
+		EXPECT_EQ(responses[i],"r:" + std::string(i + 1,char('a' + i)));
+	}
+	EXPECT_EQ(mux->pending(),0);
+}
+TEST(TypeMultiplexer, HandleTimeout)
+{
+	loopback_t server;
+	server.run([](kg::net::socket_t& s)
+	{
+		//第一個 響應 晚於 超時
+		std::string request = read_frame(s);
+		boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+		write_frame(s,request);
+		request = read_frame(s);
+		write_frame(s,request);
+		read_frame(s);
+	});
+
+	kg::net::io_service_t service;
+	kg::net::multiplexer_spt mux = boost::make_shared<kg::net::multiplexer_t>(boost::ref(service));
+	boost::system::error_code timeout;
+	std::size_t pending = 1;
+	std::string response;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		mux->connect(ADDRESS,ctx);
+		mux->call((const kg::byte_t*)"late",4,ctx,50,timeout);
+		pending = mux->pending();
+
+		//遲到的 響應 被 丟棄 不會 交給 下一個 請求
+		sleep(service,ctx,300);
+		response = to_string(mux->call((const kg::byte_t*)"next",4,ctx,1000));
+		mux->close();
+	});
+	run(service);
+
+	EXPECT_EQ(timeout,boost::asio::error::timed_out);
+	EXPECT_EQ(pending,0);
+	EXPECT_EQ(response,"next");
+}
+TEST(TypeMultiplexer, HandleBroken)
+{
+	loopback_t server;
+	server.run([](kg::net::socket_t& s)
+	{
+		//收到 請求 後 不響應 直接 關閉
+		for(int i=0;i<4;++i)
+		{
+			read_frame(s);
+		}
+		s.close();
+	});
+
+	kg::net::io_service_t service;
+	kg::net::multiplexer_spt mux = boost::make_shared<kg::net::multiplexer_t>(boost::ref(service));
+	boost::atomic<int> failed(0);
+	boost::atomic<int> timeouts(0);
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		mux->connect(ADDRESS,ctx);
+		for(int i=0;i<4;++i)
+		{
+			boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+			{
+				boost::system::error_code ec;
+				mux->call((const kg::byte_t*)"x",1,ctx,5000,ec);
+				if(ec == boost::asio::error::timed_out)
+				{
+					++timeouts;
+				}
+				else if(ec)
+				{
+					++failed;
+				}
+			});
+		}
+	});
+	run(service);
+
+	EXPECT_EQ(failed,4);
+	EXPECT_EQ(timeouts,0);
+	EXPECT_EQ(mux->pending(),0);
+}
+TEST(TypeMultiplexer, HandleCallAfterError)
+{
+	loopback_t server;
+	server.run([](kg::net::socket_t& s)
+	{
+		s.close();
+	});
+
+	kg::net::io_service_t service;
+	kg::net::multiplexer_spt mux = boost::make_shared<kg::net::multiplexer_t>(boost::ref(service));
+	bool thrown = false;
+	boost::system::error_code ec;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		mux->connect(ADDRESS,ctx);
+		//等待 讀取 協程 發現 對端 關閉
+		sleep(service,ctx,100);
+		try
+		{
+			mux->call((const kg::byte_t*)"x",1,ctx,1000);
+		}
+		catch(const boost::system::system_error& e)
+		{
+			thrown = true;
+			ec = e.code();
+		}
+	});
+	run(service);
+
+	EXPECT_TRUE(thrown);
+	EXPECT_TRUE(ec);
+	EXPECT_NE(ec,boost::asio::error::timed_out);
+	EXPECT_EQ(mux->pending(),0);
+}
+TEST(TypeMultiplexer, HandleBackpressure)
+{
+	//請求 總量 超過 發送隊列 高水位 服務器 慢速 讀取
+	const int count = 16;
+	const std::size_t size = 256 * 1024;
+	loopback_t server;
+	server.run([&](kg::net::socket_t& s)
+	{
+		for(int i=0;i<count;++i)
+		{
+			boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+			write_frame(s,read_frame(s));
+		}
+		read_frame(s);
+	});
+
+	kg::net::io_service_t service;
+	kg::net::multiplexer_spt mux = boost::make_shared<kg::net::multiplexer_t>(boost::ref(service));
+	boost::atomic<int> ok(0);
+	boost::atomic<int> done(0);
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx)
+	{
+		mux->connect(ADDRESS,ctx);
+		for(int i=0;i<count;++i)
+		{
+			boost::asio::spawn(service,[&,i](boost::asio::yield_context ctx)
+			{
+				std::string str(size,char('a' + i));
+				boost::system::error_code ec;
+				kg::net::multiplexer_t::bytes_t b = mux->call((const kg::byte_t*)str.data(),str.size(),ctx,0,ec);
+				if(!ec && to_string(b) == str)
+				{
+					++ok;
+				}
+				if(++done == count)
+				{
+					mux->close();
+				}
+			});
+		}
+	});
+	run(service);
+
+	EXPECT_EQ(ok,count);
+	EXPECT_EQ(mux->pending(),0);
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
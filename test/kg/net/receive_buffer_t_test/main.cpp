@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <kg/net/receive_buffer.hpp>
+
+void write(kg::net::receive_buffer_t& buffer,const std::string& str)
+{
+	boost::asio::mutable_buffers_1 b = buffer.prepare(str.size());
+	ASSERT_GE(boost::asio::buffer_size(b),str.size());
+	memcpy(boost::asio::buffer_cast<kg::byte_t*>(b),str.data(),str.size());
+	buffer.commit(str.size());
+}
+TEST(TypeReceiveBuffer, HandlePrepareCommit)
+{
+	kg::net::receive_buffer_t buffer(8);
+	EXPECT_EQ(buffer.size(),0);
+	EXPECT_GE(boost::asio::buffer_size(buffer.prepare()),8);
+
+	write(buffer,"kingcerb");
+	EXPECT_EQ(buffer.size(),8);
+	EXPECT_EQ(std::string((const char*)buffer.data(),4),"king");
+	buffer.consume(4);
+	EXPECT_EQ(std::string((const char*)buffer.data(),4),"cerb");
+
+	//空間 不足 時 只 拷貝 未讀取的 數據
+	write(buffer,"erus");
+	EXPECT_EQ(std::string((const char*)buffer.data(),buffer.size()),"cerberus");
+
+	//未被 引用 時 讀完 後 重用 內存
+	kg::byte_t* storage = buffer.data();
+	buffer.consume(8);
+	EXPECT_EQ(buffer.size(),0);
+	write(buffer,"king");
+	EXPECT_EQ(buffer.data(),storage);
+	buffer.consume(4);
+
+	//需要 更多 空間 時 一次 準備 足夠
+	EXPECT_GE(boost::asio::buffer_size(buffer.prepare(100)),100);
+}
+TEST(TypeReceiveBuffer, HandleSlice)
+{
+	kg::net::receive_buffer_t buffer(8);
+	write(buffer,"kingcerb");
+	kg::net::receive_buffer_t::bytes_t king = buffer.slice(4);
+	//切片 引用 緩衝區 內存
+	EXPECT_EQ(king.get() + 4,buffer.data());
+
+	//被 引用的 內存 不會 被 覆蓋
+	buffer.consume(4);
+	write(buffer,"is an idea");
+	write(buffer,"0123456789abcdef");
+	EXPECT_EQ(std::string((const char*)king.get(),king.size()),"king");
+	EXPECT_EQ(std::string((const char*)buffer.data(),buffer.size()),"is an idea0123456789abcdef");
+
+	kg::net::receive_buffer_t::bytes_t is = buffer.slice(2);
+	EXPECT_EQ(std::string((const char*)is.get(),is.size()),"is");
+	buffer.consume(buffer.size());
+	write(buffer,"zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz");
+	EXPECT_EQ(std::string((const char*)is.get(),is.size()),"is");
+	EXPECT_EQ(std::string((const char*)king.get(),king.size()),"king");
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+#include <kg/net/session_table.hpp>
+
+TEST(TypeSessionTable, HandleInsertErase)
+{
+	kg::net::session_table_t<int> table(4,4);
+	int v = 0;
+	EXPECT_FALSE(table.find(1,v));
+
+	//超過 初始容量 觸發 擴容
+	for(kg::uint64_t id=1; id<=1000; ++id)
+	{
+		table.insert(id,int(id * 2));
+	}
+	EXPECT_EQ(table.size(),1000);
+	for(kg::uint64_t id=1; id<=1000; ++id)
+	{
+		ASSERT_TRUE(table.find(id,v));
+		EXPECT_EQ(v,int(id * 2));
+	}
+	EXPECT_FALSE(table.find(1001,v));
+
+	//刪除 一半 其它 仍可 找到
+	for(kg::uint64_t id=1; id<=1000; id += 2)
+	{
+		EXPECT_TRUE(table.erase(id));
+	}
+	EXPECT_FALSE(table.erase(1));
+	EXPECT_EQ(table.size(),500);
+	for(kg::uint64_t id=1; id<=1000; ++id)
+	{
+		EXPECT_EQ(table.find(id,v),id % 2 == 0);
+	}
+
+	//反覆 插入 刪除 刪除標記 不會 無限 累積
+	for(kg::uint64_t id=2000; id<200000; ++id)
+	{
+		table.insert(id,1);
+		table.erase(id);
+	}
+	EXPECT_EQ(table.size(),500);
+	EXPECT_TRUE(table.find(1000,v));
+}
+TEST(TypeSessionTable, HandleConcurrentFind)
+{
+	typedef boost::shared_ptr<kg::uint64_t> value_t;
+	kg::net::session_table_t<value_t> table(8);
+	boost::atomic<bool> stop(false);
+	boost::atomic<std::size_t> errors(0);
+
+	//讀者 查找 時 寫者 不斷 插入 刪除
+	boost::thread_group readers;
+	for(int i=0; i<3; ++i)
+	{
+		readers.create_thread([&]()
+		{
+			value_t v;
+			while(!stop)
+			{
+				for(kg::uint64_t id=0; id<4096; ++id)
+				{
+					if(table.find(id,v) && *v != id)
+					{
+						++errors;
+					}
+				}
+			}
+		});
+	}
+	for(int n=0; n<50; ++n)
+	{
+		for(kg::uint64_t id=0; id<4096; ++id)
+		{
+			table.insert(id,value_t(new kg::uint64_t(id)));
+		}
+		for(kg::uint64_t id=0; id<4096; ++id)
+		{
+			table.erase(id);
+		}
+	}
+	stop = true;
+	readers.join_all();
+	EXPECT_EQ(errors,0);
+	EXPECT_EQ(table.size(),0);
+}
+//拷貝 較慢 使 讀者 在 find 中 停留 較久
+class slow_t
+{
+public:
+	boost::shared_ptr<kg::uint64_t> value;
+	slow_t()
+	{
+	}
+	explicit slow_t(const boost::shared_ptr<kg::uint64_t>& value)
+		:value(value)
+	{
+	}
+	slow_t& operator=(const slow_t& other)
+	{
+		boost::this_thread::sleep(boost::posix_time::microseconds(200));
+		value = other.value;
+		return *this;
+	}
+};
+TEST(TypeSessionTable, HandleReclaimUnderLoad)
+{
+	kg::net::session_table_t<slow_t> table(1);
+	boost::atomic<bool> stop(false);
+	table.insert(0,slow_t());
+
+	//讀者 重疊 查找 分片 讀者計數 幾乎 不會 歸零
+	boost::thread_group readers;
+	for(int i=0; i<4; ++i)
+	{
+		readers.create_thread([&]()
+		{
+			slow_t v;
+			while(!stop)
+			{
+				table.find(0,v);
+			}
+		});
+	}
+	boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+
+	//被 移除的 條目 在 之後 的 寫入 中 被 釋放
+	boost::shared_ptr<kg::uint64_t> value(new kg::uint64_t(1));
+	boost::weak_ptr<kg::uint64_t> weak(value);
+	table.insert(1,slow_t(value));
+	value.reset();
+	table.erase(1);
+	for(kg::uint64_t id=2; id<200 && !weak.expired(); ++id)
+	{
+		boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+		table.insert(id,slow_t());
+		table.erase(id);
+	}
+	const bool expired = weak.expired();
+	stop = true;
+	readers.join_all();
+	EXPECT_TRUE(expired);
+	EXPECT_EQ(table.size(),1);
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <boost/thread.hpp>
+#include <kg/net/basic_server.hpp>
+#include <kg/net/echo_client.hpp>
+#define ADDRESS "127.0.0.1:1140"
+#define PORT 1140
+typedef int session_t;
+typedef kg::net::basic_server_t<session_t> server_t;
+typedef boost::asio::detail::socket_option::integer<IPPROTO_TCP,TCP_KEEPIDLE> keep_idle_t;
+typedef boost::asio::detail::socket_option::integer<IPPROTO_TCP,TCP_KEEPINTVL> keep_interval_t;
+typedef boost::asio::detail::socket_option::integer<IPPROTO_TCP,TCP_KEEPCNT> keep_count_t;
+typedef boost::asio::detail::socket_option::integer<IPPROTO_TCP,TCP_DEFER_ACCEPT> defer_accept_t;
+
+kg::net::endpoint_t endpoint()
+{
+	return kg::net::endpoint_t(boost::asio::ip::address::from_string("127.0.0.1"),PORT);
+}
+kg::net::socket_options_t tuned()
+{
+	kg::net::socket_options_t options;
+	options.no_delay = true;
+	options.recv_buffer = 256 * 1024;
+	options.send_buffer = 256 * 1024;
+	options.quick_ack = true;
+	options.keep_alive = true;
+	options.keep_idle = 30;
+	options.keep_interval = 5;
+	options.keep_count = 3;
+	return options;
+}
+//檢查 tuned 的 選項 已 設置到 s
+void expect_tuned(kg::net::socket_t& s)
+{
+	boost::asio::ip::tcp::no_delay no_delay;
+	s.get_option(no_delay);
+	EXPECT_TRUE(no_delay.value());
+	boost::asio::socket_base::keep_alive keep_alive;
+	s.get_option(keep_alive);
+	EXPECT_TRUE(keep_alive.value());
+	keep_idle_t idle;
+	s.get_option(idle);
+	EXPECT_EQ(idle.value(),30);
+	keep_interval_t interval;
+	s.get_option(interval);
+	EXPECT_EQ(interval.value(),5);
+	keep_count_t count;
+	s.get_option(count);
+	EXPECT_EQ(count.value(),3);
+	//linux 返回 設置值 的 兩倍
+	boost::asio::socket_base::receive_buffer_size recv;
+	s.get_option(recv);
+	EXPECT_GE(recv.value(),256 * 1024);
+	boost::asio::socket_base::send_buffer_size send;
+	s.get_option(send);
+	EXPECT_GE(send.value(),256 * 1024);
+}
+TEST(TypeSocketOptions, HandleDefault)
+{
+	kg::net::socket_options_t options;
+	EXPECT_EQ(options.listen_backlog(),int(boost::asio::socket_base::max_listen_connections));
+	options.backlog = 16;
+	EXPECT_EQ(options.listen_backlog(),16);
+
+	//默認 不 改變 socket
+	kg::net::io_service_t service;
+	kg::net::acceptor_t acceptor(service,endpoint());
+	kg::net::socket_t c(service);
+	c.connect(endpoint());
+	options.apply(c);
+	boost::asio::ip::tcp::no_delay no_delay;
+	c.get_option(no_delay);
+	EXPECT_FALSE(no_delay.value());
+	boost::asio::socket_base::keep_alive keep_alive;
+	c.get_option(keep_alive);
+	EXPECT_FALSE(keep_alive.value());
+}
+TEST(TypeSocketOptions, HandleApply)
+{
+	kg::net::io_service_t service;
+	kg::net::acceptor_t acceptor(service);
+	acceptor.open(endpoint().protocol());
+	acceptor.set_option(kg::net::acceptor_t::reuse_address(true));
+	kg::net::socket_options_t options = tuned();
+	options.defer_accept = 7;
+	options.apply(acceptor);
+	acceptor.bind(endpoint());
+	acceptor.listen(options.listen_backlog());
+	defer_accept_t defer;
+	acceptor.get_option(defer);
+	EXPECT_GT(defer.value(),0);
+
+	kg::net::socket_t c(service);
+	c.connect(endpoint());
+	options.apply(c);
+	expect_tuned(c);
+}
+TEST(TypeSocketOptions, HandleServer)
+{
+	kg::net::basic_server_options_t options;
+	options.threads = 1;
+	options.socket = tuned();
+	server_t s(ADDRESS,1,0,options);
+	boost::mutex mutex;
+	int checked = 0;
+	//accept 的 連接 在 connected 回調 之前 已 設置 選項
+	s.connected([&](const kg::net::connection_spt& c,session_t&,const boost::asio::yield_context&){
+		expect_tuned(*c);
+		boost::mutex::scoped_lock lock(mutex);
+		++checked;
+		return true;
+	});
+	s.run();
+
+	kg::net::io_service_t service;
+	kg::net::socket_t c(service);
+	c.connect(endpoint());
+	for(int i=0;i<300;++i)
+	{
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			if(checked)
+			{
+				break;
+			}
+		}
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+	s.stop();
+	EXPECT_EQ(checked,1);
+}
+TEST(TypeSocketOptions, HandleClient)
+{
+	kg::net::io_service_t service;
+	kg::net::acceptor_t acceptor(service,endpoint());
+
+	//connect 之後 設置 選項
+	kg::net::echo_client_t c(4);
+	c.options(tuned());
+	c.connect(ADDRESS);
+	expect_tuned(c.get());
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <kg/net/stage.hpp>
+
+//按 相反 順序 編碼 再 按 加入 順序 解碼
+std::string round_trip(std::vector<kg::net::stage_spt>& stages,const std::string& str,std::size_t& encoded)
+{
+	kg::net::view_t view((kg::byte_t*)str.data(),str.size());
+	for(std::size_t i=stages.size();i>0;--i)
+	{
+		EXPECT_TRUE(stages[i - 1]->encode(view,4));
+		EXPECT_GE(view.headroom,4);
+	}
+	encoded = view.size;
+
+	//模擬 接收 緩衝區 解碼 不擁有 內存
+	std::vector<kg::byte_t> received(view.data,view.data + view.size);
+	kg::net::view_t in(received.data(),received.size());
+	for(std::size_t i=0;i<stages.size();++i)
+	{
+		EXPECT_TRUE(stages[i]->decode(in));
+	}
+	return std::string((const char*)in.data,in.size);
+}
+TEST(TypeStage, HandleCrypto)
+{
+	std::vector<kg::net::stage_spt> stages;
+	stages.push_back(boost::make_shared<kg::net::crypto_stage_t>(9));
+	std::string str = "cerberus is an idea";
+	std::size_t encoded = 0;
+	EXPECT_EQ(round_trip(stages,str,encoded),str);
+	EXPECT_EQ(encoded,str.size() + 3);
+
+	//有 足夠 headroom 時 原地 加密
+	boost::shared_array<kg::byte_t> owner(new kg::byte_t[8 + str.size()]);
+	memcpy(owner.get() + 8,str.data(),str.size());
+	kg::net::view_t view(owner.get() + 8,str.size(),8,owner);
+	ASSERT_TRUE(stages[0]->encode(view,4));
+	EXPECT_EQ(view.owner.get(),owner.get());
+	EXPECT_EQ(view.data,owner.get() + 5);
+	EXPECT_EQ(view.headroom,5);
+
+	//原地 解密
+	kg::byte_t* data = view.data;
+	ASSERT_TRUE(stages[0]->decode(view));
+	EXPECT_EQ(view.data,data + 3);
+	EXPECT_EQ(std::string((const char*)view.data,view.size),str);
+
+	kg::net::view_t bad(data,2);
+	EXPECT_FALSE(stages[0]->decode(bad));
+}
+TEST(TypeStage, HandleChain)
+{
+	std::vector<kg::net::stage_spt> stages;
+	stages.push_back(boost::make_shared<kg::net::crypto_stage_t>(9));
+	stages.push_back(boost::make_shared<kg::net::compress_stage_t>(64));
+
+	std::string str;
+	for(int i=0; i<500; ++i)
+	{
+		str += "i'm king ";
+	}
+	std::size_t encoded = 0;
+	EXPECT_EQ(round_trip(stages,str,encoded),str);
+	EXPECT_LT(encoded,str.size() / 10);
+
+	//小於 閾值 不壓縮 解碼 直接 指向 原數據
+	str = "king";
+	EXPECT_EQ(round_trip(stages,str,encoded),str);
+	EXPECT_EQ(encoded,str.size() + 1 + 3);
+
+	//不壓縮 時 有 足夠 headroom 原地 加上 標記
+	boost::shared_array<kg::byte_t> owner(new kg::byte_t[8 + str.size()]);
+	memcpy(owner.get() + 8,str.data(),str.size());
+	kg::net::view_t view(owner.get() + 8,str.size(),8,owner);
+	ASSERT_TRUE(stages[1]->encode(view,4));
+	EXPECT_EQ(view.owner.get(),owner.get());
+	EXPECT_EQ(view.data,owner.get() + 7);
+	EXPECT_EQ(view.size,str.size() + 1);
+	EXPECT_EQ(view.data[0],KG_NET_COMPRESS_FLAG_RAW);
+}
+
+TEST(TypeStage, HandleLimit)
+{
+	kg::net::compress_stage_t stage(64);
+	std::string str(4096,'a');
+	kg::net::view_t view((kg::byte_t*)str.data(),str.size());
+	ASSERT_TRUE(stage.encode(view,0));
+	std::vector<kg::byte_t> received(view.data,view.data + view.size);
+
+	//解壓後 長度 超過 limit
+	kg::net::view_t in(received.data(),received.size());
+	in.limit = 1024;
+	EXPECT_FALSE(stage.decode(in));
+
+	in = kg::net::view_t(received.data(),received.size());
+	in.limit = 4096;
+	ASSERT_TRUE(stage.decode(in));
+	EXPECT_EQ(std::string((const char*)in.data,in.size),str);
+	EXPECT_EQ(in.limit,4096);
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <stdexcept>
+#include <kg/net/task_pool.hpp>
+
+TEST(TypeTaskPool, HandleCall)
+{
+	kg::net::task_pool_t pool(2,0);
+	kg::net::io_service_t service;
+	const boost::thread::id id = boost::this_thread::get_id();
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx){
+		//在 線程池 中 執行 回到 協程 所屬 線程 恢復
+		std::string str = pool.call([&]{
+			EXPECT_NE(boost::this_thread::get_id(),id);
+			return std::string("kate");
+		},ctx);
+		EXPECT_EQ(boost::this_thread::get_id(),id);
+		EXPECT_EQ(str,"kate");
+
+		bool called = false;
+		pool.call([&]{
+			called = true;
+		},ctx);
+		EXPECT_TRUE(called);
+
+		//異常 在 協程中 重新 拋出
+		EXPECT_THROW(pool.call([]()->int{
+			throw std::runtime_error("anita");
+		},ctx),std::runtime_error);
+		EXPECT_EQ(pool.pending(),0);
+	});
+	service.run();
+}
+TEST(TypeTaskPool, HandleBusy)
+{
+	kg::net::task_pool_t pool(1,1);
+	kg::net::io_service_t service;
+	boost::mutex mutex;
+	boost::mutex::scoped_lock lock(mutex);
+	int busy = 0;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx){
+		pool.call([&]{
+			boost::mutex::scoped_lock lock(mutex);
+		},ctx);
+	});
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx){
+		//任務數 已達 上限
+		try
+		{
+			pool.call([]{},ctx);
+		}
+		catch(const boost::system::system_error& e)
+		{
+			EXPECT_EQ(e.code().value(),KG_NET_TASK_POOL_CODE_BUSY);
+			++busy;
+		}
+		lock.unlock();
+	});
+	service.run();
+	EXPECT_EQ(busy,1);
+}
+TEST(TypeTaskPool, HandleStopped)
+{
+	kg::net::task_pool_t pool(1,0);
+	pool.stop();
+
+	//停止 後 拒絕 任務 而不是 永遠 掛起
+	kg::net::io_service_t service;
+	int stopped = 0;
+	boost::asio::spawn(service,[&](boost::asio::yield_context ctx){
+		try
+		{
+			pool.call([]{},ctx);
+		}
+		catch(const boost::system::system_error& e)
+		{
+			EXPECT_EQ(e.code().value(),KG_NET_TASK_POOL_CODE_STOPPED);
+			++stopped;
+		}
+	});
+	service.run();
+	EXPECT_EQ(stopped,1);
+	EXPECT_EQ(pool.pending(),0);
+}
+TEST(TypeTaskPool, HandleConcurrentStop)
+{
+	//與 stop 併發 的 call 要麼 完成 要麼 拋出 STOPPED
+	for(int i=0;i<50;++i)
+	{
+		kg::net::task_pool_t pool(2,0);
+		kg::net::io_service_t service;
+		boost::atomic<int> done(0);
+		for(int j=0;j<8;++j)
+		{
+			boost::asio::spawn(service,[&](boost::asio::yield_context ctx){
+				for(int k=0;k<20;++k)
+				{
+					try
+					{
+						pool.call([]{},ctx);
+					}
+					catch(const boost::system::system_error& e)
+					{
+						EXPECT_EQ(e.code().value(),KG_NET_TASK_POOL_CODE_STOPPED);
+					}
+				}
+				++done;
+			});
+		}
+		boost::thread thread(boost::bind(&kg::net::io_service_t::run,&service));
+		pool.stop();
+		thread.join();
+		EXPECT_EQ(done,8);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}